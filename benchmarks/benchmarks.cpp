@@ -0,0 +1,55 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "benchmarks.h"
+
+#include <cstring>
+#include <fmt/format.h>
+
+namespace hg {
+namespace bench {
+
+void Report(const char *name, time_ns t, size_t op_count) {
+	fmt::print("  {:<40} {:>10.3f} ms {:>10.1f} ns/op\n", name, time_to_ms_f(t), op_count ? double(t) / double(op_count) : 0.0);
+}
+
+} // namespace bench
+} // namespace hg
+
+// foundation benchmarks
+extern void bench_vector_list();
+
+// engine benchmarks
+extern void bench_resource_cache();
+extern void bench_scene_nodes();
+extern void bench_scene_side_maps();
+
+struct Benchmark {
+	const char *name;
+	void (*func)();
+};
+
+static const Benchmark benchmark_list[] = {
+	{"foundation.vector_list", bench_vector_list},
+
+	{"engine.resource_cache", bench_resource_cache},
+	{"engine.scene_nodes", bench_scene_nodes},
+	{"engine.scene_side_maps", bench_scene_side_maps},
+
+	{NULL, NULL},
+};
+
+// run all benchmarks or only those which name starts with one of the arguments
+int main(int narg, const char **args) {
+	for (const Benchmark *b = benchmark_list; b->name; ++b) {
+		bool run = narg < 2;
+		for (int i = 1; i < narg; ++i)
+			if (strncmp(b->name, args[i], strlen(args[i])) == 0)
+				run = true;
+
+		if (run) {
+			fmt::print("{}\n", b->name);
+			b->func();
+		}
+	}
+	return 0;
+}
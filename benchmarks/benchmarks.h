@@ -0,0 +1,19 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/time.h"
+
+#include <cstddef>
+
+namespace hg {
+namespace bench {
+
+/// Number of runs per measure, the fastest run is reported.
+static const int RunCount = 5;
+
+/// Report the duration of a measure performing `op_count` operations.
+void Report(const char *name, time_ns t, size_t op_count);
+
+} // namespace bench
+} // namespace hg
@@ -0,0 +1,133 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "../benchmarks.h"
+
+#include "foundation/math.h"
+#include "foundation/rand.h"
+
+#include "engine/resource_cache.h"
+
+#include <fmt/format.h>
+#include <limits>
+#include <map>
+
+using namespace hg;
+
+static const size_t name_count = 100000;
+
+typedef ResourceRef<int> IntRef;
+
+static void DestroyInt(int &) {}
+
+static size_t sink = 0; // prevent the compiler from optimizing the lookup loops out
+
+// name lookup as done by ResourceCache before it used a hash table
+struct MapNames {
+	std::map<const std::string, IntRef> name_to_ref;
+	uint32_t next;
+
+	MapNames() : next(0) {}
+
+	IntRef Add(const std::string &name) {
+		std::map<const std::string, IntRef>::iterator i = name_to_ref.find(name);
+		if (i != name_to_ref.end())
+			return i->second;
+		IntRef ref;
+		ref.ref.idx = next++;
+		ref.ref.gen = 0;
+		name_to_ref[name] = ref;
+		return ref;
+	}
+
+	IntRef Has(const std::string &name) const {
+		std::map<const std::string, IntRef>::const_iterator i = name_to_ref.find(name);
+		return i != name_to_ref.end() ? i->second : IntRef();
+	}
+
+	void Destroy(const std::string &name, IntRef) { name_to_ref.erase(name); }
+};
+
+struct CacheNames {
+	ResourceCache<int> cache;
+
+	CacheNames() : cache(DestroyInt) {}
+
+	IntRef Add(const std::string &name) { return cache.Add(name, 0); }
+	IntRef Has(const std::string &name) const { return cache.Has(name); }
+	void Destroy(const std::string &, IntRef ref) { cache.Destroy(ref); }
+};
+
+struct Measures {
+	Measures() { add = add_existing = hit = miss = remove = std::numeric_limits<time_ns>::max(); }
+	time_ns add, add_existing, hit, miss, remove;
+};
+
+template <typename T> static time_ns Lookup(const T &names, const std::vector<std::string> &keys) {
+	const time_ns t = time_now();
+	size_t found = 0;
+	for (std::vector<std::string>::const_iterator i = keys.begin(); i != keys.end(); ++i)
+		found += names.Has(*i).ref.idx;
+	sink += found;
+	return time_now() - t;
+}
+
+template <typename T> static void Measure(Measures &m, const std::vector<std::string> &keys, const std::vector<std::string> &missing) {
+	T names;
+	std::vector<IntRef> refs(keys.size());
+
+	{
+		const time_ns t = time_now();
+		for (size_t i = 0; i < keys.size(); ++i)
+			refs[i] = names.Add(keys[i]);
+		m.add = Min(m.add, time_now() - t);
+	}
+
+	{
+		const time_ns t = time_now();
+		for (size_t i = 0; i < keys.size(); ++i)
+			sink += names.Add(keys[i]).ref.idx;
+		m.add_existing = Min(m.add_existing, time_now() - t);
+	}
+
+	m.hit = Min(m.hit, Lookup(names, keys));
+	m.miss = Min(m.miss, Lookup(names, missing));
+
+	{
+		const time_ns t = time_now();
+		for (size_t i = 0; i < keys.size(); ++i)
+			names.Destroy(keys[i], refs[i]);
+		m.remove = Min(m.remove, time_now() - t);
+	}
+}
+
+static void Report(const char *name, const Measures &m) {
+	fmt::print(" {}\n", name);
+	bench::Report("add", m.add, name_count);
+	bench::Report("add (duplicate name)", m.add_existing, name_count);
+	bench::Report("lookup (hit, random order)", m.hit, name_count);
+	bench::Report("lookup (miss)", m.miss, name_count);
+	bench::Report("remove (random order)", m.remove, name_count);
+}
+
+void bench_resource_cache() {
+	// resource names share long common prefixes, as asset paths do
+	std::vector<std::string> keys(name_count), missing(name_count);
+	for (size_t i = 0; i < name_count; ++i) {
+		keys[i] = fmt::format("assets/levels/level_{}/textures/texture_{}.png", i % 16, i);
+		missing[i] = fmt::format("assets/levels/level_{}/textures/texture_{}.dds", i % 16, i);
+	}
+
+	Measures map_m, cache_m;
+
+	for (int run = 0; run < bench::RunCount; ++run) {
+		Seed(run);
+		for (size_t i = name_count - 1; i > 0; --i)
+			std::swap(keys[i], keys[Rand(uint32_t(i + 1))]);
+
+		Measure<MapNames>(map_m, keys, missing);
+		Measure<CacheNames>(cache_m, keys, missing);
+	}
+
+	Report("std::map", map_m);
+	Report("ResourceCache", cache_m);
+}
@@ -0,0 +1,71 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "../benchmarks.h"
+
+#include "foundation/math.h"
+
+#include "engine/scene.h"
+
+#include <limits>
+
+using namespace hg;
+
+static const size_t node_count = 100000;
+
+static time_ns CreateNodesOneByOne(Scene &scene, std::vector<NodeRef> &refs) {
+	const time_ns t = time_now();
+	for (size_t i = 0; i < node_count; ++i) {
+		Node node = scene.CreateNode();
+		node.SetTransform(scene.CreateTransform());
+		node.SetObject(scene.CreateObject());
+		refs[i] = node.ref;
+	}
+	return time_now() - t;
+}
+
+static time_ns CreateNodesInBulk(Scene &scene, std::vector<NodeRef> &refs) {
+	const time_ns t = time_now();
+	refs = scene.CreateNodes(node_count, NCM_Transform | NCM_Object);
+	return time_now() - t;
+}
+
+static time_ns DestroyNodesOneByOne(Scene &scene, const std::vector<NodeRef> &refs) {
+	const time_ns t = time_now();
+	for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+		scene.DestroyNode(*i);
+	scene.GarbageCollect();
+	return time_now() - t;
+}
+
+static time_ns DestroyNodesInBulk(Scene &scene, const std::vector<NodeRef> &refs) {
+	const time_ns t = time_now();
+	scene.DestroyNodes(refs);
+	scene.GarbageCollect();
+	return time_now() - t;
+}
+
+void bench_scene_nodes() {
+	time_ns create_one = std::numeric_limits<time_ns>::max(), destroy_one = std::numeric_limits<time_ns>::max();
+	time_ns create_bulk = std::numeric_limits<time_ns>::max(), destroy_bulk = std::numeric_limits<time_ns>::max();
+
+	for (int run = 0; run < bench::RunCount; ++run) {
+		std::vector<NodeRef> refs(node_count);
+
+		{
+			Scene scene;
+			create_one = Min(create_one, CreateNodesOneByOne(scene, refs));
+			destroy_one = Min(destroy_one, DestroyNodesOneByOne(scene, refs));
+		}
+
+		{
+			Scene scene;
+			create_bulk = Min(create_bulk, CreateNodesInBulk(scene, refs));
+			destroy_bulk = Min(destroy_bulk, DestroyNodesInBulk(scene, refs));
+		}
+	}
+
+	bench::Report("create node+transform+object (one by one)", create_one, node_count);
+	bench::Report("create node+transform+object (CreateNodes)", create_bulk, node_count);
+	bench::Report("destroy and collect (one by one)", destroy_one, node_count);
+	bench::Report("destroy and collect (DestroyNodes)", destroy_bulk, node_count);
+}
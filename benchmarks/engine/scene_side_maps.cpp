@@ -0,0 +1,134 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "../benchmarks.h"
+
+#include "foundation/gen_ref_map.h"
+#include "foundation/math.h"
+#include "foundation/rand.h"
+
+#include "engine/scene.h"
+
+#include <fmt/format.h>
+#include <limits>
+#include <map>
+
+using namespace hg;
+
+static const size_t node_count = 100000;
+
+static size_t sink = 0; // prevent the compiler from optimizing the lookup loops out
+
+// node side map as stored by Scene before it used gen_ref_map
+typedef std::map<gen_ref, std::vector<ComponentRef> > MapSideMap;
+typedef gen_ref_map<std::vector<ComponentRef> > GenRefSideMap;
+
+template <typename T> static time_ns LookupSideMap(const T &side_map, const std::vector<gen_ref> &refs) {
+	const time_ns t = time_now();
+	size_t found = 0;
+	for (std::vector<gen_ref>::const_iterator i = refs.begin(); i != refs.end(); ++i) {
+		const typename T::const_iterator j = side_map.find(*i);
+		if (j != side_map.end())
+			found += j->second.size();
+	}
+	sink += found;
+	return time_now() - t;
+}
+
+template <typename T> static time_ns MeasureSideMap(const std::vector<gen_ref> &refs) {
+	T side_map;
+	for (std::vector<gen_ref>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+		side_map[*i].push_back(*i);
+	return LookupSideMap(side_map, refs);
+}
+
+// nodes with a collision and a script, slots are reused so that node generations are mixed
+static std::vector<NodeRef> CreateNodes(Scene &scene) {
+	std::vector<NodeRef> refs;
+	for (size_t i = 0; i < node_count; ++i) {
+		Node node = scene.CreateNode();
+		node.SetTransform(scene.CreateTransform());
+		node.SetCollision(0, scene.CreateCollision());
+		node.SetScript(0, scene.CreateScript());
+		refs.push_back(node.ref);
+	}
+
+	for (size_t i = 0; i < node_count; i += 2)
+		scene.DestroyNode(refs[i]);
+	scene.GarbageCollect();
+
+	for (size_t i = 0; i < node_count; i += 2) {
+		Node node = scene.CreateNode();
+		node.SetTransform(scene.CreateTransform());
+		node.SetCollision(0, scene.CreateCollision());
+		node.SetScript(0, scene.CreateScript());
+		refs[i] = node.ref;
+	}
+	return refs;
+}
+
+struct Measures {
+	Measures() { disable = enable = collision = script = std::numeric_limits<time_ns>::max(); }
+	time_ns disable, enable, collision, script;
+};
+
+static void MeasureScene(Measures &m, const std::vector<NodeRef> &refs, Scene &scene) {
+	{
+		const time_ns t = time_now();
+		for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+			scene.DisableNode(*i);
+		m.disable = Min(m.disable, time_now() - t);
+	}
+
+	{
+		const time_ns t = time_now();
+		for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+			scene.EnableNode(*i);
+		m.enable = Min(m.enable, time_now() - t);
+	}
+
+	{
+		const time_ns t = time_now();
+		size_t found = 0;
+		for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+			found += scene.GetNodeCollisionCount(*i) + scene.GetNodeCollisionRef(*i, 0).idx;
+		sink += found;
+		m.collision = Min(m.collision, time_now() - t);
+	}
+
+	{
+		const time_ns t = time_now();
+		size_t found = 0;
+		for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+			found += scene.GetNodeScriptCount(*i) + scene.GetNodeScriptRef(*i, 0).idx;
+		sink += found;
+		m.script = Min(m.script, time_now() - t);
+	}
+}
+
+void bench_scene_side_maps() {
+	Measures m;
+	time_ns map_lookup = std::numeric_limits<time_ns>::max(), gen_ref_map_lookup = std::numeric_limits<time_ns>::max();
+
+	for (int run = 0; run < bench::RunCount; ++run) {
+		Scene scene;
+		std::vector<NodeRef> refs = CreateNodes(scene);
+
+		Seed(run);
+		for (size_t i = refs.size() - 1; i > 0; --i)
+			std::swap(refs[i], refs[Rand(uint32_t(i + 1))]);
+
+		MeasureScene(m, refs, scene);
+
+		map_lookup = Min(map_lookup, MeasureSideMap<MapSideMap>(refs));
+		gen_ref_map_lookup = Min(gen_ref_map_lookup, MeasureSideMap<GenRefSideMap>(refs));
+	}
+
+	bench::Report("DisableNode (random order)", m.disable, node_count);
+	bench::Report("EnableNode (random order)", m.enable, node_count);
+	bench::Report("node collision count+ref (random order)", m.collision, node_count);
+	bench::Report("node script count+ref (random order)", m.script, node_count);
+
+	fmt::print(" side map lookup (random order)\n");
+	bench::Report("std::map", map_lookup, node_count);
+	bench::Report("gen_ref_map", gen_ref_map_lookup, node_count);
+}
@@ -0,0 +1,116 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "../benchmarks.h"
+
+#include "foundation/math.h"
+#include "foundation/packed_vector_list.h"
+#include "foundation/rand.h"
+#include "foundation/vector4.h"
+#include "foundation/vector_list.h"
+
+#include <fmt/format.h>
+#include <limits>
+
+using namespace hg;
+
+static const size_t entry_count = 1000000;
+
+static float sink = 0.f; // prevent the compiler from optimizing the iteration loops out
+
+template <typename T> static time_ns Iterate(const T &c) {
+	const time_ns t = time_now();
+	float sum = 0.f;
+	for (typename T::const_iterator i = c.begin(); i != c.end(); ++i)
+		sum += i->x;
+	sink += sum;
+	return time_now() - t;
+}
+
+struct Measures {
+	Measures() {
+		add = iterate = remove = iterate_sparse = churn = iterate_churned = std::numeric_limits<time_ns>::max();
+	}
+	time_ns add, iterate, remove, iterate_sparse, churn, iterate_churned;
+};
+
+template <typename T> static void Measure(Measures &m, int run) {
+	T l;
+	std::vector<uint32_t> idxs(entry_count);
+
+	{
+		const time_ns t = time_now();
+		for (size_t i = 0; i < entry_count; ++i)
+			idxs[i] = l.add(Vec4(float(i), 0.f, 0.f, 0.f));
+		m.add = Min(m.add, time_now() - t);
+	}
+
+	m.iterate = Min(m.iterate, Iterate(l));
+
+	// remove ~31 entries out of 32 in random order
+	{
+		Seed(run);
+		for (size_t i = entry_count - 1; i > 0; --i)
+			std::swap(idxs[i], idxs[Rand(uint32_t(i + 1))]);
+
+		const size_t remove_count = entry_count - entry_count / 32;
+
+		const time_ns t = time_now();
+		for (size_t i = 0; i < remove_count; ++i)
+			l.erase(idxs[i]);
+		m.remove = Min(m.remove, time_now() - t);
+
+		idxs.erase(idxs.begin(), idxs.begin() + remove_count);
+	}
+
+	m.iterate_sparse = Min(m.iterate_sparse, Iterate(l));
+
+	// spawn/despawn, live entries end up scattered over the whole index range
+	{
+		const time_ns t = time_now();
+		for (size_t i = 0; i < entry_count; ++i) {
+			const size_t j = Rand(uint32_t(idxs.size()));
+			l.erase(idxs[j]);
+			idxs[j] = l.add(Vec4(float(i), 0.f, 0.f, 0.f));
+		}
+		m.churn = Min(m.churn, time_now() - t);
+	}
+
+	m.iterate_churned = Min(m.iterate_churned, Iterate(l));
+}
+
+static void Report(const char *name, const Measures &m) {
+	fmt::print(" {}\n", name);
+	bench::Report("add", m.add, entry_count);
+	bench::Report("iterate", m.iterate, entry_count);
+	bench::Report("remove (random order)", m.remove, entry_count - entry_count / 32);
+	bench::Report("iterate (1/32 used)", m.iterate_sparse, entry_count / 32);
+	bench::Report("remove+add (random order)", m.churn, entry_count);
+	bench::Report("iterate (1/32 used, after remove+add)", m.iterate_churned, entry_count / 32);
+}
+
+void bench_vector_list() {
+	time_ns add_vector = std::numeric_limits<time_ns>::max(), iterate_vector = std::numeric_limits<time_ns>::max();
+	Measures vector_list_m, packed_vector_list_m;
+
+	for (int run = 0; run < bench::RunCount; ++run) {
+		{
+			std::vector<Vec4> v;
+			const time_ns t = time_now();
+			for (size_t i = 0; i < entry_count; ++i)
+				v.push_back(Vec4(float(i), 0.f, 0.f, 0.f));
+			add_vector = Min(add_vector, time_now() - t);
+
+			iterate_vector = Min(iterate_vector, Iterate(v));
+		}
+
+		Measure<vector_list<Vec4> >(vector_list_m, run);
+		Measure<packed_vector_list<Vec4> >(packed_vector_list_m, run);
+	}
+
+	fmt::print(" std::vector\n");
+	bench::Report("push_back", add_vector, entry_count);
+	bench::Report("iterate", iterate_vector, entry_count);
+
+	Report("vector_list", vector_list_m);
+	Report("packed_vector_list", packed_vector_list_m);
+}
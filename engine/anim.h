@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "foundation/atom.h"
 #include "foundation/cext.h"
 #include "foundation/color.h"
 #include "foundation/math.h"
@@ -33,7 +34,7 @@ template <typename T> struct AnimTrackT {
 	typedef T Value;
 	typedef AnimKeyT<Value> Key;
 
-	std::string target;
+	atom target;
 	std::deque<Key> keys;
 };
 
@@ -49,7 +50,7 @@ template <typename T> struct AnimTrackHermiteT {
 	typedef T Value;
 	typedef AnimKeyHermiteT<Value> Key;
 
-	std::string target;
+	atom target;
 	std::deque<Key> keys;
 };
 
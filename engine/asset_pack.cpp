@@ -0,0 +1,248 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "engine/asset_pack.h"
+#include "engine/file_format.h"
+
+#include "foundation/cext.h"
+#include "foundation/log.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <miniz.h>
+#include <string.h>
+#include <xxhash.h>
+
+namespace hg {
+
+static bool IsValidHeader(const AssetPackHeader &header) {
+	return header.magic == HarfangMagic && header.marker == AssetPackMarker && header.version == AssetPackVersion;
+}
+
+bool IsAssetPack(const std::string &path) {
+	ScopedFile file(Open(path, true));
+	if (!file)
+		return false;
+
+	AssetPackHeader header;
+	return Read(file, &header, sizeof(header)) == sizeof(header) && IsValidHeader(header);
+}
+
+//
+// payloads must lie between the header and the TOC at the alignment they were written with, stored payloads are used in place from the mapping
+static bool IsValidEntry(const AssetPackEntry &e, const AssetPackHeader &header) {
+	if (e.offset < sizeof(AssetPackHeader) || e.offset > header.toc_offset || e.size > header.toc_offset - e.offset)
+		return false;
+	if (e.align_log2 >= 32 || (uint32_t(1) << e.align_log2) > AssetPackMaxAlignment || e.offset & ((uint64_t(1) << e.align_log2) - 1))
+		return false;
+	if (uint64_t(e.name_offset) + e.name_size > header.names_size)
+		return false;
+	return e.compression <= APC_Deflate && (e.compression != APC_None || e.size == e.uncompressed_size);
+}
+
+bool OpenAssetPack(const std::string &path, AssetPack &pack) {
+	pack.entries = nullptr;
+	pack.entry_count = 0;
+	pack.names = nullptr;
+
+	if (!MapFile(path, pack.map))
+		return false;
+
+	const uint8_t *data = pack.map.data;
+	const uint64_t size = pack.map.size;
+
+	if (size < sizeof(AssetPackHeader)) {
+		CloseAssetPack(pack);
+		return false;
+	}
+
+	const AssetPackHeader &header = *reinterpret_cast<const AssetPackHeader *>(data);
+
+	const uint64_t toc_size = uint64_t(header.entry_count) * sizeof(AssetPackEntry);
+	if (!IsValidHeader(header) || header.toc_offset % 8 || header.toc_offset > size || toc_size + header.names_size > size - header.toc_offset) {
+		warn(fmt::format("Invalid asset pack '{}'", path));
+		CloseAssetPack(pack);
+		return false;
+	}
+
+	pack.entries = reinterpret_cast<const AssetPackEntry *>(data + header.toc_offset);
+	pack.entry_count = header.entry_count;
+	pack.names = reinterpret_cast<const char *>(data + header.toc_offset + toc_size);
+
+	for (uint32_t i = 0; i < pack.entry_count; ++i) {
+		const AssetPackEntry &e = pack.entries[i];
+		if (!IsValidEntry(e, header)) {
+			warn(fmt::format("Invalid asset pack '{}', entry {} is corrupted", path, i));
+			CloseAssetPack(pack);
+			return false;
+		}
+
+		if (i > 0 && e.hash < pack.entries[i - 1].hash) { // FindAssetPackEntry bisects the table of content
+			warn(fmt::format("Invalid asset pack '{}', entries are not sorted", path));
+			CloseAssetPack(pack);
+			return false;
+		}
+	}
+	return true;
+}
+
+void CloseAssetPack(AssetPack &pack) {
+	UnmapFile(pack.map);
+	pack.entries = nullptr;
+	pack.entry_count = 0;
+	pack.names = nullptr;
+}
+
+//
+static bool EntryLess(const AssetPackEntry &e, uint64_t hash) { return e.hash < hash; }
+
+const AssetPackEntry *FindAssetPackEntry(const AssetPack &pack, const std::string &name) {
+	const uint64_t hash = XXH64(name.data(), name.size(), 0);
+
+	const AssetPackEntry *end = pack.entries + pack.entry_count;
+	for (const AssetPackEntry *e = std::lower_bound(pack.entries, end, hash, EntryLess); e != end && e->hash == hash; ++e)
+		if (e->name_size == name.size() && memcmp(pack.names + e->name_offset, name.data(), name.size()) == 0)
+			return e;
+	return nullptr;
+}
+
+std::string GetAssetPackEntryName(const AssetPack &pack, const AssetPackEntry &entry) { return std::string(pack.names + entry.name_offset, entry.name_size); }
+
+const uint8_t *GetAssetPackEntryData(const AssetPack &pack, const AssetPackEntry &entry) { return pack.map.data + entry.offset; }
+
+bool ReadAssetPackEntry(const AssetPack &pack, const AssetPackEntry &entry, Data &data) {
+	const uint8_t *payload = GetAssetPackEntryData(pack, entry);
+
+	data.Resize(size_t(entry.uncompressed_size));
+
+	if (entry.compression == APC_None) {
+		if (entry.size)
+			memcpy(data.GetData(), payload, size_t(entry.size));
+		return true;
+	}
+
+	mz_ulong size = mz_ulong(entry.uncompressed_size);
+	return mz_uncompress(data.GetData(), &size, payload, mz_ulong(entry.size)) == MZ_OK && size == entry.uncompressed_size;
+}
+
+//
+struct PackedEntry {
+	AssetPackEntry entry;
+	std::string name;
+};
+
+static bool PackedEntryLess(const PackedEntry &a, const PackedEntry &b) { return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.name < b.name; }
+
+static bool WritePadding(File file, uint64_t &offset, uint64_t alignment) {
+	static const uint8_t zeros[256] = {0};
+
+	while (offset % alignment) {
+		const size_t count = size_t(std::min(alignment - offset % alignment, uint64_t(sizeof(zeros))));
+		if (Write(file, zeros, count) != count)
+			return false;
+		offset += count;
+	}
+	return true;
+}
+
+bool WriteAssetPack(const std::string &path, const std::vector<AssetPackInput> &inputs) {
+	ScopedFile file(OpenWrite(path));
+	if (!file)
+		return false;
+
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(header));
+
+	if (Write(file, &header, sizeof(header)) != sizeof(header))
+		return false;
+
+	uint64_t offset = sizeof(header);
+
+	std::vector<PackedEntry> entries(inputs.size());
+	std::vector<uint8_t> compressed;
+
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		const AssetPackInput &input = inputs[i];
+		PackedEntry &packed = entries[i];
+
+		const uint32_t alignment = input.alignment ? input.alignment : 1;
+		if ((alignment & (alignment - 1)) || alignment > AssetPackMaxAlignment || input.name.empty() || input.name.size() > 0xffff) {
+			warn(fmt::format("Cannot pack '{}', invalid name or alignment", input.name));
+			return false;
+		}
+
+		Data data;
+		if (!FileToData(input.path, data)) {
+			warn(fmt::format("Cannot pack '{}', failed to read '{}'", input.name, input.path));
+			return false;
+		}
+
+		packed.name = input.name;
+
+		AssetPackEntry &entry = packed.entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.hash = XXH64(input.name.data(), input.name.size(), 0);
+		entry.size = entry.uncompressed_size = data.GetSize();
+		entry.compression = APC_None;
+
+		while ((uint32_t(1) << entry.align_log2) < alignment)
+			++entry.align_log2;
+
+		const void *payload = data.GetData();
+
+		if (input.compression == APC_Deflate && data.GetSize() && data.GetSize() <= 0xffffffff) { // inflated through mz_stream, 32 bit sizes
+			mz_ulong size = mz_compressBound(mz_ulong(data.GetSize()));
+			compressed.resize(size);
+
+			if (mz_compress2(&compressed[0], &size, data.GetData(), mz_ulong(data.GetSize()), MZ_BEST_COMPRESSION) == MZ_OK && size < data.GetSize()) {
+				entry.size = size;
+				entry.compression = APC_Deflate;
+				payload = &compressed[0];
+			}
+		}
+
+		if (!WritePadding(file, offset, alignment))
+			return false;
+
+		entry.offset = offset;
+
+		if (Write(file, payload, size_t(entry.size)) != entry.size)
+			return false;
+		offset += entry.size;
+	}
+
+	std::sort(entries.begin(), entries.end(), PackedEntryLess);
+
+	// TOC
+	std::string names;
+	std::vector<AssetPackEntry> toc(entries.size());
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (i > 0 && entries[i].name == entries[i - 1].name) {
+			warn(fmt::format("Cannot pack '{}', name is used by several entries", entries[i].name));
+			return false;
+		}
+
+		toc[i] = entries[i].entry;
+		toc[i].name_offset = uint32_t(names.size());
+		toc[i].name_size = uint16_t(entries[i].name.size());
+		names += entries[i].name;
+	}
+
+	if (!WritePadding(file, offset, 8))
+		return false;
+
+	header.magic = HarfangMagic;
+	header.marker = AssetPackMarker;
+	header.version = AssetPackVersion;
+	header.entry_count = uint32_t(toc.size());
+	header.names_size = uint32_t(names.size());
+	header.toc_offset = offset;
+
+	const size_t toc_size = toc.size() * sizeof(AssetPackEntry);
+	if ((toc_size && Write(file, &toc[0], toc_size) != toc_size) || Write(file, names.data(), names.size()) != names.size())
+		return false;
+
+	return Seek(file, 0, SM_Start) && Write(file, &header, sizeof(header)) == sizeof(header);
+}
+
+} // namespace hg
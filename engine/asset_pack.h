@@ -0,0 +1,88 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/data.h"
+#include "foundation/file.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace hg {
+
+/*
+	Asset pack
+
+	Engine-native archive designed to be memory-mapped:
+
+	- header: HarfangMagic, AssetPackMarker, version, entry count, names size and TOC offset,
+	- entry payloads, each aligned to the alignment requested for the entry,
+	- TOC: AssetPackEntry array sorted by name hash then name, followed by the entry names.
+
+	Entries are either stored or deflated (zlib stream), stored entries can be used in place from the mapping.
+	All values are little-endian.
+*/
+static const uint8_t AssetPackVersion = 1;
+static const uint32_t AssetPackMaxAlignment = 4096; // a mapping is only guaranteed to be page aligned
+
+enum AssetPackCompression { APC_None, APC_Deflate };
+
+struct AssetPackHeader {
+	uint32_t magic;
+	uint8_t marker;
+	uint8_t version;
+	uint16_t reserved;
+	uint32_t entry_count;
+	uint32_t names_size;
+	uint64_t toc_offset;
+};
+
+struct AssetPackEntry {
+	uint64_t hash; // XXH64 of the entry name
+	uint64_t offset; // payload offset in the pack
+	uint64_t size; // payload size
+	uint64_t uncompressed_size;
+	uint32_t name_offset; // in the names block
+	uint16_t name_size;
+	uint8_t compression; // AssetPackCompression
+	uint8_t align_log2;
+};
+
+struct AssetPack {
+	MappedFile map;
+
+	const AssetPackEntry *entries;
+	uint32_t entry_count;
+	const char *names;
+};
+
+/// Return true if a file starts with an asset pack header.
+bool IsAssetPack(const std::string &path);
+
+/// Map an asset pack and validate its table of content, entries must be sorted by name hash.
+bool OpenAssetPack(const std::string &path, AssetPack &pack);
+void CloseAssetPack(AssetPack &pack);
+
+/// Return the entry of an asset, null if the pack does not contain it.
+const AssetPackEntry *FindAssetPackEntry(const AssetPack &pack, const std::string &name);
+
+std::string GetAssetPackEntryName(const AssetPack &pack, const AssetPackEntry &entry);
+/// Return the entry payload in the mapped pack, the payload is the asset content when the entry is stored.
+const uint8_t *GetAssetPackEntryData(const AssetPack &pack, const AssetPackEntry &entry);
+
+/// Read the content of an entry, inflating it if needed.
+bool ReadAssetPackEntry(const AssetPack &pack, const AssetPackEntry &entry, Data &data);
+
+//
+struct AssetPackInput {
+	std::string name; // asset name in the pack
+	std::string path; // file to pack
+	AssetPackCompression compression; // deflated entries are stored if compressing them does not save space
+	uint32_t alignment; // power of 2, at most AssetPackMaxAlignment
+};
+
+/// Write an asset pack, return false if an input cannot be read, names are not unique or the pack cannot be written.
+bool WriteAssetPack(const std::string &path, const std::vector<AssetPackInput> &inputs);
+
+} // namespace hg
@@ -1,12 +1,15 @@
 // HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
 
 #include "engine/assets.h"
+#include "engine/asset_pack.h"
 
 #include "foundation/cext.h"
 #include "foundation/dir.h"
 #include "foundation/file.h"
 #include "foundation/log.h"
 #include "foundation/path_tools.h"
+#include "foundation/string.h"
+#include "foundation/thread.h"
 
 #include <algorithm>
 #include <cstdio>
@@ -16,6 +19,7 @@
 #include <functional>
 #include <memory>
 #include <miniz.h>
+#include <xxhash.h>
 #include <set>
 #include <string>
 #include <vector>
@@ -29,64 +33,406 @@ struct AssetsSource {
 	std::string name;
 };
 
-//
-static std::deque<std::string> assets_folders;
+// mounted zip archive or asset pack
+struct Package_ {
+	std::string filename;
 
-bool AddAssetsFolder(const std::string &path) {
-	if (std::find(assets_folders.begin(), assets_folders.end(), path) == assets_folders.end()) {
-		assets_folders.push_front(path);
-		return true;
+	bool is_pack;
+	AssetPack pack;
+
+	mz_zip_archive archive;
+	MappedFile map; // the archive is read from memory when the package could be mapped
+
+	Mutex lock; // miniz archives must not be accessed concurrently
+	volatile int32_t ref_count;
+
+	Package_() : is_pack(false), ref_count(1) {
+		mz_zip_zero_struct(&archive);
+		map.data = pack.map.data = nullptr;
+		map.size = pack.map.size = 0;
+		map.handle = pack.map.handle = nullptr;
+	}
+
+	~Package_() {
+		if (is_pack) {
+			CloseAssetPack(pack);
+		} else {
+			mz_zip_reader_end(&archive);
+			UnmapFile(map);
+		}
+	}
+};
+
+static void ReleasePackage(Package_ *pkg) {
+	if (AtomicAdd(pkg->ref_count, -1) == 0)
+		delete pkg;
+}
+
+// mounted folder and the files it held when it was last scanned
+struct AssetsFolder_ {
+	std::string path;
+	std::vector<std::string> files;
+};
+
+static std::deque<AssetsFolder_> assets_folders;
+static std::deque<Package_ *> assets_packages;
+static Mutex sources_lock; // serializes changes to the mounted sources and index rebuilds
+
+/*
+	Assets index
+
+	Maps every asset name of the mounted sources to the source it resolves to, using the same priority as scanning the sources in order:
+	folders first then packages, most recently mounted first. The index is immutable: it is rebuilt when a source is mounted or
+	unmounted and readers keep a reference on the index they looked up until they are done with it.
+*/
+struct AssetsIndex {
+	struct Entry {
+		uint32_t hash;
+		int32_t next;
+		int32_t folder; // index in folders, -1 if the asset is in a package
+		Package_ *pkg;
+		mz_uint pkg_index;
+		std::string name;
+	};
+
+	std::vector<std::string> folders;
+	std::vector<Package_ *> packages; // referenced by the index
+
+	std::vector<Entry> entries;
+	std::vector<int32_t> buckets; // power of 2 size, head of each bucket entry chain
+
+	volatile int32_t ref_count;
+
+	AssetsIndex() : ref_count(1) {}
+	~AssetsIndex() {
+		for (size_t i = 0; i < packages.size(); ++i)
+			ReleasePackage(packages[i]);
+	}
+
+	// names are matched as the filesystem would, ignoring case on Windows
+#if _WIN32
+	static uint32_t Hash(const std::string &name) {
+		const std::string lower = tolower(name);
+		return XXH32(lower.data(), lower.size(), 0);
+	}
+	static bool Equal(const std::string &a, const std::string &b) { return a.size() == b.size() && starts_with(a, b, case_sensitivity::insensitive); }
+#else
+	static uint32_t Hash(const std::string &name) { return XXH32(name.data(), name.size(), 0); }
+	static bool Equal(const std::string &a, const std::string &b) { return a == b; }
+#endif
+
+	const Entry *find(const std::string &name, uint32_t hash) const {
+		if (buckets.empty())
+			return nullptr;
+		for (int32_t i = buckets[hash & (buckets.size() - 1)]; i != -1; i = entries[i].next)
+			if (entries[i].hash == hash && Equal(entries[i].name, name))
+				return &entries[i];
+		return nullptr;
+	}
+
+	const Entry *find(const std::string &name) const {
+		const Entry *entry = find(name, Hash(name));
+		if (!entry) {
+			const std::string clean_name = CleanPath(name);
+			if (clean_name != name)
+				entry = find(clean_name, Hash(clean_name));
+		}
+		return entry;
+	}
+
+	// the first source to add a name has priority
+	void add(const std::string &name, int32_t folder, Package_ *pkg, mz_uint pkg_index) {
+		const uint32_t hash = Hash(name);
+		if (find(name, hash))
+			return;
+
+		int32_t &head = buckets[hash & (buckets.size() - 1)];
+
+		Entry entry;
+		entry.hash = hash;
+		entry.next = head;
+		entry.folder = folder;
+		entry.pkg = pkg;
+		entry.pkg_index = pkg_index;
+		entry.name = name;
+
+		head = int32_t(entries.size());
+		entries.push_back(entry);
 	}
+};
+
+static AssetsIndex *assets_index = nullptr;
+static Mutex assets_index_lock; // protects the assets_index pointer
+
+static void ReleaseAssetsIndex(AssetsIndex *index) {
+	if (index && AtomicAdd(index->ref_count, -1) == 0)
+		delete index;
+}
+
+struct ScopedAssetsIndex {
+	ScopedAssetsIndex() {
+		ScopedLock lock(assets_index_lock);
+		index = assets_index;
+		if (index)
+			AtomicAdd(index->ref_count, 1);
+	}
+	~ScopedAssetsIndex() { ReleaseAssetsIndex(index); }
+
+	const AssetsIndex::Entry *find(const std::string &name) const { return index ? index->find(name) : nullptr; }
+
+	AssetsIndex *index;
+
+private:
+	ScopedAssetsIndex(const ScopedAssetsIndex &);
+	ScopedAssetsIndex &operator=(const ScopedAssetsIndex &);
+};
+
+static const int assets_folder_max_depth = 32; // bounds symbolic link cycles
+
+// links are followed, as opening a file through the folder would
+static void ScanAssetsFolder(const std::string &path, const std::string &prefix, int depth, std::vector<std::string> &files) {
+	const std::vector<DirEntry> entries = ListDir(path, DE_All);
+
+	for (std::vector<DirEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+		const std::string entry_path = PathJoin(path, i->name);
+
+		int type = i->type;
+		if (type == DE_Link)
+			type = IsDir(entry_path) ? DE_Dir : (IsFile(entry_path) ? DE_File : 0);
+
+		const std::string name = prefix.empty() ? i->name : prefix + "/" + i->name;
+
+		if (type == DE_File)
+			files.push_back(name);
+		else if (type == DE_Dir && depth < assets_folder_max_depth)
+			ScanAssetsFolder(entry_path, name, depth + 1, files);
+	}
+}
+
+static void ScanAssetsFolder(AssetsFolder_ &folder) {
+	folder.files.clear();
+	ScanAssetsFolder(folder.path, std::string(), 0, folder.files);
+}
+
+// absolute paths and paths leaving their folder cannot be indexed, they are probed in each folder as they were before the index
+static bool IsProbedAssetName(const std::string &name) {
+	if (IsPathAbsolute(name))
+		return true;
+
+	for (size_t i = 0; (i = name.find("..", i)) != std::string::npos; i += 2)
+		if ((i == 0 || name[i - 1] == '/' || name[i - 1] == '\\') && (i + 2 == name.size() || name[i + 2] == '/' || name[i + 2] == '\\'))
+			return true;
 	return false;
 }
 
+// names missing from the index fail after a single lookup, other files created since the last scan are only seen once the index is refreshed
+static std::string ProbeAssetsFolders(const AssetsIndex *index, const std::string &name) {
+	if (index && IsProbedAssetName(name))
+		for (std::vector<std::string>::const_iterator i = index->folders.begin(); i != index->folders.end(); ++i) {
+			const std::string path = PathJoin(*i, name);
+			if (IsFile(path))
+				return path;
+		}
+	return std::string();
+}
+
+// must be called with sources_lock held
+static void RebuildAssetsIndex() {
+	AssetsIndex *index = new AssetsIndex;
+
+	std::vector<std::vector<std::string> > package_files(assets_packages.size());
+	size_t count = 0;
+
+	for (std::deque<AssetsFolder_>::const_iterator i = assets_folders.begin(); i != assets_folders.end(); ++i) {
+		index->folders.push_back(i->path);
+		count += i->files.size();
+	}
+
+	for (size_t i = 0; i < assets_packages.size(); ++i) {
+		Package_ &pkg = *assets_packages[i];
+		AtomicAdd(pkg.ref_count, 1);
+		index->packages.push_back(&pkg);
+
+		if (pkg.is_pack) {
+			package_files[i].resize(pkg.pack.entry_count);
+			for (uint32_t j = 0; j < pkg.pack.entry_count; ++j)
+				package_files[i][j] = GetAssetPackEntryName(pkg.pack, pkg.pack.entries[j]);
+			count += pkg.pack.entry_count;
+			continue;
+		}
+
+		ScopedLock lock(pkg.lock);
+
+		const mz_uint file_count = mz_zip_reader_get_num_files(&pkg.archive);
+		package_files[i].resize(file_count);
+
+		std::vector<char> filename;
+		for (mz_uint j = 0; j < file_count; ++j) {
+			if (mz_zip_reader_is_file_a_directory(&pkg.archive, j))
+				continue;
+
+			filename.resize(mz_zip_reader_get_filename(&pkg.archive, j, nullptr, 0));
+			if (filename.empty())
+				continue;
+
+			mz_zip_reader_get_filename(&pkg.archive, j, &filename[0], mz_uint(filename.size()));
+			package_files[i][j] = &filename[0];
+		}
+		count += file_count;
+	}
+
+	size_t bucket_count = 16;
+	while (bucket_count < count)
+		bucket_count <<= 1;
+
+	index->buckets.resize(bucket_count, -1);
+	index->entries.reserve(count);
+
+	for (size_t i = 0; i < assets_folders.size(); ++i) {
+		const std::vector<std::string> &files = assets_folders[i].files;
+		for (size_t j = 0; j < files.size(); ++j)
+			index->add(files[j], int32_t(i), nullptr, 0);
+	}
+
+	for (size_t i = 0; i < package_files.size(); ++i)
+		for (size_t j = 0; j < package_files[i].size(); ++j)
+			if (!package_files[i][j].empty())
+				index->add(package_files[i][j], -1, index->packages[i], mz_uint(j));
+
+	AssetsIndex *previous;
+	{
+		ScopedLock lock(assets_index_lock);
+		previous = assets_index;
+		assets_index = index;
+	}
+	ReleaseAssetsIndex(previous);
+}
+
+//
+bool AddAssetsFolder(const std::string &path) {
+	ScopedLock lock(sources_lock);
+
+	for (std::deque<AssetsFolder_>::const_iterator i = assets_folders.begin(); i != assets_folders.end(); ++i)
+		if (i->path == path)
+			return false;
+
+	AssetsFolder_ folder;
+	folder.path = path;
+	ScanAssetsFolder(folder);
+
+	assets_folders.push_front(folder);
+	RebuildAssetsIndex();
+	return true;
+}
+
 void RemoveAssetsFolder(const std::string &path) {
-	for (std::deque<std::string>::iterator i = assets_folders.begin(); i != assets_folders.end();)
-		if (*i == path)
+	ScopedLock lock(sources_lock);
+
+	bool removed = false;
+	for (std::deque<AssetsFolder_>::iterator i = assets_folders.begin(); i != assets_folders.end();)
+		if (i->path == path) {
 			i = assets_folders.erase(i);
-		else
+			removed = true;
+		} else {
 			++i;
+		}
+
+	if (removed)
+		RebuildAssetsIndex();
 }
 
 //
-struct ZipPackage {
-	mz_zip_archive archive;
-	std::string filename;
+bool AddAssetsPackage(const std::string &path) {
+	ScopedLock lock(sources_lock);
 
-	ZipPackage() { mz_zip_zero_struct(&archive); }
-	~ZipPackage() { mz_zip_reader_end(&archive); }
-};
+	for (std::deque<Package_ *>::iterator i = assets_packages.begin(); i != assets_packages.end(); ++i)
+		if ((*i)->filename == path)
+			return false;
 
-static std::deque<ZipPackage> assets_packages;
+	Package_ *pkg = new Package_;
 
-bool AddAssetsPackage(const std::string &path) {
-	for (std::deque<ZipPackage>::iterator i = assets_packages.begin(); i != assets_packages.end(); ++i)
-		if (i->filename == path)
-			return false;
+	pkg->filename = path;
 
-	ZipPackage pkg;
+	mz_bool ok;
+	if (IsAssetPack(path))
+		ok = (pkg->is_pack = OpenAssetPack(path, pkg->pack)) ? MZ_TRUE : MZ_FALSE;
+	else if (MapFile(path, pkg->map))
+		ok = mz_zip_reader_init_mem(&pkg->archive, pkg->map.data, pkg->map.size, MZ_ZIP_FLAG_VALIDATE_HEADERS_ONLY);
+	else
+		ok = mz_zip_reader_init_file(&pkg->archive, path.c_str(), MZ_ZIP_FLAG_VALIDATE_HEADERS_ONLY);
 
-	pkg.filename = path;
-	if (mz_zip_reader_init_file(&pkg.archive, path.c_str(), MZ_ZIP_FLAG_VALIDATE_HEADERS_ONLY) == MZ_FALSE)
+	if (ok == MZ_FALSE) {
+		ReleasePackage(pkg);
 		return false;
+	}
 
 	assets_packages.push_front(pkg);
+	RebuildAssetsIndex();
 	return true;
 }
 
 void RemoveAssetsPackage(const std::string &path) {
-	for (std::deque<ZipPackage>::iterator i = assets_packages.begin(); i != assets_packages.end();)
-		if (i->filename == path)
+	ScopedLock lock(sources_lock);
+
+	bool removed = false;
+	for (std::deque<Package_ *>::iterator i = assets_packages.begin(); i != assets_packages.end();)
+		if ((*i)->filename == path) {
+			ReleasePackage(*i);
 			i = assets_packages.erase(i);
-		else
+			removed = true;
+		} else {
 			++i;
+		}
+
+	if (removed)
+		RebuildAssetsIndex();
 }
 
+void RefreshAssetsIndex() {
+	ScopedLock lock(sources_lock);
+
+	for (std::deque<AssetsFolder_>::iterator i = assets_folders.begin(); i != assets_folders.end(); ++i)
+		ScanAssetsFolder(*i);
+
+	RebuildAssetsIndex();
+}
+
+/*
+	Package entries are never extracted as a whole: stored entries are read in place from the mapped package,
+	other entries are inflated as they are read.
+*/
 struct PackageFile {
-	std::vector<uint8_t> data;
-	ptrdiff_t cursor;
+	Package_ *pkg; // kept alive while the entry is open
+	mz_uint index;
+
+	const uint8_t *data; // stored entry in the mapped package, null if the entry is inflated
+	mz_zip_reader_extract_iter_state *iter; // zip entry
+	mz_stream *stream; // asset pack entry
+
+	size_t size, cursor;
 };
 
+// return the content of a stored entry in the mapped package, null if it cannot be read in place
+static const uint8_t *GetStoredEntryData(const Package_ &pkg, const mz_zip_archive_file_stat &stat) {
+	if (!pkg.map.data || stat.m_method != 0 || stat.m_is_encrypted || stat.m_comp_size != stat.m_uncomp_size)
+		return nullptr;
+
+	const size_t header_size = 30, ofs = size_t(stat.m_local_header_ofs);
+	if (ofs + header_size > pkg.map.size)
+		return nullptr;
+
+	const uint8_t *header = pkg.map.data + ofs;
+	if (header[0] != 'P' || header[1] != 'K' || header[2] != 3 || header[3] != 4)
+		return nullptr;
+
+	const size_t name_size = header[26] | (header[27] << 8), extra_size = header[28] | (header[29] << 8);
+	const size_t data_ofs = ofs + header_size + name_size + extra_size;
+
+	if (data_ofs + size_t(stat.m_uncomp_size) > pkg.map.size)
+		return nullptr;
+	return pkg.map.data + data_ofs;
+}
+
 //
 struct Asset_ {
 	File file;
@@ -109,96 +455,245 @@ static void Asset_file_Close(Asset_ &asset) { Close(asset.file); }
 static bool Asset_file_is_EOF(Asset_ &asset) { return IsEOF(asset.file); }
 
 //
-static size_t Package_file_GetSize(Asset_ &asset) { return asset.pkg_file.data.size(); }
-static size_t Package_file_Read(Asset_ &asset, void *data, size_t size) {
-	if (asset.pkg_file.cursor + size <= asset.pkg_file.data.size()) {
-		memcpy(data, asset.pkg_file.data.data() + sizeof(char) * asset.pkg_file.cursor, size);
-		asset.pkg_file.cursor += size;
-		return size;
+static void Package_file_Free(PackageFile &f) {
+	if (f.iter) {
+		ScopedLock lock(f.pkg->lock);
+		mz_zip_reader_extract_iter_free(f.iter);
+		f.iter = nullptr;
+	}
+
+	if (f.stream) {
+		mz_inflateEnd(f.stream);
+		delete f.stream;
+		f.stream = nullptr;
+	}
+}
+
+// start inflating from the beginning of the entry
+static bool Package_file_Restart(PackageFile &f) {
+	Package_file_Free(f);
+	f.cursor = 0;
+
+	if (f.pkg->is_pack) {
+		const AssetPackEntry &entry = f.pkg->pack.entries[f.index];
+
+		f.stream = new mz_stream;
+		memset(f.stream, 0, sizeof(mz_stream));
+		f.stream->next_in = GetAssetPackEntryData(f.pkg->pack, entry);
+		f.stream->avail_in = mz_uint32(entry.size);
+
+		if (mz_inflateInit(f.stream) != MZ_OK) {
+			delete f.stream;
+			f.stream = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	ScopedLock lock(f.pkg->lock);
+	f.iter = mz_zip_reader_extract_iter_new(&f.pkg->archive, f.index, 0);
+	return f.iter != nullptr;
+}
+
+static size_t Package_file_Inflate(PackageFile &f, void *data, size_t size) {
+	size_t read = 0;
+
+	if (f.stream) {
+		f.stream->next_out = reinterpret_cast<unsigned char *>(data);
+		f.stream->avail_out = mz_uint32(size);
+
+		while (f.stream->avail_out) {
+			const int status = mz_inflate(f.stream, MZ_SYNC_FLUSH);
+			if (status != MZ_OK)
+				break; // MZ_STREAM_END or error
+		}
+
+		read = size - f.stream->avail_out;
+	} else if (f.iter) {
+		ScopedLock lock(f.pkg->lock);
+		read = mz_zip_reader_extract_iter_read(f.iter, data, size);
 	}
-	return 0;
+
+	f.cursor += read;
+	return read;
 }
+
+static size_t Package_file_GetSize(Asset_ &asset) { return asset.pkg_file.size; }
+
+static size_t Package_file_Read(Asset_ &asset, void *data, size_t size) {
+	PackageFile &f = asset.pkg_file;
+
+	if (size > f.size - f.cursor)
+		size = f.size - f.cursor;
+
+	if (!f.data)
+		return Package_file_Inflate(f, data, size);
+
+	memcpy(data, f.data + f.cursor, size);
+	f.cursor += size;
+	return size;
+}
+
 static bool Package_file_Seek(Asset_ &asset, ptrdiff_t offset, SeekMode mode) {
-	if (offset <= asset.pkg_file.data.size()) {
-		asset.pkg_file.cursor = offset;
+	PackageFile &f = asset.pkg_file;
+
+	ptrdiff_t pos;
+	if (mode == SM_Start)
+		pos = offset;
+	else if (mode == SM_Current)
+		pos = ptrdiff_t(f.cursor) + offset;
+	else
+		pos = ptrdiff_t(f.size) + offset;
+
+	if (pos < 0 || size_t(pos) > f.size)
+		return false;
+
+	if (f.data) {
+		f.cursor = size_t(pos);
 		return true;
 	}
-	return false;
+
+	// inflated entries can only move forward, seeking backward restarts from the beginning of the entry
+	if (size_t(pos) < f.cursor && !Package_file_Restart(f))
+		return false;
+
+	uint8_t skip[4096];
+	while (f.cursor < size_t(pos)) {
+		const size_t count = size_t(pos) - f.cursor < sizeof(skip) ? size_t(pos) - f.cursor : sizeof(skip);
+		if (Package_file_Inflate(f, skip, count) != count)
+			return false;
+	}
+	return true;
 }
+
 static size_t Package_file_Tell(Asset_ &asset) { return asset.pkg_file.cursor; }
-static void Package_file_Close(Asset_ &asset) {}
-static bool Package_file_is_EOF(Asset_ &asset) { return asset.pkg_file.cursor >= asset.pkg_file.data.size(); }
+
+static void Package_file_Close(Asset_ &asset) {
+	PackageFile &f = asset.pkg_file;
+	Package_file_Free(f);
+	ReleasePackage(f.pkg);
+}
+
+static bool Package_file_is_EOF(Asset_ &asset) { return asset.pkg_file.cursor >= asset.pkg_file.size; }
 
 //
+// entries never move in memory, operations resolve the handle under lock then run unlocked
 static generational_vector_list<Asset_> assets;
+static Mutex assets_lock;
+
+static Asset AddAsset(const Asset_ &asset_) {
+	ScopedLock lock(assets_lock);
+	Asset asset;
+	asset.ref = assets.add_ref(asset_);
+	return asset;
+}
+
+static Asset_ *GetAsset_(Asset asset) {
+	ScopedLock lock(assets_lock);
+	return assets.is_valid(asset.ref) ? &assets[asset.ref.idx] : nullptr;
+}
 
 std::string FindAssetPath(const std::string &name) {
-	for (std::deque<std::string>::iterator i = assets_folders.begin(); i != assets_folders.end(); ++i) {
-		const std::string asset_path = PathJoin(*i, name);
-		if (IsFile(asset_path))
-			return asset_path;
-	}
-	return "";
+	const ScopedAssetsIndex index;
+	const AssetsIndex::Entry *entry = index.find(name);
+	if (!entry)
+		return ProbeAssetsFolders(index.index, name);
+	return entry->folder != -1 ? PathJoin(index.index->folders[entry->folder], entry->name) : "";
 }
 
-Asset OpenAsset(const std::string &name, bool silent) {
-	// look on filesystem
-	for (std::deque<std::string>::iterator i = assets_folders.begin(); i != assets_folders.end(); ++i) {
-		const std::string asset_path = PathJoin(*i, name);
-
-		const File file = Open(asset_path, true);
-
-		if (IsValid(file)) {
-			Asset_ asset_;
-			asset_.file = file;
-			asset_.get_size = Asset_file_GetSize;
-			asset_.read = Asset_file_Read;
-			asset_.seek = Asset_file_Seek;
-			asset_.tell = Asset_file_Tell;
-			asset_.close = Asset_file_Close;
-			asset_.is_eof = Asset_file_is_EOF;
-
-			Asset asset;
-			asset.ref = assets.add_ref(asset_);
-
-			return asset;
+static bool OpenPackageEntry(Package_ &pkg, mz_uint index, const std::string &name, bool silent, Asset_ &asset_) {
+	PackageFile &f = asset_.pkg_file;
+
+	f.pkg = &pkg;
+	f.index = index;
+	f.data = nullptr;
+	f.iter = nullptr;
+	f.stream = nullptr;
+	f.size = 0;
+	f.cursor = 0;
+
+	if (pkg.is_pack) {
+		const AssetPackEntry &entry = pkg.pack.entries[index];
+		f.size = size_t(entry.uncompressed_size);
+
+		if (entry.compression == APC_None)
+			f.data = GetAssetPackEntryData(pkg.pack, entry);
+		else if (!Package_file_Restart(f)) {
+			if (!silent)
+				warn(fmt::format("Failed to open asset '{}' from file '{}' (asset was found but failed to open)", name, pkg.filename));
+			return false;
+		}
+	} else {
+		ScopedLock lock(pkg.lock);
+
+		mz_zip_archive_file_stat stat;
+		if (mz_zip_reader_file_stat(&pkg.archive, f.index, &stat)) {
+			f.size = size_t(stat.m_uncomp_size);
+			f.data = GetStoredEntryData(pkg, stat);
+			if (!f.data)
+				f.iter = mz_zip_reader_extract_iter_new(&pkg.archive, f.index, 0);
+		}
+
+		if (!f.data && !f.iter) {
+			const mz_zip_error err = mz_zip_get_last_error(&pkg.archive);
+
+			if (!silent)
+				warn(fmt::format(
+					"Failed to open asset '{}' from file '{}' (asset was found but failed to open): {}", name, pkg.filename, mz_zip_get_error_string(err)));
+			return false;
 		}
 	}
 
-	// look in archive
-	for (std::deque<ZipPackage>::iterator i = assets_packages.begin(); i != assets_packages.end(); ++i) {
-		const int index = mz_zip_reader_locate_file(&i->archive, name.c_str(), nullptr, MZ_ZIP_FLAG_CASE_SENSITIVE);
-		if (index == -1)
-			continue; // missing file
+	AtomicAdd(pkg.ref_count, 1); // released when the asset is closed
 
-		size_t size;
-		void *data = mz_zip_reader_extract_to_heap(&i->archive, index, &size, 0);
+	asset_.get_size = Package_file_GetSize;
+	asset_.read = Package_file_Read;
+	asset_.seek = Package_file_Seek;
+	asset_.tell = Package_file_Tell;
+	asset_.close = Package_file_Close;
+	asset_.is_eof = Package_file_is_EOF;
+	return true;
+}
+
+static Asset OpenAssetFile(const File &file) {
+	Asset_ asset_;
+	asset_.file = file;
+	asset_.get_size = Asset_file_GetSize;
+	asset_.read = Asset_file_Read;
+	asset_.seek = Asset_file_Seek;
+	asset_.tell = Asset_file_Tell;
+	asset_.close = Asset_file_Close;
+	asset_.is_eof = Asset_file_is_EOF;
+	return AddAsset(asset_);
+}
+
+Asset OpenAsset(const std::string &name, bool silent) {
+	const ScopedAssetsIndex index;
+	const AssetsIndex::Entry *entry = index.find(name);
+
+	if (entry) {
+		if (entry->folder != -1) { // look on filesystem
+			const File file = Open(PathJoin(index.index->folders[entry->folder], entry->name), true);
 
-		if (data == nullptr) {
-			const mz_zip_error err = mz_zip_get_last_error(&i->archive);
+			if (IsValid(file))
+				return OpenAssetFile(file);
 
 			if (!silent)
-				warn(fmt::format(
-					"Failed to open asset '{}' from file '{}' (asset was found but failed to open): {}", name, i->filename, mz_zip_get_error_string(err)));
-			break;
+				warn(fmt::format("Failed to open asset '{}' (file was removed since its folder was scanned)", name));
+			return Asset();
 		}
 
 		Asset_ asset_;
-		asset_.pkg_file.data.resize(size);
-		memcpy(asset_.pkg_file.data.data(), data, size);
-		mz_free(data);
-		asset_.pkg_file.cursor = 0;
-		asset_.get_size = Package_file_GetSize;
-		asset_.read = Package_file_Read;
-		asset_.seek = Package_file_Seek;
-		asset_.tell = Package_file_Tell;
-		asset_.close = Package_file_Close;
-		asset_.is_eof = Package_file_is_EOF;
-
-		Asset asset;
-		asset.ref = assets.add_ref(asset_);
-
-		return asset;
+		if (OpenPackageEntry(*entry->pkg, entry->pkg_index, name, silent, asset_)) // look in archive
+			return AddAsset(asset_);
+		return Asset();
+	}
+
+	const std::string path = ProbeAssetsFolders(index.index, name);
+	if (!path.empty()) {
+		const File file = Open(path, true);
+		if (IsValid(file))
+			return OpenAssetFile(file);
 	}
 
 	if (!silent)
@@ -208,64 +703,54 @@ Asset OpenAsset(const std::string &name, bool silent) {
 }
 
 void Close(Asset asset) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		asset_.close(asset_);
+	Asset_ asset_;
+	{
+		ScopedLock lock(assets_lock);
+		if (!assets.is_valid(asset.ref))
+			return;
+		asset_ = assets[asset.ref.idx];
 		assets.remove_ref(asset.ref);
 	}
+	asset_.close(asset_); // package locks must not be taken while holding the asset table lock
 }
 
 bool IsAssetFile(const std::string &name) {
-	for (std::deque<std::string>::iterator i = assets_folders.begin(); i != assets_folders.end(); ++i)
-		if (IsFile(PathJoin(*i, name)))
-			return true;
-
-	// look in archive
-	for (std::deque<ZipPackage>::iterator i = assets_packages.begin(); i != assets_packages.end(); ++i)
-		if (mz_zip_reader_locate_file(&i->archive, name.c_str(), nullptr, MZ_ZIP_FLAG_CASE_SENSITIVE) != -1)
-			return true;
-
-	return false;
+	const ScopedAssetsIndex index;
+	return index.find(name) != nullptr || !ProbeAssetsFolders(index.index, name).empty();
 }
 
 size_t GetSize(Asset asset) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		return asset_.get_size(asset_);
-	}
-	return 0;
+	Asset_ *asset_ = GetAsset_(asset);
+	return asset_ ? asset_->get_size(*asset_) : 0;
 }
 
 size_t Read(Asset asset, void *data, size_t size) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		return asset_.read(asset_, data, size);
-	}
-	return 0;
+	Asset_ *asset_ = GetAsset_(asset);
+	return asset_ ? asset_->read(*asset_, data, size) : 0;
 }
 
 bool Seek(Asset asset, ptrdiff_t offset, SeekMode mode) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		return asset_.seek(asset_, offset, mode);
-	}
-	return false;
+	Asset_ *asset_ = GetAsset_(asset);
+	return asset_ ? asset_->seek(*asset_, offset, mode) : false;
 }
 
 size_t Tell(Asset asset) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		return asset_.tell(asset_);
-	}
-	return 0;
+	Asset_ *asset_ = GetAsset_(asset);
+	return asset_ ? asset_->tell(*asset_) : 0;
 }
 
 bool IsEOF(Asset asset) {
-	if (assets.is_valid(asset.ref)) {
-		Asset_ &asset_ = assets[asset.ref.idx];
-		return asset_.is_eof(asset_);
-	}
-	return false;
+	Asset_ *asset_ = GetAsset_(asset);
+	return asset_ ? asset_->is_eof(*asset_) : false;
+}
+
+const void *GetAssetData(Asset asset, size_t &size) {
+	Asset_ *asset_ = GetAsset_(asset);
+	if (!asset_ || asset_->read != Package_file_Read || !asset_->pkg_file.data)
+		return nullptr;
+
+	size = asset_->pkg_file.size;
+	return asset_->pkg_file.data;
 }
 
 //
@@ -16,11 +16,18 @@ namespace hg {
 bool AddAssetsFolder(const std::string &path);
 void RemoveAssetsFolder(const std::string &path);
 
-/// Mount an archive stored on the local filesystem as an assets source.
+/// Mount a zip archive or an asset pack stored on the local filesystem as an assets source.
 bool AddAssetsPackage(const std::string &path);
 void RemoveAssetsPackage(const std::string &path);
 
-//
+/**
+	Rescan the mounted folders.
+	Asset names are indexed when a source is mounted, files added to or removed from a mounted folder afterward are only seen once the index is refreshed.
+	Absolute names and names leaving their folder through ".." are not indexed, they are looked up in each mounted folder.
+*/
+void RefreshAssetsIndex();
+
+/// Asset handle, handles can be opened and closed from any thread but a handle must not be used by several threads at once.
 struct Asset {
 	gen_ref ref;
 };
@@ -37,6 +44,12 @@ bool Seek(Asset asset, ptrdiff_t offset, SeekMode seek);
 size_t Tell(Asset asset);
 bool IsEOF(Asset asset);
 
+/**
+	Return the content of an asset read in place from a mapped package, null if the asset content is not directly addressable (filesystem asset,
+	compressed entry or unmapped package). The memory remains valid until the asset is closed.
+*/
+const void *GetAssetData(Asset asset, size_t &size);
+
 std::string AssetToString(const std::string &name);
 Data AssetToData(const std::string &name);
 
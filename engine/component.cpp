@@ -12,7 +12,12 @@
 namespace hg {
 
 //
-void Scene::ReserveTransforms(const size_t count) { transforms.reserve(transforms.size() + count); }
+void Scene::ReserveTransforms(const size_t count) {
+	transforms.reserve(transforms.size() + count);
+	if (transforms.capacity() > transform_worlds.size())
+		transform_worlds.resize(transforms.capacity(), Mat4::Identity);
+}
+
 void Scene::ReserveCameras(const size_t count) { cameras.reserve(cameras.size() + count); }
 void Scene::ReserveObjects(const size_t count) { objects.reserve(objects.size() + count); }
 void Scene::ReserveLights(const size_t count) { lights.reserve(lights.size() + count); }
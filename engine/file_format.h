@@ -16,4 +16,6 @@ static const uint8_t MaterialMarker = 0x10;
 static const uint8_t ModelMarker = 0x20;
 static const uint8_t GeometryMarker = 0x30;
 
+static const uint8_t AssetPackMarker = 0x40;
+
 } // namespace hg
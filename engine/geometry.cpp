@@ -306,11 +306,7 @@ void SmoothVertexColor(Geometry &geo, const std::vector<uint32_t> &pol_index, co
 		tt += pol.vtx_count;
 	}
 
-#if __cpluscplus >= 201103L
-	geo.color = std::move(out);
-#else
-	geo.color = out;
-#endif
+	geo.color.swap(out);
 }
 
 //
@@ -3,24 +3,83 @@
 #include "foundation/file_rw_interface.h"
 #include "foundation/rw_interface.h"
 #include "foundation/file.h"
+#include "foundation/log.h"
 
 #include "engine/assets_rw_interface.h"
+#include "engine/json.h"
 
 #include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
 #include <rapidjson/writer.h>
 
+#include <fmt/format.h>
+
 namespace hg {
 
+// RapidJSON input stream over a reader, reads through a fixed size buffer
+class JsonReadStream {
+public:
+	typedef char Ch;
+
+	JsonReadStream(const Reader &ir_, const Handle &h_) : ir(ir_), h(h_), current(buffer), end(buffer), count(0), eof(false) { Fill(); }
+
+	Ch Peek() const { return *current; }
+	Ch Take() {
+		const Ch c = *current;
+		if (current < end) {
+			++current;
+			if (current == end)
+				Fill();
+		}
+		return c;
+	}
+	size_t Tell() const { return count + (current - buffer); }
+
+	// not implemented
+	Ch *PutBegin() { return 0; }
+	void Put(Ch) {}
+	void Flush() {}
+	size_t PutEnd(Ch *) { return 0; }
+
+private:
+	void Fill() {
+		count += end - buffer;
+
+		size_t size = 0;
+		if (!eof) {
+			size = ir.read(h, buffer, sizeof(buffer) - 1);
+			eof = size == 0;
+		}
+
+		current = buffer;
+		end = buffer + size;
+		*end = '\0'; // RapidJSON expects a null character past the end of the stream
+	}
+
+	const Reader &ir;
+	const Handle &h;
+
+	Ch buffer[16 * 1024 + 1];
+	Ch *current, *end;
+	size_t count;
+	bool eof;
+};
+
+static bool CheckJsonParseResult(const rapidjson::Document &doc) {
+	if (!doc.HasParseError())
+		return true;
+
+	warn(fmt::format("JSON parse error at offset {}: {}", doc.GetErrorOffset(), rapidjson::GetParseError_En(doc.GetParseError())));
+	return false;
+}
+
 bool LoadJson(const Reader &ir, const Handle &h, rapidjson::Document &doc) {
 	if (!ir.is_valid(h))
 		return false;
 
-	std::string str;
-	if (!Read(ir, h, str))
-		return false;
-
-	doc.Parse(str);
-	return true;
+	JsonReadStream is(ir, h);
+	doc.ParseStream(is);
+	return CheckJsonParseResult(doc);
 }
 
 bool LoadJsonFromFile(const std::string &path, rapidjson::Document &doc) {
@@ -31,6 +90,44 @@ bool LoadJsonFromAssets(const std::string &name, rapidjson::Document &doc) {
 	return LoadJson(g_assets_reader, ScopedReadHandle(g_assets_read_provider, name, true), doc);
 }
 
+//
+bool ReadJson(const Reader &ir, const Handle &h, JsonLoadContext &ctx) {
+	ctx.doc.SetNull();
+	ctx.allocator.Clear();
+
+	if (!ir.is_valid(h))
+		return false;
+
+	const size_t size = ir.size(h) - ir.tell(h);
+
+	ctx.buffer.resize(size + 1);
+	if (size && ir.read(h, &ctx.buffer[0], size) != size)
+		return false;
+	ctx.buffer[size] = '\0';
+	return true;
+}
+
+bool ParseJson(JsonLoadContext &ctx) {
+	ctx.doc.SetNull();
+	ctx.allocator.Clear();
+
+	if (ctx.buffer.empty())
+		ctx.buffer.push_back('\0');
+
+	ctx.doc.ParseInsitu(&ctx.buffer[0]);
+	return CheckJsonParseResult(ctx.doc);
+}
+
+bool LoadJson(const Reader &ir, const Handle &h, JsonLoadContext &ctx) { return ReadJson(ir, h, ctx) && ParseJson(ctx); }
+
+bool LoadJsonFromFile(const std::string &path, JsonLoadContext &ctx) {
+	return LoadJson(g_file_reader, ScopedReadHandle(g_file_read_provider, path, true), ctx);
+}
+
+bool LoadJsonFromAssets(const std::string &name, JsonLoadContext &ctx) {
+	return LoadJson(g_assets_reader, ScopedReadHandle(g_assets_read_provider, name, true), ctx);
+}
+
 bool SaveJsonToFile(const rapidjson::Value &js, const std::string &path) {
 	rapidjson::StringBuffer buffer;
 	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
@@ -6,6 +6,7 @@
 #include <rapidjson/rapidjson.h>
 
 #include <map>
+#include <vector>
 
 namespace hg {
 
@@ -92,15 +93,15 @@ inline void RigidBodyType_from_json(const rapidjson::Value &j, RigidBodyType &v)
 inline void CollisionType_to_json(rapidjson::Document &jd, rapidjson::Value &o, CollisionType v) {
 	if (v == CT_Sphere)
 		o.SetString("sphere", jd.GetAllocator());
-	if (v == CT_Cube)
+	else if (v == CT_Cube)
 		o.SetString("cube", jd.GetAllocator());
-	if (v == CT_Cone)
+	else if (v == CT_Cone)
 		o.SetString("cone", jd.GetAllocator());
-	if (v == CT_Capsule)
+	else if (v == CT_Capsule)
 		o.SetString("capsule", jd.GetAllocator());
-	if (v == CT_Cylinder)
+	else if (v == CT_Cylinder)
 		o.SetString("cylinder", jd.GetAllocator());
-	if (v == CT_Mesh)
+	else if (v == CT_Mesh)
 		o.SetString("mesh", jd.GetAllocator());
 	else
 		o.SetNull();
@@ -138,6 +139,8 @@ inline void to_json(rapidjson::Document &jd, rapidjson::Value &o, uint64_t v) {
 inline void from_json(const rapidjson::Value &j, uint64_t &v) { v = j.GetUint64(); }
 inline void to_json(rapidjson::Document &jd, rapidjson::Value &o, const std::string &v) { o.SetString(v, jd.GetAllocator()); }
 inline void from_json(const rapidjson::Value &j, std::string &v) { v = j.GetString(); }
+inline void to_json(rapidjson::Document &jd, rapidjson::Value &o, const atom &v) { o.SetString(v.str(), jd.GetAllocator()); }
+inline void from_json(const rapidjson::Value &j, atom &v) { v = atom(std::string(j.GetString(), j.GetStringLength())); }
 
 inline void to_json(rapidjson::Document &jd, rapidjson::Value &o, const Vec2 &v) {
 	o.SetArray();
@@ -310,6 +313,34 @@ bool LoadJson(const Reader &ir, const Handle &h, rapidjson::Document &doc);
 bool LoadJsonFromFile(const std::string &path, rapidjson::Document &doc);
 bool LoadJsonFromAssets(const std::string &name, rapidjson::Document &doc);
 
+/**
+	@short Reusable JSON load context.
+
+	The document is parsed in-situ from the context buffer and its values are allocated from the context memory pool.
+	Both are kept between loads so that loading a sequence of documents through the same context does not hit the heap.
+	A loaded document remains valid until the next load through its context.
+**/
+struct JsonLoadContext {
+	explicit JsonLoadContext(size_t pool_chunk_size = 64 * 1024) : allocator(pool_chunk_size), doc(&allocator) {}
+
+	std::vector<char> buffer;
+	rapidjson::MemoryPoolAllocator<> allocator;
+	rapidjson::Document doc;
+
+private:
+	JsonLoadContext(const JsonLoadContext &);
+	JsonLoadContext &operator=(const JsonLoadContext &);
+};
+
+/// Read a JSON document to the context buffer without parsing it, the buffer is null-terminated.
+bool ReadJson(const Reader &ir, const Handle &h, JsonLoadContext &ctx);
+/// Parse the context buffer in-situ, its content is modified by the operation.
+bool ParseJson(JsonLoadContext &ctx);
+
+bool LoadJson(const Reader &ir, const Handle &h, JsonLoadContext &ctx);
+bool LoadJsonFromFile(const std::string &path, JsonLoadContext &ctx);
+bool LoadJsonFromAssets(const std::string &name, JsonLoadContext &ctx);
+
 bool SaveJsonToFile(const rapidjson::Value &js, const std::string &path);
 
 #define for_json_object(I, V) for (rapidjson::Value::MemberIterator I = (V).MemberBegin(); I != (V).MemberEnd(); ++I)
@@ -6,7 +6,9 @@
 #include "foundation/math.h"
 #include "foundation/profiler.h"
 
+#include <algorithm>
 #include <fmt/format.h>
+#include <string.h>
 #include <vector>
 
 namespace hg {
@@ -17,11 +19,24 @@ namespace hg {
 #define DDSD_WIDTH 0x00000004l
 #define DDSD_PITCH 0x00000008l
 #define DDSD_PIXELFORMAT 0x00001000l
+#define DDSD_MIPMAPCOUNT 0x00020000l
 #define DDSD_LINEARSIZE 0x00080000l
 
+#define MAKEFOURCC(a, b, c, d) (uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24))
+
 #define DDPF_ALPHAPIXELS 0x00000001l
+#define DDPF_ALPHA 0x00000002l
 #define DDPF_FOURCC 0x00000004l
 #define DDPF_RGB 0x00000040l
+#define DDPF_LUMINANCE 0x00020000l
+
+#define DDSCAPS2_CUBEMAP 0x00000200l
+#define DDSCAPS2_CUBEMAP_ALLFACES 0x0000fc00l
+#define DDSCAPS2_VOLUME 0x00200000l
+
+// from d3d10.h
+#define D3D10_RESOURCE_DIMENSION_TEXTURE2D 3
+#define D3D10_RESOURCE_MISC_TEXTURECUBE 0x4l
 
 struct DDPIXELFORMAT {
 	uint32_t dwSize;
@@ -88,101 +103,461 @@ __attribute__((packed))
 #endif
 ;
 
+struct DDS_HEADER_DXT10 {
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+// in place conversion of 32 bit pixels to RGBA8
+enum DDSSwizzle { DDSS_None, DDSS_BGRA, DDSS_BGRX, DDSS_RGBX };
+
 //
 static sg_pixel_format FourCCPixelFormat(uint32_t fourcc) {
-	if (fourcc == '2CTE') {
-		return SG_PIXELFORMAT_ETC2_RGB8;
+	switch (fourcc) {
+		case MAKEFOURCC('D', 'X', 'T', '1'):
+			return SG_PIXELFORMAT_BC1_RGBA;
+		case MAKEFOURCC('D', 'X', 'T', '2'):
+		case MAKEFOURCC('D', 'X', 'T', '3'):
+			return SG_PIXELFORMAT_BC2_RGBA;
+		case MAKEFOURCC('D', 'X', 'T', '4'):
+		case MAKEFOURCC('D', 'X', 'T', '5'):
+			return SG_PIXELFORMAT_BC3_RGBA;
+		case MAKEFOURCC('A', 'T', 'I', '1'):
+		case MAKEFOURCC('B', 'C', '4', 'U'):
+			return SG_PIXELFORMAT_BC4_R;
+		case MAKEFOURCC('B', 'C', '4', 'S'):
+			return SG_PIXELFORMAT_BC4_RSN;
+		case MAKEFOURCC('A', 'T', 'I', '2'):
+		case MAKEFOURCC('B', 'C', '5', 'U'):
+			return SG_PIXELFORMAT_BC5_RG;
+		case MAKEFOURCC('B', 'C', '5', 'S'):
+			return SG_PIXELFORMAT_BC5_RGSN;
+
+		// ETC2/EAC have no standard FourCC, these are the codes written by common encoders
+		case MAKEFOURCC('E', 'T', 'C', '2'):
+			return SG_PIXELFORMAT_ETC2_RGB8;
+		case MAKEFOURCC('E', 'T', 'C', 'P'):
+			return SG_PIXELFORMAT_ETC2_RGB8A1;
+		case MAKEFOURCC('E', 'T', 'C', 'A'):
+			return SG_PIXELFORMAT_ETC2_RGBA8;
+		case MAKEFOURCC('E', 'A', 'C', '2'):
+			return SG_PIXELFORMAT_ETC2_RG11;
+		case MAKEFOURCC('E', 'A', 'S', '2'):
+			return SG_PIXELFORMAT_ETC2_RG11SN;
+
+		// D3DFORMAT values stored as FourCC
+		case 36: // D3DFMT_A16B16G16R16
+			return SG_PIXELFORMAT_RGBA16;
+		case 110: // D3DFMT_Q16W16V16U16
+			return SG_PIXELFORMAT_RGBA16SN;
+		case 111: // D3DFMT_R16F
+			return SG_PIXELFORMAT_R16F;
+		case 112: // D3DFMT_G16R16F
+			return SG_PIXELFORMAT_RG16F;
+		case 113: // D3DFMT_A16B16G16R16F
+			return SG_PIXELFORMAT_RGBA16F;
+		case 114: // D3DFMT_R32F
+			return SG_PIXELFORMAT_R32F;
+		case 115: // D3DFMT_G32R32F
+			return SG_PIXELFORMAT_RG32F;
+		case 116: // D3DFMT_A32B32G32R32F
+			return SG_PIXELFORMAT_RGBA32F;
+	}
+
+	return _SG_PIXELFORMAT_NUM;
+}
+
+// sRGB formats have no sokol equivalent, sampling them as linear would skip the sRGB decode
+static bool IsDXGISRGBFormat(uint32_t dxgi) {
+	switch (dxgi) {
+		case 29: // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+		case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+		case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+		case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+		case 91: // DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+		case 93: // DXGI_FORMAT_B8G8R8X8_UNORM_SRGB
+		case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+			return true;
+	}
+	return false;
+}
+
+static sg_pixel_format DXGIPixelFormat(uint32_t dxgi, DDSSwizzle &swizzle) {
+	switch (dxgi) {
+		case 2: // DXGI_FORMAT_R32G32B32A32_FLOAT
+			return SG_PIXELFORMAT_RGBA32F;
+		case 10: // DXGI_FORMAT_R16G16B16A16_FLOAT
+			return SG_PIXELFORMAT_RGBA16F;
+		case 11: // DXGI_FORMAT_R16G16B16A16_UNORM
+			return SG_PIXELFORMAT_RGBA16;
+		case 13: // DXGI_FORMAT_R16G16B16A16_SNORM
+			return SG_PIXELFORMAT_RGBA16SN;
+		case 16: // DXGI_FORMAT_R32G32_FLOAT
+			return SG_PIXELFORMAT_RG32F;
+		case 24: // DXGI_FORMAT_R10G10B10A2_UNORM
+			return SG_PIXELFORMAT_RGB10A2;
+		case 26: // DXGI_FORMAT_R11G11B10_FLOAT
+			return SG_PIXELFORMAT_RG11B10F;
+		case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+			return SG_PIXELFORMAT_RGBA8;
+		case 31: // DXGI_FORMAT_R8G8B8A8_SNORM
+			return SG_PIXELFORMAT_RGBA8SN;
+		case 34: // DXGI_FORMAT_R16G16_FLOAT
+			return SG_PIXELFORMAT_RG16F;
+		case 35: // DXGI_FORMAT_R16G16_UNORM
+			return SG_PIXELFORMAT_RG16;
+		case 41: // DXGI_FORMAT_R32_FLOAT
+			return SG_PIXELFORMAT_R32F;
+		case 49: // DXGI_FORMAT_R8G8_UNORM
+			return SG_PIXELFORMAT_RG8;
+		case 54: // DXGI_FORMAT_R16_FLOAT
+			return SG_PIXELFORMAT_R16F;
+		case 56: // DXGI_FORMAT_R16_UNORM
+			return SG_PIXELFORMAT_R16;
+		case 61: // DXGI_FORMAT_R8_UNORM
+			return SG_PIXELFORMAT_R8;
+		case 71: // DXGI_FORMAT_BC1_UNORM
+			return SG_PIXELFORMAT_BC1_RGBA;
+		case 74: // DXGI_FORMAT_BC2_UNORM
+			return SG_PIXELFORMAT_BC2_RGBA;
+		case 77: // DXGI_FORMAT_BC3_UNORM
+			return SG_PIXELFORMAT_BC3_RGBA;
+		case 80: // DXGI_FORMAT_BC4_UNORM
+			return SG_PIXELFORMAT_BC4_R;
+		case 81: // DXGI_FORMAT_BC4_SNORM
+			return SG_PIXELFORMAT_BC4_RSN;
+		case 83: // DXGI_FORMAT_BC5_UNORM
+			return SG_PIXELFORMAT_BC5_RG;
+		case 84: // DXGI_FORMAT_BC5_SNORM
+			return SG_PIXELFORMAT_BC5_RGSN;
+		case 87: // DXGI_FORMAT_B8G8R8A8_UNORM
+			swizzle = DDSS_BGRA;
+			return SG_PIXELFORMAT_RGBA8;
+		case 88: // DXGI_FORMAT_B8G8R8X8_UNORM
+			swizzle = DDSS_BGRX;
+			return SG_PIXELFORMAT_RGBA8;
+		case 95: // DXGI_FORMAT_BC6H_UF16
+			return SG_PIXELFORMAT_BC6H_RGBUF;
+		case 96: // DXGI_FORMAT_BC6H_SF16
+			return SG_PIXELFORMAT_BC6H_RGBF;
+		case 98: // DXGI_FORMAT_BC7_UNORM
+			return SG_PIXELFORMAT_BC7_RGBA;
+	}
+
+	return _SG_PIXELFORMAT_NUM;
+}
+
+static sg_pixel_format MaskPixelFormat(const DDPIXELFORMAT &pf, DDSSwizzle &swizzle) {
+	const bool alpha = (pf.dwFlags & DDPF_ALPHAPIXELS) != 0;
+
+	if (pf.dwFlags & DDPF_RGB) {
+		if (pf.dwRGBBitCount == 32) {
+			if (pf.dwRBitMask == 0x000000ff && pf.dwGBitMask == 0x0000ff00 && pf.dwBBitMask == 0x00ff0000) {
+				swizzle = alpha && pf.dwRGBAlphaBitMask == 0xff000000 ? DDSS_None : DDSS_RGBX;
+				return SG_PIXELFORMAT_RGBA8;
+			}
+			if (pf.dwRBitMask == 0x00ff0000 && pf.dwGBitMask == 0x0000ff00 && pf.dwBBitMask == 0x000000ff) {
+				swizzle = alpha && pf.dwRGBAlphaBitMask == 0xff000000 ? DDSS_BGRA : DDSS_BGRX;
+				return SG_PIXELFORMAT_RGBA8;
+			}
+			if (pf.dwRBitMask == 0x000003ff && pf.dwGBitMask == 0x000ffc00 && pf.dwBBitMask == 0x3ff00000)
+				return SG_PIXELFORMAT_RGB10A2;
+			if (pf.dwRBitMask == 0x0000ffff && pf.dwGBitMask == 0xffff0000)
+				return SG_PIXELFORMAT_RG16;
+		} else if (pf.dwRGBBitCount == 16) {
+			if (pf.dwRBitMask == 0x00ff && pf.dwGBitMask == 0xff00)
+				return SG_PIXELFORMAT_RG8;
+		}
+	} else if (pf.dwFlags & DDPF_LUMINANCE) {
+		if (pf.dwRGBBitCount == 8)
+			return SG_PIXELFORMAT_R8;
+		if (pf.dwRGBBitCount == 16)
+			return alpha ? SG_PIXELFORMAT_RG8 : SG_PIXELFORMAT_R16;
+	} else if (pf.dwFlags & DDPF_ALPHA) {
+		if (pf.dwRGBBitCount == 8)
+			return SG_PIXELFORMAT_R8;
 	}
 
 	return _SG_PIXELFORMAT_NUM;
 }
 
+// size of a 4x4 block, 0 if the format is not block compressed
+static size_t GetBlockSize(sg_pixel_format format) {
+	switch (format) {
+		case SG_PIXELFORMAT_BC1_RGBA:
+		case SG_PIXELFORMAT_BC4_R:
+		case SG_PIXELFORMAT_BC4_RSN:
+		case SG_PIXELFORMAT_ETC2_RGB8:
+		case SG_PIXELFORMAT_ETC2_RGB8A1:
+			return 8;
+		case SG_PIXELFORMAT_BC2_RGBA:
+		case SG_PIXELFORMAT_BC3_RGBA:
+		case SG_PIXELFORMAT_BC5_RG:
+		case SG_PIXELFORMAT_BC5_RGSN:
+		case SG_PIXELFORMAT_BC6H_RGBF:
+		case SG_PIXELFORMAT_BC6H_RGBUF:
+		case SG_PIXELFORMAT_BC7_RGBA:
+		case SG_PIXELFORMAT_ETC2_RGBA8:
+		case SG_PIXELFORMAT_ETC2_RG11:
+		case SG_PIXELFORMAT_ETC2_RG11SN:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+static size_t GetPixelSize(sg_pixel_format format) {
+	switch (format) {
+		case SG_PIXELFORMAT_R8:
+			return 1;
+		case SG_PIXELFORMAT_R16:
+		case SG_PIXELFORMAT_R16F:
+		case SG_PIXELFORMAT_RG8:
+			return 2;
+		case SG_PIXELFORMAT_R32F:
+		case SG_PIXELFORMAT_RG16:
+		case SG_PIXELFORMAT_RG16F:
+		case SG_PIXELFORMAT_RGBA8:
+		case SG_PIXELFORMAT_RGBA8SN:
+		case SG_PIXELFORMAT_RGB10A2:
+		case SG_PIXELFORMAT_RG11B10F:
+			return 4;
+		case SG_PIXELFORMAT_RG32F:
+		case SG_PIXELFORMAT_RGBA16:
+		case SG_PIXELFORMAT_RGBA16SN:
+		case SG_PIXELFORMAT_RGBA16F:
+			return 8;
+		case SG_PIXELFORMAT_RGBA32F:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+static uint64_t GetSurfaceSize(sg_pixel_format format, uint32_t width, uint32_t height) {
+	const size_t block_size = GetBlockSize(format);
+	if (block_size)
+		return uint64_t(Max<uint32_t>(1, (width + 3) / 4)) * Max<uint32_t>(1, (height + 3) / 4) * block_size;
+	return uint64_t(width) * height * GetPixelSize(format);
+}
+
+static void SwizzleToRGBA8(uint8_t *p, size_t size, DDSSwizzle swizzle) {
+	for (uint8_t *end = p + size; p < end; p += 4) {
+		if (swizzle == DDSS_BGRA || swizzle == DDSS_BGRX)
+			std::swap(p[0], p[2]);
+		if (swizzle != DDSS_BGRA)
+			p[3] = 0xff;
+	}
+}
+
 //
-Texture LoadDDS(const Reader &ir, const Handle &h, const std::string &name) {
+bool LoadDDS(const Reader &ir, const Handle &h, const std::string &name, TextureData &data, bool silent) {
 	ProfilerPerfSection section("LoadDDS", name);
 
-	Texture tex;
-	tex.image.id = SG_INVALID_ID;
+	if (!ir.is_valid(h))
+		return false;
 
 	const uint32_t magic = Read<uint32_t>(ir, h);
-	if (magic != ' SDD')
-		return tex;
+	if (magic != MAKEFOURCC('D', 'D', 'S', ' '))
+		return false;
 
 	DDSURFACEDESC2 header;
-	ir.read(h, &header, sizeof(DDSURFACEDESC2));
+	if (ir.read(h, &header, sizeof(DDSURFACEDESC2)) != sizeof(DDSURFACEDESC2) || header.dwSize != 124)
+		return false;
 
-	if (header.dwSize != 124)
-		return tex;
+	if (!silent) {
+		log(fmt::format("Load DDS '{}'", name));
+		log(fmt::format("    Size: {}x{} Mips: {}", header.dwWidth, header.dwHeight, header.dwMipMapCount));
+	}
+
+	if (!header.dwWidth || !header.dwHeight) {
+		if (!silent)
+			warn("    Invalid header!");
+		return false;
+	}
+
+	// the largest texture with a full mip chain the renderer supports, also bounds the surface size computations
+	const uint32_t max_size = 1 << (SG_MAX_MIPMAPS - 1);
+	if (header.dwWidth > max_size || header.dwHeight > max_size) {
+		if (!silent)
+			warn(fmt::format("    Texture too large (max {}x{})", max_size, max_size));
+		return false;
+	}
 
-	log(fmt::format("Load DDS '{}'", name));
-	log(fmt::format("    Size: {}x{} Mips: {}", header.dwWidth, header.dwHeight, header.dwMipMapCount));
+	const DDPIXELFORMAT &pf = header.ddpfPixelFormat;
 
-	if (header.ddpfPixelFormat.dwFlags & DDPF_RGB) {
-		size_t pitch = header.dwWidth * header.ddpfPixelFormat.dwRGBBitCount / 8;
+	sg_pixel_format format = _SG_PIXELFORMAT_NUM;
+	DDSSwizzle swizzle = DDSS_None;
 
-		if (header.dwFlags & DDSD_PITCH)
-			pitch = header.dwPitchOrLinearSize;
+	bool cube = false;
+	uint32_t layer_count = 1;
 
-		if (header.ddpfPixelFormat.dwRGBBitCount == 32) {
-			assert(header.ddpfPixelFormat.dwRBitMask == 0x00ff0000);
-			assert(header.ddpfPixelFormat.dwGBitMask == 0x0000ff00);
-			assert(header.ddpfPixelFormat.dwBBitMask == 0x000000ff);
+	if ((pf.dwFlags & DDPF_FOURCC) && pf.dwFourCC == MAKEFOURCC('D', 'X', '1', '0')) {
+		DDS_HEADER_DXT10 dx10;
+		if (ir.read(h, &dx10, sizeof(DDS_HEADER_DXT10)) != sizeof(DDS_HEADER_DXT10)) {
+			if (!silent)
+				warn("    Invalid header!");
+			return false;
+		}
 
-			if (header.ddpfPixelFormat.dwFlags & DDPF_ALPHAPIXELS)
-				assert(header.ddpfPixelFormat.dwRGBAlphaBitMask == 0xff000000);
+		if (!silent)
+			log(fmt::format("    DXGI format: {}", dx10.dxgiFormat));
 
-			std::vector<uint8_t> rgba;
-			rgba.resize(header.dwWidth * header.dwHeight * 4);
+		if (dx10.resourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D) {
+			if (!silent)
+				warn("    Unsupported resource dimension, only 2D textures, cubemaps and arrays are supported");
+			return false;
+		}
 
-			uint8_t *dst = &rgba[0];
+		if (IsDXGISRGBFormat(dx10.dxgiFormat)) {
+			if (!silent)
+				warn(fmt::format("    Unsupported sRGB pixel format (DXGI format {})", dx10.dxgiFormat));
+			return false;
+		}
 
-			std::vector<uint8_t> line(pitch * 4);
-			for (size_t y = 0; y < header.dwHeight; ++y) {
-				uint8_t *src = &line[0];
-				ir.read(h, src, pitch);
+		format = DXGIPixelFormat(dx10.dxgiFormat, swizzle);
+		cube = (dx10.miscFlag & D3D10_RESOURCE_MISC_TEXTURECUBE) != 0;
+		layer_count = Max<uint32_t>(dx10.arraySize, 1);
+	} else {
+		if (header.ddsCaps.dwCaps2 & DDSCAPS2_VOLUME) {
+			if (!silent)
+				warn("    Unsupported volume texture");
+			return false;
+		}
 
-				for (size_t x = 0; x < header.dwWidth; ++x, dst += 4, src += 4) {
-					dst[0] = src[2]; // R
-					dst[1] = src[1]; // G
-					dst[2] = src[0]; // B
-					dst[3] = src[3]; // A
-				}
+		if (header.ddsCaps.dwCaps2 & DDSCAPS2_CUBEMAP) {
+			if ((header.ddsCaps.dwCaps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+				if (!silent)
+					warn("    Unsupported partial cubemap");
+				return false;
 			}
+			cube = true;
+		}
+
+		if (pf.dwFlags & DDPF_FOURCC) {
+			if (!silent)
+				log(fmt::format("    FourCC: {}", std::string((const char *)(&pf.dwFourCC), 4)));
+			format = FourCCPixelFormat(pf.dwFourCC);
 		} else {
-			warn(fmt::format("    Unsupported bit count: {}", header.ddpfPixelFormat.dwRGBBitCount));
+			format = MaskPixelFormat(pf, swizzle);
+		}
+	}
+
+	if (format == _SG_PIXELFORMAT_NUM) {
+		if (!silent)
+			warn("    Unsupported pixel format");
+		return false;
+	}
+
+	if (cube && layer_count > 1) {
+		if (!silent)
+			warn("    Unsupported cubemap array");
+		return false;
+	}
+
+	if (layer_count > SG_MAX_TEXTUREARRAY_LAYERS) {
+		if (!silent)
+			warn(fmt::format("    Too many array layers ({}, max {})", layer_count, int(SG_MAX_TEXTUREARRAY_LAYERS)));
+		return false;
+	}
+
+	// mip chain, at most the full chain length
+	int chain_length = 1;
+	for (uint32_t size = Max(header.dwWidth, header.dwHeight); size > 1; size /= 2)
+		++chain_length;
+
+	if (header.dwMipMapCount > uint32_t(chain_length)) {
+		if (!silent)
+			warn(fmt::format("    Invalid mip count ({}, max {})", header.dwMipMapCount, chain_length));
+		return false;
+	}
+
+	const int mip_count = Max<int>(header.dwMipMapCount, 1);
+
+	// sizes are computed on 64 bits and only narrowed once checked against the file size
+	std::vector<uint64_t> mip_sizes(mip_count);
+	uint64_t element_size = 0; // a cube face or array layer with its mip chain, as stored in the file
+
+	for (int i = 0; i < mip_count; ++i) {
+		mip_sizes[i] = GetSurfaceSize(format, Max<uint32_t>(header.dwWidth >> i, 1), Max<uint32_t>(header.dwHeight >> i, 1));
+		element_size += mip_sizes[i];
+	}
+
+	const uint64_t element_count = cube ? uint64_t(SG_CUBEFACE_NUM) : uint64_t(layer_count);
+	const uint64_t remaining = ir.size(h) - ir.tell(h);
+
+	if (remaining < element_size * element_count) {
+		if (element_count > 1) {
+			if (!silent)
+				warn("    Truncated file");
+			return false;
 		}
-	} else if (header.ddpfPixelFormat.dwFlags & DDPF_FOURCC) {
-		log(fmt::format("    FourCC: {}", (const char *)(&header.ddpfPixelFormat.dwFourCC)));
-
-		const size_t size = ir.size(h);
-		const size_t remaining = size - ir.tell(h);
-
-		std::vector<uint8_t> payload(remaining);
-		ir.read(h, payload.data(), remaining);
-
-		sg_image_desc desc;
-		memset(&desc, 0, sizeof(sg_image_desc));
-		desc.width = header.dwWidth;
-		desc.height = header.dwHeight;
-		desc.pixel_format = FourCCPixelFormat(header.ddpfPixelFormat.dwFourCC);
-		desc.min_filter = SG_FILTER_LINEAR;
-		desc.mag_filter = SG_FILTER_LINEAR;
-		desc.num_mipmaps = header.dwMipMapCount;
-
-		uint8_t *mip_data = payload.data();
-		for (int i = 0, w = desc.width, h = desc.height; i < desc.num_mipmaps; ++i, w /= 2, h /= 2) {
-			const size_t mip_size = Max(8, (w * h) / 2);
-			desc.data.subimage[0][i].ptr = mip_data;
-			desc.data.subimage[0][i].size = mip_size;
-			mip_data += mip_size;
+
+		if (!silent)
+			warn("    Truncated mip chain");
+		while (!mip_sizes.empty() && element_size > remaining) {
+			element_size -= mip_sizes.back();
+			mip_sizes.pop_back();
 		}
 
-		tex.image = sg_make_image(&desc);
+		if (mip_sizes.empty())
+			return false;
+	}
+
+	// read the whole payload at once, the texture is created straight from this buffer
+	data.data.resize(size_t(element_size * element_count));
+	if (ir.read(h, &data.data[0], data.data.size()) != data.data.size()) {
+		if (!silent)
+			warn("    Failed to read texture data");
+		return false;
+	}
+
+	if (swizzle != DDSS_None)
+		SwizzleToRGBA8(&data.data[0], data.data.size(), swizzle);
+
+	data.width = header.dwWidth;
+	data.height = header.dwHeight;
+	data.format = format;
+
+	if (cube) {
+		data.type = SG_IMAGETYPE_CUBE;
+		data.slice_count = 1;
+		data.mips.assign(mip_sizes.begin(), mip_sizes.end());
+	} else if (layer_count > 1) {
+		data.type = SG_IMAGETYPE_ARRAY;
+		data.slice_count = int(layer_count);
+
+		data.mips.resize(mip_sizes.size());
+		for (size_t i = 0; i < mip_sizes.size(); ++i)
+			data.mips[i] = size_t(mip_sizes[i] * layer_count);
+
+		if (mip_sizes.size() > 1) { // layers are stored with their mip chain, regroup them by mip level
+			std::vector<uint8_t> layers(data.data.size());
+
+			size_t dst = 0;
+			for (size_t i = 0, src_mip = 0; i < mip_sizes.size(); src_mip += size_t(mip_sizes[i]), ++i)
+				for (uint32_t layer = 0; layer < layer_count; ++layer, dst += size_t(mip_sizes[i]))
+					memcpy(&layers[dst], &data.data[size_t(layer * element_size) + src_mip], size_t(mip_sizes[i]));
+
+			data.data.swap(layers);
+		}
 	} else {
-		warn("    Invalid header!");
+		data.type = SG_IMAGETYPE_2D;
+		data.slice_count = 1;
+		data.mips.assign(mip_sizes.begin(), mip_sizes.end());
 	}
 
-	return tex;
+	return true;
+}
+
+Texture LoadDDS(const Reader &ir, const Handle &h, const std::string &name, bool silent) {
+	TextureData data;
+	if (!LoadDDS(ir, h, name, data, silent))
+		return MakeTexture(TextureData());
+	return MakeTexture(data);
 }
 
 } // namespace hg
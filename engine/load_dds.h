@@ -6,6 +6,8 @@
 
 namespace hg {
 
-Texture LoadDDS(const Reader &ir, const Handle &h, const std::string &name);
+/// Read a DDS file content without creating any GPU resource, can be called from any thread.
+bool LoadDDS(const Reader &ir, const Handle &h, const std::string &name, TextureData &data, bool silent = false);
+Texture LoadDDS(const Reader &ir, const Handle &h, const std::string &name, bool silent = false);
 
 } // namespace hg
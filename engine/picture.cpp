@@ -4,6 +4,7 @@
 
 #include <assert.h>
 
+#include "foundation/allocator.h"
 #include "foundation/cext.h"
 #include "foundation/file.h"
 #include "foundation/math.h"
@@ -35,13 +36,13 @@ size_t GetChannelCount(PictureFormat format) {
 Picture::Picture() : w(0), h(0), f(PF_None), has_ownership(0), d(nullptr) {}
 
 Picture::Picture(uint16_t width, uint16_t height, PictureFormat format)
-	: w(width), h(height), f(format), has_ownership(1), d(new uint8_t[w * h * size_of(f)]) {}
+	: w(width), h(height), f(format), has_ownership(1), d(reinterpret_cast<uint8_t *>(Allocate(w * h * size_of(f), MT_Picture))) {}
 
 Picture::Picture(void *data, uint16_t width, uint16_t height, PictureFormat format)
 	: w(width), h(height), f(format), has_ownership(0), d(reinterpret_cast<uint8_t *>(data)) {}
 
 Picture::Picture(const Picture &pic)
-	: w(pic.w), h(pic.h), f(pic.f), has_ownership(pic.has_ownership), d(pic.has_ownership ? new uint8_t[w * h * size_of(f)] : pic.d) {
+	: w(pic.w), h(pic.h), f(pic.f), has_ownership(pic.has_ownership), d(pic.has_ownership ? reinterpret_cast<uint8_t *>(Allocate(w * h * size_of(f), MT_Picture)) : pic.d) {
 	if (pic.has_ownership)
 		std::copy(pic.d, pic.d + w * h * size_of(f), d);
 }
@@ -68,7 +69,7 @@ void Picture::CopyData(const void *data, uint16_t width, uint16_t height, Pictur
 	f = format;
 
 	has_ownership = 1;
-	d = new uint8_t[w * h * size_of(f)];
+	d = reinterpret_cast<uint8_t *>(Allocate(w * h * size_of(f), MT_Picture));
 	std::copy(reinterpret_cast<const uint8_t *>(data), reinterpret_cast<const uint8_t *>(data) + w * h * size_of(f), d);
 }
 
@@ -76,7 +77,7 @@ void Picture::TakeDataOwnership() {
 	if (has_ownership || d == nullptr)
 		return;
 
-	uint8_t *d_ = new uint8_t[w * h * size_of(f)];
+	uint8_t *d_ = reinterpret_cast<uint8_t *>(Allocate(w * h * size_of(f), MT_Picture));
 	std::copy(d, d + w * h * size_of(f), d_);
 
 	has_ownership = 1;
@@ -107,11 +108,12 @@ Picture MakePicture(const void *data, uint16_t width, uint16_t height, PictureFo
 
 //
 void Picture::Clear() {
+	if (has_ownership)
+		Deallocate(d, w * h * size_of(f), MT_Picture);
+
 	w = h = 0;
 	f = PF_None;
 
-	if (has_ownership)
-		delete[](reinterpret_cast<uint8_t *>(d));
 	has_ownership = 0;
 	d = nullptr;
 }
@@ -257,12 +259,15 @@ bool SaveHDR(const Picture &pic, const std::string &path) {
 Picture::Picture(Picture &&pic) noexcept : w(pic.w), h(pic.h), f(pic.f), has_ownership(pic.has_ownership), d(pic.d) {
 	pic.w = 0;
 	pic.h = 0;
-	pic.f = PF_RGBA32;
+	pic.f = PF_None;
 	pic.has_ownership = 0;
 	pic.d = nullptr;
 }
 
 Picture &Picture::operator=(Picture &&pic) noexcept {
+	if (&pic == this)
+		return *this;
+
 	Clear();
 
 	w = pic.w;
@@ -274,7 +279,7 @@ Picture &Picture::operator=(Picture &&pic) noexcept {
 
 	pic.w = 0;
 	pic.h = 0;
-	pic.f = PF_RGBA32;
+	pic.f = PF_None;
 
 	pic.has_ownership = 0;
 	pic.d = nullptr;
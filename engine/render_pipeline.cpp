@@ -7,6 +7,7 @@
 
 #include "foundation/file.h"
 #include "foundation/file_rw_interface.h"
+#include "foundation/job.h"
 #include "foundation/log.h"
 #include "foundation/matrix3.h"
 #include "foundation/matrix4.h"
@@ -17,9 +18,11 @@
 #include "foundation/projection.h"
 #include "foundation/time.h"
 
+#include <algorithm>
 #include <fmt/format.h>
 #include <rapidjson/document.h>
 #include <set>
+#include <xxhash.h>
 
 #define SOKOL_GFX_IMPL
 #include <sokol_gfx.h>
@@ -27,10 +30,54 @@
 namespace hg {
 
 void Destroy(PipelineProgram &) {}
-void Destroy(Model &) {}
+
+void Destroy(Model &model) {
+	if (sg_isvalid())
+		for (std::vector<DisplayList>::iterator i = model.lists.begin(); i != model.lists.end(); ++i) {
+			sg_destroy_buffer(i->index_buffer);
+			sg_destroy_buffer(i->vertex_buffer);
+		}
+	model.lists.clear();
+}
+
 void Destroy(Material &) {}
 
-void PipelineResources::DestroyAll() {}
+template <typename Load> static void DeleteLoads(std::vector<Load *> &loads) {
+	for (typename std::vector<Load *>::iterator i = loads.begin(); i != loads.end(); ++i)
+		delete *i;
+	loads.clear();
+}
+
+// unpin and drop the placeholders of loads that will never complete
+template <typename Load, typename T> static void CancelLoads(std::vector<Load *> &loads, ResourceCache<T> &cache) {
+	for (typename std::vector<Load *>::iterator i = loads.begin(); i != loads.end(); ++i) {
+		cache.Unpin((*i)->ref);
+		cache.Destroy((*i)->ref);
+	}
+	DeleteLoads(loads);
+}
+
+static uint32_t pipeline_resources_uid = 0;
+
+PipelineResources::PipelineResources()
+	: uid(++pipeline_resources_uid), /*programs(Destroy),*/ textures(Destroy), materials(Destroy), models(Destroy), deduplicate_content(false),
+	  load_order(0) {}
+
+void PipelineResources::DestroyAll() {
+	WaitJobCounter(load_jobs);
+
+	CancelLoads(texture_loads, textures);
+	CancelLoads(texture_loads_in_flight, textures);
+	texture_load_status.clear();
+
+	CancelLoads(model_loads, models);
+	CancelLoads(model_loads_in_flight, models);
+	model_load_status.clear();
+
+	textures.DestroyAll();
+	materials.DestroyAll();
+	models.DestroyAll();
+}
 
 #if 0
 
@@ -277,6 +324,76 @@ sg_buffer MakeVertexBuffer(const void *data, size_t size) {
 	return sg_make_buffer(&buffer_desc);
 }
 
+Texture MakeTexture(const TextureData &data) {
+	Texture tex;
+	tex.image.id = SG_INVALID_ID;
+
+	if (data.data.empty() || data.mips.empty() || data.mips.size() > SG_MAX_MIPMAPS)
+		return tex;
+
+	const int face_count = data.type == SG_IMAGETYPE_CUBE ? SG_CUBEFACE_NUM : 1;
+
+	size_t face_size = 0;
+	for (size_t i = 0; i < data.mips.size(); ++i)
+		face_size += data.mips[i];
+
+	if (face_size * face_count > data.data.size())
+		return tex;
+
+	sg_image_desc desc;
+	memset(&desc, 0, sizeof(sg_image_desc));
+	desc.type = data.type;
+	desc.width = data.width;
+	desc.height = data.height;
+	desc.num_slices = data.type == SG_IMAGETYPE_ARRAY ? data.slice_count : 1;
+	desc.pixel_format = data.format;
+	desc.min_filter = data.mips.size() > 1 ? SG_FILTER_LINEAR_MIPMAP_LINEAR : SG_FILTER_LINEAR;
+	desc.mag_filter = SG_FILTER_LINEAR;
+	desc.num_mipmaps = int(data.mips.size());
+
+	size_t offset = 0; // subimages point straight into the decoded data
+	for (int face = 0; face < face_count; ++face)
+		for (size_t i = 0; i < data.mips.size(); ++i) {
+			desc.data.subimage[face][i].ptr = &data.data[offset];
+			desc.data.subimage[face][i].size = data.mips[i];
+			offset += data.mips[i];
+		}
+
+	tex.image = sg_make_image(&desc);
+	return tex;
+}
+
+// content serialization, sizes are written so that consecutive arrays cannot alias
+static void AppendUInt(std::vector<uint8_t> &content, uint64_t v) {
+	const uint8_t *p = reinterpret_cast<const uint8_t *>(&v);
+	content.insert(content.end(), p, p + sizeof(v));
+}
+
+template <typename T> static void AppendVector(std::vector<uint8_t> &content, const std::vector<T> &v) {
+	AppendUInt(content, v.size());
+	if (!v.empty()) {
+		const uint8_t *p = reinterpret_cast<const uint8_t *>(&v[0]);
+		content.insert(content.end(), p, p + v.size() * sizeof(T));
+	}
+}
+
+static uint64_t HashContent(const std::vector<uint8_t> &content) { return content.empty() ? 0 : XXH64(&content[0], content.size(), 0); }
+
+uint64_t GetTextureDataContent(const TextureData &data, std::vector<uint8_t> &content) {
+	content.clear();
+	content.reserve(8 * 8 + data.mips.size() * sizeof(size_t) + data.data.size());
+
+	AppendUInt(content, uint64_t(data.width));
+	AppendUInt(content, uint64_t(data.height));
+	AppendUInt(content, uint64_t(data.type));
+	AppendUInt(content, uint64_t(data.slice_count));
+	AppendUInt(content, uint64_t(data.format));
+	AppendVector(content, data.mips);
+	AppendVector(content, data.data);
+
+	return HashContent(content);
+}
+
 //
 Material LoadMaterial(const rapidjson::Value &js, const Reader &deps_ir, const ReadProvider &deps_ip, PipelineResources &resources,
 	const PipelineInfo &pipeline, bool queue_texture_loads, bool do_not_load_resources, bool silent) {
@@ -360,21 +477,45 @@ bool SaveMaterialToFile(const std::string &path, const Material &m, const Pipeli
 //
 Texture LoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, bool silent) {
 	ScopedReadHandle h(ip, name, silent);
-	return LoadDDS(ir, h, name);
+	return LoadDDS(ir, h, name, silent);
 }
 
-Texture LoadTextureFromFile(const std::string &path, bool silent) { return Texture(); }
+Texture LoadTextureFromFile(const std::string &path, bool silent) { return LoadTexture(g_file_reader, g_file_read_provider, path, silent); }
 
-Texture LoadTextureFromAssets(const std::string &name, bool silent) { return Texture(); }
+Texture LoadTextureFromAssets(const std::string &name, bool silent) { return LoadTexture(g_assets_reader, g_assets_read_provider, name, silent); }
 
-void Destroy(Texture &tex) {}
+void Destroy(Texture &tex) {
+	if (sg_isvalid())
+		sg_destroy_image(tex.image);
+	tex.image.id = SG_INVALID_ID;
+}
+
+static size_t GetTextureDataSize(const TextureData &data) { return data.data.size(); }
 
 //
 TextureRef LoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, bool silent) {
 	TextureRef ref = resources.textures.Has(name);
 
-	if (ref == InvalidTextureRef)
-		ref = resources.textures.Add(name, LoadTexture(ir, ip, name, silent));
+	if (ref == InvalidTextureRef) {
+		ScopedReadHandle h(ip, name, silent);
+
+		TextureData data;
+		const bool ok = LoadDDS(ir, h, name, data, silent);
+
+		if (ok && resources.deduplicate_content) {
+			std::vector<uint8_t> content;
+			const uint64_t hash = GetTextureDataContent(data, content);
+			ref = resources.textures.Add(name, Texture());
+			if (!resources.textures.ShareContent(ref, hash, content)) {
+				resources.textures.Update(ref, MakeTexture(data));
+				resources.textures.SetSize(ref, GetTextureDataSize(data));
+				resources.textures.SetContentHash(ref, hash, content);
+			}
+		} else {
+			ref = resources.textures.Add(name, MakeTexture(data));
+			resources.textures.SetSize(ref, GetTextureDataSize(data));
+		}
+	}
 
 	return ref;
 }
@@ -388,7 +529,214 @@ TextureRef LoadTextureFromAssets(const std::string &name, PipelineResources &res
 }
 
 //
-TextureRef QueueLoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources) {
+static void SetLoadStatus(std::vector<ResourceLoadStatus> &status, gen_ref ref, ResourceLoadState state, ResourceLoad *pending) {
+	if (ref.idx >= status.size())
+		status.resize(ref.idx + 1);
+
+	ResourceLoadStatus &s = status[ref.idx];
+	s.gen = ref.gen;
+	s.state = state;
+	s.pending = pending;
+}
+
+static ResourceLoad *GetPendingLoad(const std::vector<ResourceLoadStatus> &status, gen_ref ref) {
+	return ref.idx < status.size() && status[ref.idx].gen == ref.gen ? status[ref.idx].pending : nullptr;
+}
+
+static ResourceLoadState GetLoadState(const std::vector<ResourceLoadStatus> &status, gen_ref ref) {
+	if (ref.idx < status.size() && status[ref.idx].gen == ref.gen) {
+		const ResourceLoadStatus &s = status[ref.idx];
+		return s.pending ? ResourceLoadState(AtomicLoad(s.pending->state)) : s.state;
+	}
+	return RLS_Loaded; // not loaded through a queue
+}
+
+template <typename Load, typename Ref>
+static Load *NewLoad(const Reader &ir, const ReadProvider &ip, const std::string &name, Ref ref, float priority, uint32_t order, bool hash_content) {
+	Load *load = new Load;
+	load->ir = ir;
+	load->ip = ip;
+	load->ref = ref;
+	load->name = name;
+	load->silent = false;
+	load->priority = priority;
+	load->order = order;
+	load->heap_index = 0;
+	load->hash_content = hash_content;
+	load->content_hash = 0;
+	load->state = RLS_Queued;
+	return load;
+}
+
+// queued loads are kept in a binary max-heap, changing a load priority moves it in place
+static bool IsLoadBefore(const ResourceLoad *a, const ResourceLoad *b) { return a->priority != b->priority ? a->priority > b->priority : a->order < b->order; }
+
+template <typename Load> static void SiftLoadUp(std::vector<Load *> &heap, size_t i) {
+	Load *load = heap[i];
+
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+		if (!IsLoadBefore(load, heap[parent]))
+			break;
+
+		heap[i] = heap[parent];
+		heap[i]->heap_index = i;
+		i = parent;
+	}
+
+	heap[i] = load;
+	load->heap_index = i;
+}
+
+template <typename Load> static void SiftLoadDown(std::vector<Load *> &heap, size_t i) {
+	Load *load = heap[i];
+
+	for (;;) {
+		size_t child = 2 * i + 1;
+		if (child >= heap.size())
+			break;
+
+		if (child + 1 < heap.size() && IsLoadBefore(heap[child + 1], heap[child]))
+			++child;
+		if (!IsLoadBefore(heap[child], load))
+			break;
+
+		heap[i] = heap[child];
+		heap[i]->heap_index = i;
+		i = child;
+	}
+
+	heap[i] = load;
+	load->heap_index = i;
+}
+
+template <typename Load> static void PushLoad(std::vector<Load *> &heap, Load *load) {
+	heap.push_back(load);
+	SiftLoadUp(heap, heap.size() - 1);
+}
+
+template <typename Load> static Load *PopLoad(std::vector<Load *> &heap) {
+	Load *top = heap.front();
+
+	heap.front() = heap.back();
+	heap.pop_back();
+
+	if (!heap.empty())
+		SiftLoadDown(heap, 0);
+	return top;
+}
+
+template <typename Load> static void SetLoadPriority(std::vector<Load *> &heap, Load *load, float priority) {
+	load->priority = priority;
+
+	if (AtomicLoad(load->state) == RLS_Queued) { // still in the heap
+		SiftLoadUp(heap, load->heap_index);
+		SiftLoadDown(heap, load->heap_index);
+	}
+}
+
+/*
+	Decoded loads hold their CPU side data until their GPU resources are created, the number of loads being decoded or
+	waiting for creation is capped to bound memory use.
+*/
+template <typename Load> static void StartLoadJobs(std::vector<Load *> &queue, std::vector<Load *> &in_flight, JobFunc decode, JobCounter &jobs, bool silent) {
+	const size_t max_in_flight = 2 * Max<size_t>(GetJobWorkerCount(), 1);
+
+	while (!queue.empty() && in_flight.size() < max_in_flight) {
+		Load *load = PopLoad(queue);
+
+		load->silent = silent;
+		AtomicCompareExchange(load->state, RLS_Queued, RLS_Decoding);
+
+		in_flight.push_back(load);
+		RunJob(decode, load, &jobs);
+	}
+}
+
+template <typename Load, typename T>
+static size_t CreateDecodedLoads(std::vector<Load *> &in_flight, ResourceCache<T> &cache, std::vector<ResourceLoadStatus> &status, time_ns t_start,
+	time_ns t_budget, size_t byte_budget, bool silent) {
+	std::sort(in_flight.begin(), in_flight.end(), &IsLoadBefore);
+
+	size_t processed = 0, bytes = 0;
+
+	for (typename std::vector<Load *>::iterator i = in_flight.begin(); i != in_flight.end();) {
+		Load *load = *i;
+
+		const int32_t state = AtomicLoad(load->state);
+		if (state != RLS_Decoded && state != RLS_Failed) {
+			++i;
+			continue;
+		}
+
+		if (processed && (time_now() - t_start >= t_budget || bytes >= byte_budget))
+			break; // always complete at least one load
+
+		if (cache.IsValidRef(load->ref)) {
+			if (state == RLS_Decoded) {
+				if (load->hash_content && cache.ShareContent(load->ref, load->content_hash, load->content)) {
+					if (!silent)
+						debug(fmt::format("Queued load '{}' shares the content of an already loaded resource", load->name));
+				} else {
+					if (!silent)
+						debug(fmt::format("Queued load '{}'", load->name));
+
+					const size_t size = GetDecodedLoadSize(*load);
+					cache.Update(load->ref, MakeDecodedLoad(*load));
+					cache.SetSize(load->ref, size);
+					if (load->hash_content)
+						cache.SetContentHash(load->ref, load->content_hash, load->content);
+					bytes += size;
+				}
+			}
+
+			cache.Unpin(load->ref);
+			SetLoadStatus(status, load->ref.ref, state == RLS_Decoded ? RLS_Loaded : RLS_Failed, nullptr);
+		}
+
+		delete load;
+		i = in_flight.erase(i);
+
+		++processed;
+	}
+
+	return processed;
+}
+
+//
+static void DecodeTextureLoad(void *user) {
+	TextureLoad &load = *reinterpret_cast<TextureLoad *>(user);
+
+	ScopedReadHandle h(load.ip, load.name, load.silent);
+	const bool ok = LoadDDS(load.ir, h, load.name, load.data, load.silent);
+	if (ok && load.hash_content)
+		load.content_hash = GetTextureDataContent(load.data, load.content);
+
+	AtomicCompareExchange(load.state, RLS_Decoding, ok ? RLS_Decoded : RLS_Failed);
+}
+
+static Texture MakeDecodedLoad(const TextureLoad &load) { return MakeTexture(load.data); }
+static size_t GetDecodedLoadSize(const TextureLoad &load) { return GetTextureDataSize(load.data); }
+
+size_t ProcessTextureLoadQueue(PipelineResources &res, time_ns t_budget, bool silent, size_t byte_budget) {
+	ProfilerPerfSection section("ProcessTextureLoadQueue");
+
+	const time_ns t_start = time_now();
+
+	StartLoadJobs(res.texture_loads, res.texture_loads_in_flight, &DecodeTextureLoad, res.load_jobs, silent);
+	const size_t processed = CreateDecodedLoads(res.texture_loads_in_flight, res.textures, res.texture_load_status, t_start, t_budget, byte_budget, silent);
+
+	if (GetJobWorkerCount())
+		StartLoadJobs(res.texture_loads, res.texture_loads_in_flight, &DecodeTextureLoad, res.load_jobs, silent); // refill the slots freed by this call
+
+	return processed;
+}
+
+ResourceLoadState GetTextureLoadState(const PipelineResources &res, TextureRef ref) {
+	return res.textures.IsValidRef(ref) ? GetLoadState(res.texture_load_status, ref.ref) : RLS_Invalid;
+}
+
+TextureRef QueueLoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, float priority) {
 	TextureRef ref = resources.textures.Has(name);
 
 	if (ref != InvalidTextureRef)
@@ -396,21 +744,32 @@ TextureRef QueueLoadTexture(const Reader &ir, const ReadProvider &ip, const std:
 
 	ref = resources.textures.Add(name, Texture());
 
-	TextureLoad tl;
-	tl.ir = ir;
-	tl.ip = ip;
-	tl.ref = ref;
-	resources.texture_loads.push_back(tl);
+	TextureLoad *load = NewLoad<TextureLoad>(ir, ip, name, ref, priority, resources.load_order++, resources.deduplicate_content);
+	PushLoad(resources.texture_loads, load);
+	resources.textures.Pin(ref); // not evicted while loading
+	SetLoadStatus(resources.texture_load_status, ref.ref, RLS_Queued, load);
 
 	return ref;
 }
 
-TextureRef QueueLoadTextureFromFile(const std::string &path, PipelineResources &resources) {
-	return QueueLoadTexture(g_file_reader, g_file_read_provider, path, resources);
+bool SetTextureLoadPriority(PipelineResources &resources, TextureRef ref, float priority) {
+	if (!resources.textures.IsValidRef(ref))
+		return false;
+
+	ResourceLoad *load = GetPendingLoad(resources.texture_load_status, ref.ref);
+	if (!load)
+		return false;
+
+	SetLoadPriority(resources.texture_loads, static_cast<TextureLoad *>(load), priority);
+	return true;
+}
+
+TextureRef QueueLoadTextureFromFile(const std::string &path, PipelineResources &resources, float priority) {
+	return QueueLoadTexture(g_file_reader, g_file_read_provider, path, resources, priority);
 }
 
-TextureRef QueueLoadTextureFromAssets(const std::string &name, PipelineResources &resources) {
-	return QueueLoadTexture(g_assets_reader, g_assets_read_provider, name, resources);
+TextureRef QueueLoadTextureFromAssets(const std::string &name, PipelineResources &resources, float priority) {
+	return QueueLoadTexture(g_assets_reader, g_assets_read_provider, name, resources, priority);
 }
 
 //
@@ -462,27 +821,27 @@ struct legacy_VertexLayout {
 };
 
 //
-Model LoadModel(const Reader &ir, const Handle &h, const std::string &name, bool silent) {
-	ProfilerPerfSection section("LoadModel", name);
+bool LoadModelData(const Reader &ir, const Handle &h, const std::string &name, ModelData &data, bool silent) {
+	ProfilerPerfSection section("LoadModelData", name);
 
 	const time_ns t = time_now();
 
 	if (!ir.is_valid(h)) {
 		if (!silent)
 			warn(fmt::format("Cannot load model '{}', invalid file handle", name));
-		return Model();
+		return false;
 	}
 
 	if (Read<uint32_t>(ir, h) != HarfangMagic) {
 		if (!silent)
 			warn(fmt::format("Cannot load model '{}', invalid magic marker", name));
-		return Model();
+		return false;
 	}
 
 	if (Read<uint8_t>(ir, h) != ModelMarker) {
 		if (!silent)
 			warn(fmt::format("Cannot load model '{}', invalid file marker", name));
-		return Model();
+		return false;
 	}
 
 	const uint8_t version = Read<uint8_t>(ir, h);
@@ -490,18 +849,14 @@ Model LoadModel(const Reader &ir, const Handle &h, const std::string &name, bool
 	if (version > 2) {
 		if (!silent)
 			warn(fmt::format("Cannot load model '{}', unsupported version {}", name, version));
-		return Model();
+		return false;
 	}
 
-	Model model;
-
 	legacy_VertexLayout vs_decl;
 	ir.read(h, &vs_decl, sizeof(legacy_VertexLayout)); // read vertex declaration
 
 	uint32_t tri_count = 0;
 
-	std::vector<uint8_t> data;
-
 	while (true) {
 		uint8_t idx_type_size = 2; // legacy is 16 bit indices
 		if (version > 1) {
@@ -520,51 +875,104 @@ Model LoadModel(const Reader &ir, const Handle &h, const std::string &name, bool
 			if (size == 0)
 				break; // EOLists
 
-		DisplayList list;
+		data.lists.push_back(ModelData::List());
+		ModelData::List &list = data.lists.back();
 
-		data.resize(size);
-		ir.read(h, data.data(), size); // load indices
+		list.indices.resize(size);
+		ir.read(h, list.indices.data(), size); // load indices
 
 		list.element_count = size / idx_type_size; // index count
-		list.index_buffer = MakeIndexBuffer(data.data(), size);
 		tri_count += list.element_count / 3;
 
 		// vertex buffer
 		size = Read<uint32_t>(ir, h);
 
-		data.resize(size);
-		ir.read(h, data.data(), size); // load vertices
-		list.vertex_buffer = MakeVertexBuffer(data.data(), size);
+		list.vertices.resize(size);
+		ir.read(h, list.vertices.data(), size); // load vertices
 
 		// bones table
 		size = Read<uint32_t>(ir, h);
 		list.bones_table.resize(size);
 		ir.read(h, list.bones_table.data(), list.bones_table.size() * sizeof(list.bones_table[0]));
 
-		model.lists.push_back(list);
-
 		//
-		model.bounds.push_back(Read<MinMax>(ir, h));
-		model.mats.push_back(Read<uint16_t>(ir, h));
+		data.bounds.push_back(Read<MinMax>(ir, h));
+		data.mats.push_back(Read<uint16_t>(ir, h));
 	}
 
-	// model.vtx_layout = ; FIXME implement lightweight vtx layout
-	model.tri_count = tri_count;
+	data.tri_count = tri_count;
 
 	if (version > 0) { // version 1: add bind poses
 		const uint32_t bone_count = Read<uint32_t>(ir, h);
 
-		model.bind_pose.resize(bone_count);
+		data.bind_pose.resize(bone_count);
 		for (uint32_t j = 0; j < bone_count; ++j)
-			Read(ir, h, model.bind_pose[j]);
+			Read(ir, h, data.bind_pose[j]);
 	}
 
 	if (!silent)
-		log(fmt::format("Load model '{}' ({} triangles, {} lists), took {} ms", name, tri_count, model.lists.size(), time_to_ms(time_now() - t)));
+		log(fmt::format("Load model '{}' ({} triangles, {} lists), took {} ms", name, tri_count, data.lists.size(), time_to_ms(time_now() - t)));
+
+	return true;
+}
+
+static size_t GetModelDataSize(const ModelData &data) {
+	size_t size = 0;
+	for (std::vector<ModelData::List>::const_iterator i = data.lists.begin(); i != data.lists.end(); ++i)
+		size += i->indices.size() + i->vertices.size();
+	return size;
+}
+
+Model MakeModel(const ModelData &data) {
+	Model model;
+
+	model.lists.resize(data.lists.size());
+	for (size_t i = 0; i < data.lists.size(); ++i) {
+		const ModelData::List &in = data.lists[i];
+		DisplayList &list = model.lists[i];
+
+		list.element_count = in.element_count;
+		list.index_buffer = MakeIndexBuffer(in.indices.data(), in.indices.size());
+		list.vertex_buffer = MakeVertexBuffer(in.vertices.data(), in.vertices.size());
+		list.bones_table = in.bones_table;
+	}
+
+	// model.vtx_layout = ; FIXME implement lightweight vtx layout
+	model.tri_count = data.tri_count;
+	model.bounds = data.bounds;
+	model.mats = data.mats;
+	model.bind_pose = data.bind_pose;
 
 	return model;
 }
 
+uint64_t GetModelDataContent(const ModelData &data, std::vector<uint8_t> &content) {
+	content.clear();
+
+	AppendUInt(content, data.tri_count);
+	AppendUInt(content, data.lists.size());
+	for (std::vector<ModelData::List>::const_iterator i = data.lists.begin(); i != data.lists.end(); ++i) {
+		AppendUInt(content, i->element_count);
+		AppendVector(content, i->indices);
+		AppendVector(content, i->vertices);
+		AppendVector(content, i->bones_table);
+	}
+	AppendVector(content, data.bounds);
+	AppendVector(content, data.mats);
+	AppendVector(content, data.bind_pose);
+
+	return HashContent(content);
+}
+
+Model LoadModel(const Reader &ir, const Handle &h, const std::string &name, bool silent) {
+	ProfilerPerfSection section("LoadModel", name);
+
+	ModelData data;
+	if (!LoadModelData(ir, h, name, data, silent))
+		return Model();
+	return MakeModel(data);
+}
+
 Model LoadModelFromFile(const std::string &path, bool silent) {
 	return LoadModel(g_file_reader, ScopedReadHandle(g_file_read_provider, path, silent), path, silent);
 }
@@ -577,8 +985,24 @@ Model LoadModelFromAssets(const std::string &name, bool silent) {
 ModelRef LoadModel(const Reader &ir, const ReadProvider &ip, const std::string &path, PipelineResources &resources, bool silent) {
 	ModelRef ref = resources.models.Has(path);
 
-	if (ref == InvalidModelRef)
-		ref = resources.models.Add(path, LoadModel(ir, ScopedReadHandle(ip, path), path, silent));
+	if (ref == InvalidModelRef) {
+		ModelData data;
+		const bool ok = LoadModelData(ir, ScopedReadHandle(ip, path), path, data, silent);
+
+		if (ok && resources.deduplicate_content) {
+			std::vector<uint8_t> content;
+			const uint64_t hash = GetModelDataContent(data, content);
+			ref = resources.models.Add(path, Model());
+			if (!resources.models.ShareContent(ref, hash, content)) {
+				resources.models.Update(ref, MakeModel(data));
+				resources.models.SetSize(ref, GetModelDataSize(data));
+				resources.models.SetContentHash(ref, hash, content);
+			}
+		} else {
+			ref = resources.models.Add(path, MakeModel(data));
+			resources.models.SetSize(ref, GetModelDataSize(data));
+		}
+	}
 
 	return ref;
 }
@@ -592,60 +1016,71 @@ ModelRef LoadModelFromAssets(const std::string &path, PipelineResources &resourc
 }
 
 //
-size_t ProcessModelLoadQueue(PipelineResources &res, time_ns t_budget, bool silent) {
-	ProfilerPerfSection section("ProcessModelLoadQueue");
+static void DecodeModelLoad(void *user) {
+	ModelLoad &load = *reinterpret_cast<ModelLoad *>(user);
 
-	size_t processed = 0;
+	ScopedReadHandle h(load.ip, load.name, load.silent);
+	const bool ok = LoadModelData(load.ir, h, load.name, load.data, load.silent);
+	if (ok && load.hash_content)
+		load.content_hash = GetModelDataContent(load.data, load.content);
 
-	const time_ns t_start = time_now();
+	AtomicCompareExchange(load.state, RLS_Decoding, ok ? RLS_Decoded : RLS_Failed);
+}
 
-	while (!res.model_loads.empty()) {
-		const ModelLoad &load = res.model_loads.front();
+static Model MakeDecodedLoad(const ModelLoad &load) { return MakeModel(load.data); }
+static size_t GetDecodedLoadSize(const ModelLoad &load) { return GetModelDataSize(load.data); }
 
-		if (res.models.IsValidRef(load.ref)) {
-			Model &mdl = res.models.Get(load.ref);
-			const std::string name = res.models.GetName(load.ref);
-			if (!silent)
-				debug(fmt::format("Queued model load '{}'", name));
+size_t ProcessModelLoadQueue(PipelineResources &res, time_ns t_budget, bool silent, size_t byte_budget) {
+	ProfilerPerfSection section("ProcessModelLoadQueue");
 
-			ScopedReadHandle h(load.ip, name, silent);
-			mdl = LoadModel(load.ir, h, name, silent);
-		}
+	const time_ns t_start = time_now();
 
-		res.model_loads.pop_front();
+	StartLoadJobs(res.model_loads, res.model_loads_in_flight, &DecodeModelLoad, res.load_jobs, silent);
+	const size_t processed = CreateDecodedLoads(res.model_loads_in_flight, res.models, res.model_load_status, t_start, t_budget, byte_budget, silent);
 
-		++processed;
-
-		const time_ns elapsed = time_now() - t_start;
-		if (elapsed >= t_budget)
-			break;
-	}
+	if (GetJobWorkerCount())
+		StartLoadJobs(res.model_loads, res.model_loads_in_flight, &DecodeModelLoad, res.load_jobs, silent); // refill the slots freed by this call
 
 	return processed;
 }
 
-ModelRef QueueLoadModel(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources) {
+ResourceLoadState GetModelLoadState(const PipelineResources &res, ModelRef ref) {
+	return res.models.IsValidRef(ref) ? GetLoadState(res.model_load_status, ref.ref) : RLS_Invalid;
+}
+
+ModelRef QueueLoadModel(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, float priority) {
 	ModelRef ref = resources.models.Has(name);
 	if (ref != InvalidModelRef)
 		return ref;
 
 	ref = resources.models.Add(name, Model());
 
-	ModelLoad load;
-	load.ip = ip;
-	load.ir = ir;
-	load.ref = ref;
-	resources.model_loads.push_back(load);
+	ModelLoad *load = NewLoad<ModelLoad>(ir, ip, name, ref, priority, resources.load_order++, resources.deduplicate_content);
+	PushLoad(resources.model_loads, load);
+	resources.models.Pin(ref); // not evicted while loading
+	SetLoadStatus(resources.model_load_status, ref.ref, RLS_Queued, load);
 
 	return ref;
 }
 
-ModelRef QueueLoadModelFromFile(const std::string &path, PipelineResources &resources) {
-	return QueueLoadModel(g_file_reader, g_file_read_provider, path, resources);
+bool SetModelLoadPriority(PipelineResources &resources, ModelRef ref, float priority) {
+	if (!resources.models.IsValidRef(ref))
+		return false;
+
+	ResourceLoad *load = GetPendingLoad(resources.model_load_status, ref.ref);
+	if (!load)
+		return false;
+
+	SetLoadPriority(resources.model_loads, static_cast<ModelLoad *>(load), priority);
+	return true;
+}
+
+ModelRef QueueLoadModelFromFile(const std::string &path, PipelineResources &resources, float priority) {
+	return QueueLoadModel(g_file_reader, g_file_read_provider, path, resources, priority);
 }
 
-ModelRef QueueLoadModelFromAssets(const std::string &name, PipelineResources &resources) {
-	return QueueLoadModel(g_assets_reader, g_assets_read_provider, name, resources);
+ModelRef QueueLoadModelFromAssets(const std::string &name, PipelineResources &resources, float priority) {
+	return QueueLoadModel(g_assets_reader, g_assets_read_provider, name, resources, priority);
 }
 
 ModelRef SkipLoadOrQueueModelLoad(
@@ -669,6 +1104,29 @@ ModelRef SkipLoadOrQueueModelLoad(
 #endif
 }
 
+//
+size_t GetQueuedResourceCount(const PipelineResources &res) {
+	return res.model_loads.size() + res.model_loads_in_flight.size() + res.texture_loads.size() + res.texture_loads_in_flight.size();
+}
+
+size_t ProcessLoadQueues(PipelineResources &res, time_ns t_budget, bool silent, size_t byte_budget) {
+	ProfilerPerfSection section("ProcessLoadQueues");
+
+	size_t total = 0;
+
+	total += ProcessModelLoadQueue(res, t_budget, silent, byte_budget);
+	total += ProcessTextureLoadQueue(res, t_budget, silent, byte_budget);
+
+	return total;
+}
+
+size_t DestroyReleasedResources(PipelineResources &res) {
+	size_t count = res.models.DestroyReleased();
+	count += res.materials.DestroyReleased();
+	count += res.textures.DestroyReleased();
+	return count;
+}
+
 #if 0
 
 //
@@ -5,11 +5,13 @@
 #include "engine/picture.h"
 #include "engine/resource_cache.h"
 
+#include "foundation/atom.h"
 #include "foundation/cext.h"
 #include "foundation/color.h"
 #include "foundation/data.h"
 #include "foundation/frustum.h"
 #include "foundation/generational_vector_list.h"
+#include "foundation/job.h"
 #include "foundation/matrix4.h"
 #include "foundation/matrix44.h"
 #include "foundation/minmax.h"
@@ -412,6 +414,28 @@ struct Texture { // 8B
 	sg_image image;
 };
 
+/// CPU side content of a texture, decoded from a file and ready to be uploaded.
+struct TextureData {
+	TextureData() : width(0), height(0), type(SG_IMAGETYPE_2D), slice_count(1), format(_SG_PIXELFORMAT_DEFAULT) {}
+
+	int width, height;
+	sg_image_type type; // 2D, cube or array
+	int slice_count; // array layer count
+	sg_pixel_format format;
+
+	/*
+		Size of each mip level in data. Cube faces are stored one after the other, each with its full mip chain.
+		Array layers are stored mip level first, all layers of a mip level then all layers of the next one.
+	*/
+	std::vector<size_t> mips;
+	std::vector<uint8_t> data;
+};
+
+/// Create a texture from its CPU side content, return an invalid texture if the content is empty.
+Texture MakeTexture(const TextureData &data);
+/// Serialize a texture content, textures with identical content and format have identical streams. Return the 64-bit hash of the stream.
+uint64_t GetTextureDataContent(const TextureData &data, std::vector<uint8_t> &content);
+
 // inline Texture MakeTexture(bgfx::TextureHandle handle, uint64_t flags = BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE) { return {flags, handle}; }
 
 //
@@ -470,7 +494,7 @@ struct Material { // 56B
 		int16_t idx;
 	};
 
-	std::map<std::string, Value> values;
+	std::map<atom, Value> values;
 
 	struct Texture {
 		Texture() : channel(0), idx(-1) {}
@@ -480,7 +504,7 @@ struct Material { // 56B
 		int8_t idx;
 	};
 
-	std::map<std::string, Texture> textures;
+	std::map<atom, Texture> textures;
 
 	RenderState state;
 
@@ -570,54 +594,151 @@ Model LoadModelFromAssets(const std::string &name, bool silent = false);
 
 size_t GetModelMaterialCount(const Model &model);
 
+/// CPU side content of a model, decoded from a file and ready to be uploaded.
+struct ModelData {
+	ModelData() : tri_count(0) {}
+
+	struct List {
+		size_t element_count;
+		std::vector<uint8_t> indices, vertices;
+		std::vector<uint16_t> bones_table;
+	};
+
+	uint32_t tri_count;
+
+	std::vector<List> lists;
+	std::vector<MinMax> bounds; // minmax/list
+	std::vector<uint16_t> mats; // material/list
+	std::vector<Mat4> bind_pose; // bind pose matrices
+};
+
+/// Read a model content without creating any GPU resource, can be called from any thread.
+bool LoadModelData(const Reader &ir, const Handle &h, const std::string &name, ModelData &data, bool silent = false);
+/// Create a model from its CPU side content.
+Model MakeModel(const ModelData &data);
+/// Serialize a model content, models with identical content have identical streams. Return the 64-bit hash of the stream.
+uint64_t GetModelDataContent(const ModelData &data, std::vector<uint8_t> &content);
+
 //
 void Destroy(Model &model);
 void Destroy(Material &material);
 
-//
-struct TextureLoad {
+/*
+	Queued resource loads
+
+	- Reading and decoding a queued resource runs as a job on the job system workers (inline if the system is not started).
+	- Process*LoadQueue creates the GPU resources of the decoded loads on the calling thread under a time and byte budget.
+	- Loads are serviced by decreasing priority, loads of equal priority in queue order.
+	- The load state of each queued resource can be queried with GetTextureLoadState/GetModelLoadState.
+*/
+enum ResourceLoadState {
+	RLS_Invalid, // invalid reference
+	RLS_Queued, // waiting to be decoded
+	RLS_Decoding, // being read and decoded by a job
+	RLS_Decoded, // waiting for its GPU resources to be created
+	RLS_Loaded,
+	RLS_Failed
+};
+
+struct ResourceLoad {
 	Reader ir;
 	ReadProvider ip;
+
+	std::string name;
+	bool silent;
+
+	float priority; // higher first
+	uint32_t order; // queue order, breaks priority ties
+	size_t heap_index; // position in the queue heap while queued
+
+	bool hash_content;
+	uint64_t content_hash; // computed by the decoding job if hash_content is set
+	std::vector<uint8_t> content; // serialized content, compared to confirm a hash match
+
+	volatile int32_t state; // ResourceLoadState, updated by the decoding job
+};
+
+struct TextureLoad : ResourceLoad {
 	TextureRef ref;
+	TextureData data;
 };
 
-struct ModelLoad {
-	Reader ir;
-	ReadProvider ip;
+struct ModelLoad : ResourceLoad {
 	ModelRef ref;
+	ModelData data;
+};
+
+struct ResourceLoadStatus {
+	ResourceLoadStatus() : gen(0xffffffff), state(RLS_Invalid), pending(nullptr) {}
+
+	uint32_t gen;
+	ResourceLoadState state;
+	ResourceLoad *pending; // load in flight, if any
 };
 
 struct PipelineResources {
-	PipelineResources() : /*programs(Destroy),*/ textures(Destroy), materials(Destroy), models(Destroy) {}
+	PipelineResources();
 	~PipelineResources() { DestroyAll(); }
 
+	uint32_t uid; // unique to this object for the program lifetime, identifies it in caches outliving it
+
 	//	ResourceCache<PipelineProgram> programs;
 	ResourceCache<Texture> textures;
 	ResourceCache<Material> materials;
 	ResourceCache<Model> models;
 
-	std::deque<TextureLoad> texture_loads;
-	std::deque<ModelLoad> model_loads;
+	/// Hash the content of loaded textures and models, a resource with the same content as an already loaded one shares its GPU
+	/// resources instead of creating new ones. Bytes saved are reported by the caches GetSharedSize.
+	/// Contents are compared byte for byte on hash match, a CPU copy of each shared content is kept for the comparison.
+	bool deduplicate_content;
+
+	std::vector<TextureLoad *> texture_loads, texture_loads_in_flight; // queued loads are a binary max-heap on priority
+	std::vector<ModelLoad *> model_loads, model_loads_in_flight;
 
+	std::vector<ResourceLoadStatus> texture_load_status, model_load_status; // indexed by resource reference index
+	uint32_t load_order;
+	JobCounter load_jobs;
+
+	/// Cancel pending loads and destroy all cached resources.
 	void DestroyAll();
+
+private:
+	PipelineResources(const PipelineResources &);
+	PipelineResources &operator=(const PipelineResources &);
 };
 
+ResourceLoadState GetTextureLoadState(const PipelineResources &resources, TextureRef ref);
+ResourceLoadState GetModelLoadState(const PipelineResources &resources, ModelRef ref);
+
 //
-size_t ProcessTextureLoadQueue(PipelineResources &resources, time_ns t_budget = time_from_ms(4), bool silent = false);
+/// Create the GPU resources of decoded texture loads until the time or byte budget is exhausted, return the number of completed loads.
+/// At least one decoded load is always completed so that loads larger than the byte budget make progress.
+size_t ProcessTextureLoadQueue(
+	PipelineResources &resources, time_ns t_budget = time_from_ms(4), bool silent = false, size_t byte_budget = 16 * 1024 * 1024);
+
+/// Queue a texture load, if the texture is already known its reference is returned and its load priority is left unchanged.
+TextureRef QueueLoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, float priority = 0.f);
+TextureRef QueueLoadTextureFromFile(const std::string &path, PipelineResources &resources, float priority = 0.f);
+TextureRef QueueLoadTextureFromAssets(const std::string &name, PipelineResources &resources, float priority = 0.f);
 
-TextureRef QueueLoadTexture(const Reader &ir, const ReadProvider &ip, const std::string &name, uint64_t flags, PipelineResources &resources);
-TextureRef QueueLoadTextureFromFile(const std::string &path, uint64_t flags, PipelineResources &resources);
-TextureRef QueueLoadTextureFromAssets(const std::string &name, uint64_t flags, PipelineResources &resources);
+/// Change the priority of a pending texture load, return false if the texture has no pending load.
+bool SetTextureLoadPriority(PipelineResources &resources, TextureRef ref, float priority);
 
 TextureRef SkipLoadOrQueueTextureLoad(
 	const Reader &ir, const ReadProvider &ip, const std::string &path, PipelineResources &resources, bool queue_load, bool do_not_load, bool silent = false);
 
 //
-size_t ProcessModelLoadQueue(PipelineResources &resources, time_ns t_budget = time_from_ms(4), bool silent = false);
-ModelRef QueueLoadModel(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources);
+/// Create the GPU resources of decoded model loads until the time or byte budget is exhausted, return the number of completed loads.
+size_t ProcessModelLoadQueue(
+	PipelineResources &resources, time_ns t_budget = time_from_ms(4), bool silent = false, size_t byte_budget = 16 * 1024 * 1024);
+/// Queue a model load, if the model is already known its reference is returned and its load priority is left unchanged.
+ModelRef QueueLoadModel(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, float priority = 0.f);
 
-ModelRef QueueLoadModelFromFile(const std::string &path, PipelineResources &resources);
-ModelRef QueueLoadModelFromAssets(const std::string &name, PipelineResources &resources);
+ModelRef QueueLoadModelFromFile(const std::string &path, PipelineResources &resources, float priority = 0.f);
+ModelRef QueueLoadModelFromAssets(const std::string &name, PipelineResources &resources, float priority = 0.f);
+
+/// Change the priority of a pending model load, return false if the model has no pending load.
+bool SetModelLoadPriority(PipelineResources &resources, ModelRef ref, float priority);
 
 ModelRef SkipLoadOrQueueModelLoad(
 	const Reader &ir, const ReadProvider &ip, const std::string &path, PipelineResources &resources, bool queue_load, bool do_not_load, bool silent = false);
@@ -676,7 +797,11 @@ MaterialRef LoadMaterialRefFromAssets(const std::string &path, PipelineResources
 
 //
 size_t GetQueuedResourceCount(const PipelineResources &res);
-size_t ProcessLoadQueues(PipelineResources &res, time_ns t_budget = time_from_ms(4), bool silent = false);
+size_t ProcessLoadQueues(PipelineResources &res, time_ns t_budget = time_from_ms(4), bool silent = false, size_t byte_budget = 16 * 1024 * 1024);
+
+/// Destroy the resources whose last reference was released, return the number of destroyed resources.
+/// @see ResourceCache::DestroyReleased and Scene::UpdateResourceRefs.
+size_t DestroyReleasedResources(PipelineResources &res);
 
 //
 std::vector<int> GetMaterialPipelineProgramFeatureStates(const Material &mat, const std::vector<PipelineProgramFeature> &features);
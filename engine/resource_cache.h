@@ -5,8 +5,13 @@
 #include "foundation/cext.h"
 #include "foundation/generational_vector_list.h"
 
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <string>
+#include <vector>
+
+#include <xxhash.h>
 
 namespace hg {
 
@@ -16,6 +21,21 @@ template <typename T> struct ResourceRef {
 	bool operator!=(const ResourceRef &o) const { return ref != o.ref; }
 };
 
+/*
+	Resource cache
+
+	- Resources are accounted by byte size (see SetSize) and stamped each time they are added or touched (see Touch).
+	- Evict destroys the least recently used unpinned and unreferenced resources until the total size fits the budget.
+	- Pinning is counted, a resource is pinned until Unpin has been called as many times as Pin.
+	- Users of a resource (eg. scenes) can hold references on it with AddRef/Release, referenced resources are never evicted.
+	  A resource whose reference count drops to zero is not destroyed until DestroyReleased is called, it is kept if it was
+	  referenced again in the meantime.
+	- Names are indexed by an open-addressing hash table (linear probing, backward shift deletion), renaming a resource
+	  re-indexes it under its new name unless that name is already used by another resource.
+	- Resources registered with their content (see SetContentHash) can share their payload with resources of identical
+	  content (see ShareContent). Contents are looked up by hash and compared byte for byte, a registered content is kept in
+	  memory until its payload is destroyed. A shared payload is accounted once and destroyed with the last resource using it.
+*/
 template <typename T> class ResourceCache {
 public:
 	typedef ResourceRef<T> RefType;
@@ -24,60 +44,397 @@ private:
 	struct name_T {
 		std::string name;
 		T T_;
+
+		size_t size;
+		uint32_t last_use;
+		uint32_t pin_count;
+		uint32_t ref_count;
+
+		bool shared; // payload owned by the content entry
+		uint64_t content_hash;
+	};
+
+	struct content_T {
+		T payload;
+		size_t size;
+		uint32_t count; // resources using the payload
+		std::vector<uint8_t> content; // compared on hash match so that a hash collision cannot alias different contents
 	};
 
-	typedef typename std::map<const std::string, RefType>::iterator dict_iterator;
-	typedef typename std::map<const std::string, RefType>::const_iterator const_dict_iterator;
+	typedef typename std::map<uint64_t, content_T>::iterator content_iterator;
+
+	struct name_slot {
+		uint32_t hash;
+		RefType ref; // invalid if the slot is empty
+	};
 
 	typedef typename generational_vector_list<name_T>::iterator res_iterator;
 	typedef typename generational_vector_list<name_T>::const_iterator const_res_iterator;
 
 	inline RefType add_ref(const std::string &name, const T &res) { 
-		name_T in = {name, res};
+		name_T in = {name, res, 0, ++use_clock, 0, 0};
 		RefType out;
 		out.ref = resources.add_ref(in);
 		return out;
 	}
 
+	void init_entry(name_T &nt, const std::string &name) {
+		nt.name = name;
+		nt.size = 0;
+		nt.last_use = ++use_clock;
+		nt.pin_count = 0;
+		nt.ref_count = 0;
+		nt.shared = false;
+		nt.content_hash = 0;
+	}
+
+	// stop using a shared payload, destroy it if no other resource uses it
+	void leave_content(name_T &nt) {
+		const content_iterator i = contents.find(nt.content_hash);
+		__ASSERT__(i != contents.end());
+
+		if (--i->second.count) {
+			shared_size -= i->second.size;
+		} else {
+			_destroy(i->second.payload);
+			total_size -= i->second.size;
+			contents.erase(i);
+		}
+
+		nt.shared = false;
+		nt.size = 0;
+	}
+
+	// destroy the resource payload unless it is shared
+	void release_payload(name_T &nt) {
+		if (nt.shared) {
+			leave_content(nt);
+		} else {
+			_destroy(nt.T_);
+			total_size -= nt.size;
+			nt.size = 0;
+		}
+	}
+
+	static uint32_t hash_name(const std::string &name) { return XXH32(name.data(), name.size(), 0); }
+
+	static const size_t npos = size_t(-1);
+
+	size_t find_name(const std::string &name, uint32_t hash) const {
+		if (name_slots.empty())
+			return npos;
+
+		const size_t mask = name_slots.size() - 1;
+		for (size_t i = hash & mask;; i = (i + 1) & mask) {
+			const name_slot &slot = name_slots[i];
+			if (slot.ref.ref == invalid_gen_ref)
+				return npos;
+			if (slot.hash == hash && resources[slot.ref.ref.idx].name == name)
+				return i;
+		}
+	}
+
+	void grow_names() {
+		std::vector<name_slot> slots(name_slots.empty() ? 16 : name_slots.size() * 2);
+		std::swap(slots, name_slots);
+
+		const size_t mask = name_slots.size() - 1;
+		for (typename std::vector<name_slot>::const_iterator i = slots.begin(); i != slots.end(); ++i)
+			if (i->ref.ref != invalid_gen_ref) {
+				size_t j = i->hash & mask;
+				while (name_slots[j].ref.ref != invalid_gen_ref)
+					j = (j + 1) & mask;
+				name_slots[j] = *i;
+			}
+	}
+
+	void insert_name(uint32_t hash, RefType ref) {
+		if ((name_count + 1) * 4 > name_slots.size() * 3) // keep the load factor under 3/4
+			grow_names();
+
+		const size_t mask = name_slots.size() - 1;
+		size_t i = hash & mask;
+		while (name_slots[i].ref.ref != invalid_gen_ref)
+			i = (i + 1) & mask;
+
+		name_slots[i].hash = hash;
+		name_slots[i].ref = ref;
+		++name_count;
+	}
+
+	void erase_name(uint32_t hash, RefType ref) {
+		if (name_slots.empty())
+			return;
+
+		const size_t mask = name_slots.size() - 1;
+		size_t i = hash & mask;
+		for (; name_slots[i].ref != ref; i = (i + 1) & mask)
+			if (name_slots[i].ref.ref == invalid_gen_ref)
+				return; // not indexed
+
+		// shift back the following entries of the cluster which probe sequence goes through the freed slot
+		for (size_t j = (i + 1) & mask; name_slots[j].ref.ref != invalid_gen_ref; j = (j + 1) & mask)
+			if (((j - (name_slots[j].hash & mask)) & mask) >= ((j - i) & mask)) {
+				name_slots[i] = name_slots[j];
+				i = j;
+			}
+
+		name_slots[i].ref = RefType();
+		--name_count;
+	}
+
+	void rename(RefType ref, const std::string &name) {
+		name_T &nt = resources[ref.ref.idx];
+		erase_name(hash_name(nt.name), ref);
+		nt.name = name;
+
+		const uint32_t hash = hash_name(name);
+		if (find_name(name, hash) == npos)
+			insert_name(hash, ref);
+	}
+
+	struct eviction_candidate {
+		uint32_t last_use;
+		gen_ref ref;
+		bool operator<(const eviction_candidate &o) const { return last_use < o.last_use; }
+	};
+
 public:
-	ResourceCache(void (*destroy)(T &)) : _destroy(destroy) {}
+	ResourceCache(void (*destroy)(T &)) : name_count(0), total_size(0), budget(std::numeric_limits<size_t>::max()), shared_size(0), use_clock(0), _destroy(destroy) {
+		resources.set_memory_tag(MT_Resources);
+	}
 
 	RefType Add(const std::string &name, const T &res) {
-		dict_iterator i = name_to_ref.find(name);
-		if (i != name_to_ref.end())
-			return i->second;
+		const uint32_t hash = hash_name(name);
+		const size_t i = find_name(name, hash);
+		if (i != npos)
+			return name_slots[i].ref;
 
 		name_T nt;
-		nt.name = name;
+		init_entry(nt, name);
 		nt.T_ = res;
 
 		RefType ref;
 		ref.ref = resources.add_ref(nt);
-		name_to_ref[name] = ref;
+		insert_name(hash, ref);
 		return ref;
 	}
 
 	void Update(RefType ref, const T &res) {
 		if (resources.is_valid(ref.ref)) {
-			_destroy(resources[ref.ref.idx].T_);
+			const size_t size = GetSize(ref);
+			release_payload(resources[ref.ref.idx]);
 			resources[ref.ref.idx].T_ = res;
+			SetSize(ref, size);
+		}
+	}
+
+#if __cplusplus >= 201103L
+	RefType Add(const std::string &name, T &&res) {
+		const uint32_t hash = hash_name(name);
+		const size_t i = find_name(name, hash);
+		if (i != npos)
+			return name_slots[i].ref;
+
+		name_T nt;
+		init_entry(nt, name);
+		nt.T_ = std::move(res);
+
+		RefType ref;
+		ref.ref = resources.add_ref(std::move(nt));
+		insert_name(hash, ref);
+		return ref;
+	}
+
+	void Update(RefType ref, T &&res) {
+		if (resources.is_valid(ref.ref)) {
+			const size_t size = GetSize(ref);
+			release_payload(resources[ref.ref.idx]);
+			resources[ref.ref.idx].T_ = std::move(res);
+			SetSize(ref, size);
 		}
 	}
+#endif
 
 	void Destroy(RefType ref) {
 		if (resources.is_valid(ref.ref)) {
-			_destroy(resources[ref.ref.idx].T_);
-			name_to_ref.erase(resources[ref.ref.idx].name); // drop from cache
+			release_payload(resources[ref.ref.idx]);
+			erase_name(hash_name(resources[ref.ref.idx].name), ref); // drop from cache
 			resources.remove_ref(ref.ref);
 		}
 	}
 
 	void DestroyAll() {
 		for (res_iterator i = resources.begin(); i != resources.end(); ++i) {
-			_destroy(i->T_);
+			if (!i->shared)
+				_destroy(i->T_);
 		}
+		for (content_iterator i = contents.begin(); i != contents.end(); ++i)
+			_destroy(i->second.payload);
 		resources.clear();
-		name_to_ref.clear();
+		contents.clear();
+		name_slots.clear();
+		name_count = 0;
+		released.clear();
+		total_size = shared_size = 0;
+	}
+
+	/// Set the number of bytes accounted to a resource.
+	void SetSize(RefType ref, size_t size) {
+		if (!resources.is_valid(ref.ref))
+			return;
+
+		name_T &nt = resources[ref.ref.idx];
+		if (nt.shared) {
+			content_T &content = contents[nt.content_hash];
+			total_size = total_size - content.size + size;
+			shared_size = shared_size - (content.count - 1) * content.size + (content.count - 1) * size;
+			content.size = size;
+		} else {
+			total_size = total_size - nt.size + size;
+			nt.size = size;
+		}
+	}
+
+	size_t GetSize(RefType ref) const {
+		if (!resources.is_valid(ref.ref))
+			return 0;
+		const name_T &nt = resources[ref.ref.idx];
+		return nt.shared ? contents.find(nt.content_hash)->second.size : nt.size;
+	}
+
+	size_t GetTotalSize() const { return total_size; }
+
+	/// Register the payload of a resource with its content and the hash of its content so that resources with identical content can share it.
+	/// The content is swapped into the cache. Does nothing if another payload is already registered under this hash.
+	void SetContentHash(RefType ref, uint64_t hash, std::vector<uint8_t> &content) {
+		if (!resources.is_valid(ref.ref) || contents.count(hash))
+			return;
+
+		name_T &nt = resources[ref.ref.idx];
+		if (nt.shared)
+			return;
+
+		content_T &entry = contents[hash];
+		entry.payload = nt.T_;
+		entry.size = nt.size;
+		entry.count = 1;
+		entry.content.swap(content);
+
+		nt.shared = true;
+		nt.content_hash = hash;
+		nt.size = 0; // now accounted by the content entry
+	}
+
+	/// Replace the payload of a resource with the payload registered with the same content, return false if no payload is registered with this content.
+	bool ShareContent(RefType ref, uint64_t hash, const std::vector<uint8_t> &content) {
+		if (!resources.is_valid(ref.ref))
+			return false;
+
+		const content_iterator i = contents.find(hash);
+		if (i == contents.end() || i->second.content != content)
+			return false;
+
+		name_T &nt = resources[ref.ref.idx];
+		if (nt.shared && nt.content_hash == hash)
+			return true;
+
+		release_payload(nt);
+
+		nt.T_ = i->second.payload;
+		nt.shared = true;
+		nt.content_hash = hash;
+
+		++i->second.count;
+		shared_size += i->second.size;
+		return true;
+	}
+
+	/// Return true if a resource payload is registered under a content hash, whether shared with other resources or not.
+	bool HasContentHash(RefType ref) const { return resources.is_valid(ref.ref) && resources[ref.ref.idx].shared; }
+
+	/// Number of bytes saved by resources sharing their payload.
+	size_t GetSharedSize() const { return shared_size; }
+
+	/// Mark a resource as the most recently used one.
+	void Touch(RefType ref) {
+		if (resources.is_valid(ref.ref))
+			resources[ref.ref.idx].last_use = ++use_clock;
+	}
+
+	/// A pinned resource is never evicted.
+	void Pin(RefType ref) {
+		if (resources.is_valid(ref.ref))
+			++resources[ref.ref.idx].pin_count;
+	}
+
+	void Unpin(RefType ref) {
+		if (resources.is_valid(ref.ref) && resources[ref.ref.idx].pin_count)
+			--resources[ref.ref.idx].pin_count;
+	}
+
+	bool IsPinned(RefType ref) const { return resources.is_valid(ref.ref) && resources[ref.ref.idx].pin_count; }
+
+	void AddRef(RefType ref) {
+		if (resources.is_valid(ref.ref))
+			++resources[ref.ref.idx].ref_count;
+	}
+
+	/// Release a reference, the resource is queued for destruction by DestroyReleased when no reference is left.
+	void Release(RefType ref) {
+		if (resources.is_valid(ref.ref) && resources[ref.ref.idx].ref_count)
+			if (--resources[ref.ref.idx].ref_count == 0)
+				released.push_back(ref);
+	}
+
+	uint32_t GetRefCount(RefType ref) const { return resources.is_valid(ref.ref) ? resources[ref.ref.idx].ref_count : 0; }
+
+	/// Destroy the released resources that are still unreferenced, return the number of destroyed resources. Pinned resources are kept for a later call.
+	size_t DestroyReleased() {
+		size_t count = 0, kept = 0;
+		for (size_t i = 0; i < released.size(); ++i) {
+			const RefType ref = released[i];
+			if (!resources.is_valid(ref.ref) || resources[ref.ref.idx].ref_count)
+				continue;
+
+			if (resources[ref.ref.idx].pin_count) {
+				released[kept++] = ref;
+			} else {
+				Destroy(ref);
+				++count;
+			}
+		}
+		released.resize(kept);
+		return count;
+	}
+
+	/// Set the total size resources can use before they are evicted, unbounded by default.
+	void SetBudget(size_t budget_) { budget = budget_; }
+	size_t GetBudget() const { return budget; }
+
+	/// Destroy the least recently used unpinned and unreferenced resources until the total size fits the budget, return the number of destroyed resources.
+	size_t Evict() {
+		if (total_size <= budget)
+			return 0;
+
+		std::vector<eviction_candidate> candidates;
+		for (gen_ref ref = resources.first_ref(); ref != invalid_gen_ref; ref = resources.next_ref(ref)) {
+			const name_T &e = resources[ref.idx];
+			if (!e.pin_count && !e.ref_count && (e.size || e.shared)) {
+				eviction_candidate c = {e.last_use, ref};
+				candidates.push_back(c);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+
+		size_t count = 0;
+		for (typename std::vector<eviction_candidate>::const_iterator i = candidates.begin(); i != candidates.end() && total_size > budget; ++i, ++count) {
+			RefType ref;
+			ref.ref = i->ref;
+			Destroy(ref);
+		}
+		return count;
 	}
 
 	bool IsValidRef(RefType ref) const { return resources.is_valid(ref.ref); }
@@ -86,21 +443,23 @@ public:
 	uint16_t GetValidatedRefIndex(RefType ref) const { return resources.is_valid(ref.ref) ? numeric_cast<uint16_t>(ref.ref.idx) : 0xffff; }
 
 	RefType Has(const std::string &name) const {
-		const_dict_iterator i = name_to_ref.find(name);
-		return i != name_to_ref.end() ? i->second : RefType();
+		const size_t i = find_name(name, hash_name(name));
+		return i != npos ? name_slots[i].ref : RefType();
 	}
 
 	size_t GetCount() const { return resources.size(); }
 
 	void SetName(RefType ref, const std::string &name) {
 		if (resources.is_valid(ref.ref))
-			resources[ref.ref.idx].name = name;
+			rename(ref, name);
 	}
 
 	void SetName_unsafe_(uint16_t idx, const std::string &name) {
 		if (idx != 0xffff) {
 			__ASSERT__(resources.is_used(idx));
-			resources[idx].name = name;
+			RefType ref;
+			ref.ref = resources.get_ref(idx);
+			rename(ref, name);
 		}
 	}
 
@@ -126,41 +485,26 @@ public:
 	}
 
 	const T &Get(const std::string &name) const {
-		const_dict_iterator i = name_to_ref.find(name);
-		return i != name_to_ref.end() ? resources[i->second.ref.idx].T_ : dflt;
+		const size_t i = find_name(name, hash_name(name));
+		return i != npos ? resources[name_slots[i].ref.ref.idx].T_ : dflt;
 	}
 
 	gen_ref first_ref() const { return resources.first_ref(); }
 	gen_ref next_ref(gen_ref ref) const { return resources.next_ref(ref); }
 
-#if 0
-
-#if __cplusplus >= 201103L
-	R Add(const std::string &name, T &&res) {
-		auto i = name_to_ref.find(name);
-		if (i != name_to_ref.end())
-			return i->second;
-
-		R ref = {resources.add_ref({name, std::move(res)})};
-		name_to_ref[name] = ref;
-		return ref;
-	}
-
-	void Update(R ref, T &&res) {
-		if (resources.is_valid(ref.ref)) {
-			_destroy(resources[ref.ref.idx].T_);
-			resources[ref.ref.idx].T_ = std::move(res);
-		}
-	}
-#endif
-
-#endif
-
 private:
 	T dflt;
 
 	generational_vector_list<name_T> resources;
-	std::map<const std::string, RefType> name_to_ref;
+	std::vector<name_slot> name_slots; // power of 2 size
+	size_t name_count;
+
+	std::map<uint64_t, content_T> contents; // payloads registered by content hash
+
+	size_t total_size, budget, shared_size;
+	uint32_t use_clock;
+
+	std::vector<RefType> released; // references dropped to zero since the last DestroyReleased
 
 	void (*_destroy)(T &);
 };
@@ -6,23 +6,46 @@
 #include "engine/json.h"
 #include "engine/render_pipeline.h"
 
+#include "foundation/data.h"
 #include "foundation/data_rw_interface.h"
+#include "foundation/file.h"
 #include "foundation/file_rw_interface.h"
+#include "foundation/frame_arena.h"
 #include "foundation/log.h"
+#include "foundation/path_tools.h"
 #include "foundation/pack_float.h"
 #include "foundation/profiler.h"
 #include "foundation/string.h"
 
+#include <algorithm>
 #include <fmt/format.h>
+#include <iterator>
 #include <numeric>
 #include <set>
+#include <xxhash.h>
 
 namespace hg {
 
-Scene::Scene() : scene_ref(new SceneRef(this)) {}
+Scene::Scene() : resource_refs_owner(nullptr), scene_ref(new SceneRef(this)), gc_side_maps_dirty(false), gc_anims_dirty(false) {
+	nodes.set_memory_tag(MT_Scene);
+
+	transforms.set_memory_tag(MT_Scene);
+	cameras.set_memory_tag(MT_Scene);
+	objects.set_memory_tag(MT_Scene);
+	lights.set_memory_tag(MT_Scene);
+	rigid_bodies.set_memory_tag(MT_Scene);
+	collisions.set_memory_tag(MT_Scene);
+	scripts.set_memory_tag(MT_Scene);
+	instances.set_memory_tag(MT_Scene);
+
+	anims.set_memory_tag(MT_Anim);
+	scene_anims.set_memory_tag(MT_Anim);
+	play_anims.set_memory_tag(MT_Anim);
+}
 
 Scene::~Scene() {
 	Clear();
+	__ASSERT__(model_refs.empty() && texture_refs.empty());
 
 	scene_ref->scene = nullptr;
 }
@@ -90,159 +113,173 @@ void Scene::Clear() {
 
 	//
 	key_values.clear();
-}
 
-size_t Scene::GarbageCollectPass() {
-	size_t removed_count = 0;
+	if (resource_refs_owner)
+		ReleaseResourceRefs(*resource_refs_owner);
 
-#define GC_Components(LIST, IDX, ON_REMOVE)                                                                                                                    \
-	{                                                                                                                                                          \
-		std::vector<bool> is_refd(LIST.capacity(), false);                                                                                                     \
-                                                                                                                                                               \
-		for (uint32_t i = nodes.first(); i != generational_vector_list<Node_>::invalid_idx; i = nodes.next(i)) {                                               \
-			const ComponentRef ref = nodes[i].components[IDX];                                                                                                 \
-			if (LIST.is_valid(ref))                                                                                                                            \
-				is_refd[ref.idx] = true;                                                                                                                       \
-		}                                                                                                                                                      \
-                                                                                                                                                               \
-		for (size_t i = 0; i < is_refd.size(); ++i)                                                                                                            \
-			if (!is_refd[i] && LIST.is_used(uint32_t(i))) {                                                                                                    \
-				ON_REMOVE(LIST.get_ref(uint32_t(i)));                                                                                                          \
-				++removed_count;                                                                                                                               \
-			}                                                                                                                                                  \
-	}
-
-	GC_Components(transforms, NCI_Transform, DestroyTransform);
-	GC_Components(cameras, NCI_Camera, DestroyCamera);
-	GC_Components(lights, NCI_Light, DestroyLight);
-	GC_Components(objects, NCI_Object, DestroyObject);
-	GC_Components(rigid_bodies, NCI_RigidBody, DestroyRigidBody);
+	//
+	gc_nodes.clear();
+	gc_views.clear();
+	gc_side_maps_dirty = false;
+	gc_anims_dirty = false;
+}
 
-	// cleanup collisions
+void Scene::DestroyNodeSideMaps_(NodeRef ref) {
 	{
-		std::vector<bool> is_refd(collisions.capacity(), false);
-
-		for (std::map<NodeRef, std::vector<ComponentRef> >::iterator i = node_collisions.begin(); i != node_collisions.end();) {
-			if (nodes.is_valid(i->first)) {
-				std::vector<ComponentRef> &i_collisions = i->second;
-
-				for (std::vector<ComponentRef>::iterator j = i_collisions.begin(); j != i_collisions.end(); ++j)
-					if (collisions.is_valid(*j))
-						is_refd[j->idx] = true;
-					else
-						*j = InvalidComponentRef;
-
-				++i;
-			} else {
-				node_collisions.erase(i++);
-			}
+		const gen_ref_map<std::vector<ComponentRef> >::iterator i = node_collisions.find(ref);
+		if (i != node_collisions.end()) {
+			for (std::vector<ComponentRef>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+				collisions.unref(*j);
+			node_collisions.erase(i);
 		}
-
-		for (size_t i = 0; i < is_refd.size(); ++i)
-			if (!is_refd[i] && collisions.is_used(uint32_t(i))) {
-				DestroyCollision(collisions.get_ref(uint32_t(i)));
-				++removed_count;
-			}
 	}
 
-	// cleanup instances
 	{
-		std::vector<bool> is_refd(instances.capacity(), false);
-
-		for (std::map<NodeRef, ComponentRef>::iterator i = node_instance.begin(); i != node_instance.end();) {
-			if (nodes.is_valid(i->first) && instances.is_valid(i->second)) {
-				is_refd[i->second.idx] = true;
-				++i;
-			} else {
-				node_instance.erase(i++);
-			}
+		const gen_ref_map<std::vector<ComponentRef> >::iterator i = node_scripts.find(ref);
+		if (i != node_scripts.end()) {
+			for (std::vector<ComponentRef>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+				scripts.unref(*j);
+			node_scripts.erase(i);
 		}
+	}
 
-		for (size_t i = 0; i < is_refd.size(); ++i)
-			if (!is_refd[i] && instances.is_used(uint32_t(i))) {
-				DestroyInstance(instances.get_ref(uint32_t(i)));
-				++removed_count;
-			}
+	{
+		const gen_ref_map<ComponentRef>::iterator i = node_instance.find(ref);
+		if (i != node_instance.end()) {
+			instances.unref(i->second);
+			node_instance.erase(i);
+		}
 	}
 
-	// cleanup instance views
 	{
-		for (std::map<NodeRef, SceneView>::iterator i = node_instance_view.begin(); i != node_instance_view.end();) {
-			bool is_node_instance_view_still_valid = true;
+		const gen_ref_map<SceneView>::iterator i = node_instance_view.find(ref);
+		if (i != node_instance_view.end()) {
+			gc_views.push_back(i->second); // instance content is destroyed by the garbage collector
+			node_instance_view.erase(i);
+		}
+	}
+}
 
-			const std::map<NodeRef, ComponentRef>::iterator j = node_instance.find(i->first);
+void Scene::GarbageCollectNode_(NodeRef ref) {
+	// an instance view is only valid as long as its node references a valid instance component
+	const gen_ref_map<SceneView>::iterator i = node_instance_view.find(ref);
+	if (i == node_instance_view.end())
+		return;
 
-			if (j == node_instance.end()) {
-				is_node_instance_view_still_valid = false; // node not found
-			} else {
-				if (!instances.is_valid(j->second))
-					is_node_instance_view_still_valid = false; // node references an invalid component
-			}
+	const gen_ref_map<ComponentRef>::const_iterator j = node_instance.find(ref);
 
-			if (is_node_instance_view_still_valid) {
-				++i;
-			} else {
-				DestroyViewContent(i->second);
-				node_instance_view.erase(i++);
-			}
-		}
+	if (j == node_instance.end() || !instances.is_valid(j->second)) {
+		const SceneView view = i->second;
+		node_instance_view.erase(i);
+		DestroyViewContent(view);
 	}
+}
+
+void Scene::GarbageCollectSideMaps_() {
+	// cleanup collisions
+	for (gen_ref_map<std::vector<ComponentRef> >::iterator i = node_collisions.begin(); i != node_collisions.end(); ++i)
+		if (nodes.is_valid(i->first))
+			for (std::vector<ComponentRef>::iterator j = i->second.begin(); j != i->second.end(); ++j)
+				if (!collisions.is_valid(*j))
+					*j = InvalidComponentRef;
+
+	// cleanup instances
+	for (gen_ref_map<ComponentRef>::iterator i = node_instance.begin(); i != node_instance.end(); ++i)
+		if (!instances.is_valid(i->second))
+			gc_nodes.push_back(i->first);
+
+	for (gen_ref_map<SceneView>::iterator i = node_instance_view.begin(); i != node_instance_view.end(); ++i)
+		if (node_instance.find(i->first) == node_instance.end())
+			gc_nodes.push_back(i->first);
 
 	// cleanup scripts
-	{
-		std::vector<bool> is_refd(scripts.capacity(), false);
+	for (std::vector<ComponentRef>::const_iterator i = scene_scripts.begin(); i != scene_scripts.end(); ++i)
+		if (!scripts.is_valid(*i))
+			scripts_detached_from_scene.insert(*i);
 
-		for (std::vector<ComponentRef>::const_iterator i = scene_scripts.begin(); i != scene_scripts.end(); ++i) {
-			if (scripts.is_valid(*i))
-				is_refd[i->idx] = true;
-			else
-				scripts_detached_from_scene.insert(*i);
-		}
+	for (gen_ref_map<std::vector<ComponentRef> >::iterator i = node_scripts.begin(); i != node_scripts.end(); ++i)
+		if (nodes.is_valid(i->first))
+			for (std::vector<ComponentRef>::iterator j = i->second.begin(); j != i->second.end(); ++j)
+				if (!scripts.is_valid(*j))
+					scripts_detached_from_nodes[*j].insert(i->first);
+}
 
-		for (std::map<NodeRef, std::vector<ComponentRef> >::iterator i = node_scripts.begin(); i != node_scripts.end();) {
-			if (nodes.is_valid(i->first)) {
-				for (std::vector<ComponentRef>::iterator j = i->second.begin(); j != i->second.end(); ++j) {
-					if (scripts.is_valid(*j))
-						is_refd[j->idx] = true;
-					else
-						scripts_detached_from_nodes[*j].insert(i->first);
-				}
-				++i;
-			} else {
-				node_scripts.erase(i++);
-			}
-		}
+template <typename T> static bool GarbageCollectComponent_(T &l, Scene &scene, void (Scene::*destroy)(ComponentRef), size_t &removed_count) {
+	if (l.unreferenced.empty())
+		return false;
 
-		for (size_t i = 0; i < is_refd.size(); ++i)
-			if (!is_refd[i] && scripts.is_used(uint32_t(i))) {
-				DestroyScript(scripts.get_ref(uint32_t(i))); // destroy component, VM side representation will be garbage collected at a later point
-				++removed_count;
-			}
+	const ComponentRef ref = l.unreferenced.back();
+	l.unreferenced.pop_back();
+
+	if (l.is_valid(ref) && l.refcount(ref) == 0) {
+		(scene.*destroy)(ref);
+		++removed_count;
 	}
+	return true;
+}
 
-	// cleanup anims
-	{ removed_count += GarbageCollectAnims(); }
+bool Scene::GarbageCollectStep_(size_t &removed_count) {
+	if (gc_side_maps_dirty) {
+		GarbageCollectSideMaps_();
+		gc_side_maps_dirty = false;
+		return true;
+	}
 
-	return removed_count;
-}
+	if (!gc_nodes.empty()) {
+		const NodeRef ref = gc_nodes.back();
+		gc_nodes.pop_back();
+		GarbageCollectNode_(ref);
+		return true;
+	}
 
-size_t Scene::GarbageCollect() {
-	const time_ns t_start = time_now();
+	if (!gc_views.empty()) {
+		const SceneView view = gc_views.back();
+		gc_views.pop_back();
+		DestroyViewContent(view);
+		return true;
+	}
 
-	// n-pass to cleanup node/component
-	size_t total_removed = 0, pass_count = 0;
+	if (GarbageCollectComponent_(instances, *this, &Scene::DestroyInstance, removed_count) ||
+		GarbageCollectComponent_(transforms, *this, &Scene::DestroyTransform, removed_count) ||
+		GarbageCollectComponent_(cameras, *this, &Scene::DestroyCamera, removed_count) ||
+		GarbageCollectComponent_(lights, *this, &Scene::DestroyLight, removed_count) ||
+		GarbageCollectComponent_(objects, *this, &Scene::DestroyObject, removed_count) ||
+		GarbageCollectComponent_(rigid_bodies, *this, &Scene::DestroyRigidBody, removed_count) ||
+		GarbageCollectComponent_(collisions, *this, &Scene::DestroyCollision, removed_count) ||
+		// destroy component, VM side representation will be garbage collected at a later point
+		GarbageCollectComponent_(scripts, *this, &Scene::DestroyScript, removed_count))
+		return true;
 
-	for (;; ++pass_count) {
-		const size_t pass_removed = GarbageCollectPass();
-		if (pass_removed == 0)
-			break;
-		total_removed += pass_removed;
+	if (gc_anims_dirty) {
+		removed_count += GarbageCollectAnims();
+		gc_anims_dirty = false;
+		return true;
 	}
 
-	// stats
-	const time_ns t_total = time_now() - t_start;
+	return false;
+}
 
-	return total_removed;
+bool Scene::IsGarbageCollectPending() const {
+	return gc_side_maps_dirty || gc_anims_dirty || !gc_nodes.empty() || !gc_views.empty() || !instances.unreferenced.empty() || !transforms.unreferenced.empty() ||
+		   !cameras.unreferenced.empty() || !lights.unreferenced.empty() || !objects.unreferenced.empty() || !rigid_bodies.unreferenced.empty() ||
+		   !collisions.unreferenced.empty() || !scripts.unreferenced.empty();
+}
+
+size_t Scene::GarbageCollect() {
+	size_t removed_count = 0;
+	while (GarbageCollectStep_(removed_count))
+		;
+	return removed_count;
+}
+
+size_t Scene::GarbageCollect(time_ns t_budget) {
+	const time_ns t_end = time_now() + t_budget;
+
+	size_t removed_count = 0;
+	for (size_t i = 0; GarbageCollectStep_(removed_count); ++i)
+		if ((i & 63) == 63 && time_now() >= t_end)
+			break; // out of budget, resume on next call
+	return removed_count;
 }
 
 //
@@ -506,7 +543,61 @@ Node Scene::CreateNode(std::string name) {
 	return node;
 }
 
-void Scene::DestroyNode(NodeRef ref) { nodes.remove_ref(ref); }
+std::vector<NodeRef> Scene::CreateNodes(size_t count, uint32_t components, const std::string &name) {
+	ReserveNodes(count);
+
+	if (components & NCM_Transform)
+		ReserveTransforms(count);
+	if (components & NCM_Camera)
+		ReserveCameras(count);
+	if (components & NCM_Object)
+		ReserveObjects(count);
+	if (components & NCM_Light)
+		ReserveLights(count);
+	if (components & NCM_RigidBody)
+		rigid_bodies.reserve(rigid_bodies.size() + count);
+
+	std::vector<NodeRef> refs(count);
+
+	Node_ node_;
+	node_.name = name;
+
+	for (size_t i = 0; i < count; ++i) {
+		const NodeRef ref = refs[i] = nodes.add_ref(node_);
+		ComponentRef *node_components = nodes[ref.idx].components;
+
+		if (components & NCM_Transform)
+			SetComponentRef_(transforms, node_components[NCI_Transform], CreateTransform().ref);
+		if (components & NCM_Camera)
+			SetComponentRef_(cameras, node_components[NCI_Camera], CreateCamera().ref);
+		if (components & NCM_Object)
+			SetComponentRef_(objects, node_components[NCI_Object], CreateObject().ref);
+		if (components & NCM_Light)
+			SetComponentRef_(lights, node_components[NCI_Light], CreateLight().ref);
+		if (components & NCM_RigidBody)
+			SetComponentRef_(rigid_bodies, node_components[NCI_RigidBody], CreateRigidBody().ref);
+	}
+
+	return refs;
+}
+
+void Scene::DestroyNodes(const std::vector<NodeRef> &refs) {
+	for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+		DestroyNode(*i);
+}
+
+void Scene::DestroyNode(NodeRef ref) {
+	if (const Node_ *node_ = GetNode_(ref)) {
+		transforms.unref(node_->components[NCI_Transform]);
+		cameras.unref(node_->components[NCI_Camera]);
+		objects.unref(node_->components[NCI_Object]);
+		lights.unref(node_->components[NCI_Light]);
+		rigid_bodies.unref(node_->components[NCI_RigidBody]);
+
+		DestroyNodeSideMaps_(ref); // node slot might be reused before the next garbage collection
+		nodes.remove_ref(ref);
+	}
+}
 
 //
 void Scene::EnableNode_(NodeRef ref, bool through_instance) {
@@ -521,7 +612,7 @@ void Scene::EnableNode_(NodeRef ref, bool through_instance) {
 	if (nodes[ref.idx].flags & (NF_Disabled | NF_InstanceDisabled)) // [EJ11262019] only if fully enabled
 		return;
 
-	const std::map<NodeRef, SceneView>::const_iterator i = node_instance_view.find(ref);
+	const gen_ref_map<SceneView>::const_iterator i = node_instance_view.find(ref);
 	if (i != node_instance_view.end())
 		for (std::vector<NodeRef>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
 			EnableNode_(*j, true);
@@ -536,7 +627,7 @@ void Scene::DisableNode_(NodeRef ref, bool through_instance) {
 	nodes[ref.idx].flags |= through_instance ? NF_InstanceDisabled : NF_Disabled;
 
 	// disable instance content
-	const std::map<NodeRef, SceneView>::const_iterator i = node_instance_view.find(ref);
+	const gen_ref_map<SceneView>::const_iterator i = node_instance_view.find(ref);
 	if (i != node_instance_view.end())
 		for (std::vector<NodeRef>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
 			DisableNode_(*j, true);
@@ -547,7 +638,7 @@ void Scene::DisableNode(NodeRef ref) { DisableNode_(ref, false); }
 
 //
 NodeRef Scene::IsInstantiatedBy(NodeRef ref) const {
-	for (std::map<NodeRef, SceneView>::const_iterator i = node_instance_view.begin(); i != node_instance_view.end(); ++i)
+	for (gen_ref_map<SceneView>::const_iterator i = node_instance_view.begin(); i != node_instance_view.end(); ++i)
 		for (std::vector<NodeRef>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
 			if (*j == ref)
 				return i->first;
@@ -560,8 +651,12 @@ void Scene::ReserveNodes(const size_t count) { nodes.reserve(nodes.size() + coun
 
 //
 Node Scene::GetNode(const std::string &name) const {
+	atom name_;
+	if (!FindAtom(name, name_))
+		return Node(); // no node can be named so
+
 	for (gen_ref i = nodes.first_ref(); i != InvalidNodeRef; i = nodes.next_ref(i))
-		if (nodes[i.idx].name == name) {
+		if (nodes[i.idx].name == name_) {
 			Node node;
 			node.scene_ref = scene_ref;
 			node.ref = i;
@@ -592,14 +687,18 @@ NodeRef Scene::GetNodeEx_(const std::vector<NodeRef> &refs, const std::string &p
 			break;
 		}
 
-	const std::string name = left(path, s), remainder = slice(path, s + 1);
+	const std::string remainder = slice(path, s + 1);
+
+	atom name;
+	if (!FindAtom(left(path, s), name))
+		return InvalidNodeRef;
 
 	for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
 		if (nodes[i->idx].name == name) {
 			if (mode == 0) {
 				return *i; // look no further
 			} else if (mode == 1) {
-				const std::map<NodeRef, SceneView>::const_iterator j = node_instance_view.find(*i); // look in instance
+				const gen_ref_map<SceneView>::const_iterator j = node_instance_view.find(*i); // look in instance
 				if (j == node_instance_view.end())
 					return InvalidNodeRef; // not an instance
 
@@ -807,7 +906,7 @@ ComponentRef Scene::GetNodeTransformRef(NodeRef ref) const { return GetNodeCompo
 
 void Scene::SetNodeTransform(NodeRef ref, ComponentRef cref) {
 	if (Node_ *node_ = this->GetNode_(ref))
-		node_->components[NCI_Transform] = cref;
+		SetComponentRef_(transforms, node_->components[NCI_Transform], cref);
 	else
 		warn("Invalid node");
 }
@@ -884,7 +983,7 @@ ComponentRef Scene::GetNodeCameraRef(NodeRef ref) const { return GetNodeComponen
 
 void Scene::SetNodeCamera(NodeRef ref, ComponentRef cref) {
 	if (Node_ *node_ = this->GetNode_(ref))
-		node_->components[NCI_Camera] = cref;
+		SetComponentRef_(cameras, node_->components[NCI_Camera], cref);
 	else
 		warn("Invalid node");
 }
@@ -901,7 +1000,7 @@ ComponentRef Scene::GetNodeObjectRef(NodeRef ref) const { return GetNodeComponen
 
 void Scene::SetNodeObject(NodeRef ref, ComponentRef cref) {
 	if (Node_ *node_ = this->GetNode_(ref))
-		node_->components[NCI_Object] = cref;
+		SetComponentRef_(objects, node_->components[NCI_Object], cref);
 	else
 		warn("Invalid node");
 }
@@ -918,7 +1017,7 @@ ComponentRef Scene::GetNodeLightRef(NodeRef ref) const { return GetNodeComponent
 
 void Scene::SetNodeLight(NodeRef ref, ComponentRef cref) {
 	if (Node_ *node_ = this->GetNode_(ref))
-		node_->components[NCI_Light] = cref;
+		SetComponentRef_(lights, node_->components[NCI_Light], cref);
 	else
 		warn("Invalid node");
 }
@@ -935,7 +1034,7 @@ ComponentRef Scene::GetNodeRigidBodyRef(NodeRef ref) const { return GetNodeCompo
 
 void Scene::SetNodeRigidBody(NodeRef ref, ComponentRef cref) {
 	if (Node_ *node_ = this->GetNode_(ref))
-		node_->components[NCI_RigidBody] = cref;
+		SetComponentRef_(rigid_bodies, node_->components[NCI_RigidBody], cref);
 	else
 		warn("Invalid node");
 }
@@ -948,7 +1047,7 @@ RigidBody Scene::GetNodeRigidBody(NodeRef ref) const {
 }
 
 ComponentRef Scene::GetNodeCollisionRef(NodeRef ref, size_t idx) const {
-	const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_collisions.find(ref) : node_collisions.end();
+	const gen_ref_map<std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_collisions.find(ref) : node_collisions.end();
 	return i != node_collisions.end() && idx < i->second.size() ? i->second[idx] : InvalidComponentRef;
 }
 
@@ -966,8 +1065,10 @@ Collision Scene::GetNodeCollision(NodeRef ref, size_t idx) const {
 
 void Scene::SetNodeCollision(NodeRef ref, size_t idx, const Collision &collision) {
 	if (nodes.is_valid(ref)) {
-		node_collisions[ref].resize(idx + 1);
-		node_collisions[ref][idx] = collision.ref;
+		std::vector<ComponentRef> &refs = node_collisions[ref];
+		if (idx >= refs.size())
+			refs.resize(idx + 1);
+		SetComponentRef_(collisions, refs[idx], collision.ref);
 	} else {
 		warn("Invalid node");
 	}
@@ -979,7 +1080,7 @@ void Scene::RemoveNodeCollision(NodeRef ref, ComponentRef cref) {
 
 		for (size_t slot_idx = 0; slot_idx < collisions.size(); ++slot_idx)
 			if (collisions[slot_idx] == cref)
-				collisions[slot_idx] = invalid_gen_ref;
+				SetComponentRef_(this->collisions, collisions[slot_idx], invalid_gen_ref);
 
 		_ResizeComponents(collisions);
 	} else {
@@ -993,7 +1094,7 @@ void Scene::RemoveNodeCollision(NodeRef ref, size_t slot_idx) {
 
 		if (slot_idx < collisions.size())
 			if (collisions[slot_idx] != invalid_gen_ref)
-				collisions[slot_idx] = invalid_gen_ref;
+				SetComponentRef_(this->collisions, collisions[slot_idx], invalid_gen_ref);
 
 		_ResizeComponents(collisions);
 	} else {
@@ -1111,7 +1212,11 @@ Collision Scene::CreateCollision() {
 	return collision;
 }
 
-void Scene::DestroyCollision(ComponentRef ref) { collisions.remove_ref(ref); }
+void Scene::DestroyCollision(ComponentRef ref) {
+	if (collisions.refcount(ref))
+		gc_side_maps_dirty = true;
+	collisions.remove_ref(ref);
+}
 
 void Scene::SetCollisionType(ComponentRef ref, CollisionType type) {
 	if (Collision_ *col = GetComponent_(collisions, ref))
@@ -1250,7 +1355,7 @@ std::string Scene::GetCollisionResource(ComponentRef ref) {
 
 //
 size_t Scene::GetNodeCollisionCount(NodeRef ref) const {
-	std::map<NodeRef, std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_collisions.find(ref) : node_collisions.end();
+	gen_ref_map<std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_collisions.find(ref) : node_collisions.end();
 	return i != node_collisions.end() ? i->second.size() : 0;
 }
 
@@ -1323,7 +1428,11 @@ Instance Scene::CreateInstance() {
 	return instance;
 }
 
-void Scene::DestroyInstance(ComponentRef ref) { instances.remove_ref(ref); }
+void Scene::DestroyInstance(ComponentRef ref) {
+	if (instances.refcount(ref))
+		gc_side_maps_dirty = true;
+	instances.remove_ref(ref);
+}
 
 void Scene::SetInstancePath(ComponentRef ref, const std::string &path) {
 	if (instances.is_valid(ref))
@@ -1400,17 +1509,31 @@ Instance Scene::GetNodeInstance(NodeRef ref) const {
 }
 
 ComponentRef Scene::GetNodeInstanceRef(NodeRef ref) const {
-	const std::map<NodeRef, ComponentRef>::const_iterator i = node_instance.find(ref);
+	const gen_ref_map<ComponentRef>::const_iterator i = node_instance.find(ref);
 	if (i != node_instance.end())
 		return i->second;
 	return InvalidComponentRef;
 }
 
 void Scene::SetNodeInstance(NodeRef ref, ComponentRef cref) {
-	if (cref == InvalidComponentRef)
-		node_instance.erase(ref);
-	else
-		node_instance[ref] = cref;
+	const gen_ref_map<ComponentRef>::iterator i = node_instance.find(ref);
+
+	if (cref == InvalidComponentRef) {
+		if (i != node_instance.end()) {
+			instances.unref(i->second);
+			node_instance.erase(i);
+		}
+	} else {
+		instances.ref(cref);
+		if (i != node_instance.end()) {
+			instances.unref(i->second);
+			i->second = cref;
+		} else {
+			node_instance[ref] = cref;
+		}
+	}
+
+	gc_nodes.push_back(ref); // instance view might no longer be valid
 }
 
 void Scene::DestroyViewContent(const SceneView &view) {
@@ -1425,11 +1548,12 @@ void Scene::DestroyViewContent(const SceneView &view) {
 void Scene::NodeDestroyInstance(NodeRef ref) {
 	NodeStopOnInstantiateAnim(ref);
 
-	const std::map<NodeRef, SceneView>::iterator i = node_instance_view.find(ref);
+	const gen_ref_map<SceneView>::iterator i = node_instance_view.find(ref);
 
 	if (i != node_instance_view.end()) {
-		DestroyViewContent(i->second);
+		const SceneView view = i->second;
 		node_instance_view.erase(i);
+		DestroyViewContent(view);
 	} else {
 		warn("Invalid node instance view");
 	}
@@ -1438,28 +1562,414 @@ void Scene::NodeDestroyInstance(NodeRef ref) {
 static bool LoadScene(const Reader &ir, const Handle &h, const std::string &name, Scene &scene, const Reader &deps_ir, const ReadProvider &deps_ip,
 	PipelineResources &resources, const PipelineInfo &pipeline, LoadSceneContext &ctx, uint32_t flags);
 
+//
+struct InstancePrototypeKey {
+	std::string name;
+	uint32_t flags;
+	int recursion_level;
+	Handle (*open)(const std::string &path, bool silent); // read provider identity
+	uint32_t resources_uid; // see PipelineResources::uid, an address could be reused by new resources
+};
+
+static bool operator<(const InstancePrototypeKey &a, const InstancePrototypeKey &b) {
+	if (a.name != b.name)
+		return a.name < b.name;
+	if (a.flags != b.flags)
+		return a.flags < b.flags;
+	if (a.recursion_level != b.recursion_level)
+		return a.recursion_level < b.recursion_level;
+	if (a.open != b.open)
+		return std::less<Handle (*)(const std::string &, bool)>()(a.open, b.open);
+	return a.resources_uid < b.resources_uid;
+}
+
+struct InstancePrototypeSource {
+	Reader ir;
+	ReadProvider ip;
+	std::string name;
+	unsigned long long hash;
+};
+
+struct InstancePrototype {
+	InstancePrototype() : hash(0) {}
+
+	shared_ptr<Scene> scene;
+	SceneView view; // prototype content, nested instance content is reached through the instance views of its nodes
+
+	unsigned long long hash; // source content hash
+	std::vector<InstancePrototypeSource> nested_sources; // sources of nested instances, a prototype is stale if any of them changes
+
+	// resources referenced by the prototype, checked by name since the resource cache might have been flushed
+	std::vector<std::pair<ModelRef, std::string> > models;
+	std::vector<std::pair<TextureRef, std::string> > textures;
+};
+
+// instance sources checked during the current load, indexed by name and read provider
+struct InstanceSourceKey {
+	std::string name;
+	Handle (*open)(const std::string &path, bool silent);
+};
+
+static bool operator<(const InstanceSourceKey &a, const InstanceSourceKey &b) {
+	if (a.name != b.name)
+		return a.name < b.name;
+	return std::less<Handle (*)(const std::string &, bool)>()(a.open, b.open);
+}
+
+static std::map<InstanceSourceKey, unsigned long long> instance_source_checks; // source content hashes
+static uint32_t instance_load_depth = 0;
+
+static bool instance_prototype_cache_enabled = true;
+static std::map<InstancePrototypeKey, InstancePrototype> instance_prototypes;
+static std::vector<std::vector<InstancePrototypeSource> *> instance_prototype_loads; // collect nested sources of the prototypes being loaded
+
+void EnableInstancePrototypeCache(bool enable) {
+	instance_prototype_cache_enabled = enable;
+	if (!enable)
+		ClearInstancePrototypeCache();
+}
+
+bool IsInstancePrototypeCacheEnabled() { return instance_prototype_cache_enabled; }
+void ClearInstancePrototypeCache() {
+	instance_prototypes.clear();
+	instance_source_checks.clear();
+}
+size_t GetInstancePrototypeCacheSize() { return instance_prototypes.size(); }
+
+Scene::InstanceLoadScope_::InstanceLoadScope_() { ++instance_load_depth; }
+
+// the outermost scope ends the load, sources checked during it must be read again by the next one
+Scene::InstanceLoadScope_::~InstanceLoadScope_() {
+	if (--instance_load_depth == 0)
+		instance_source_checks.clear();
+}
+
+static InstanceSourceKey MakeInstanceSourceKey(const ReadProvider &ip, const std::string &name) {
+	InstanceSourceKey key;
+	key.name = name;
+	key.open = ip.open;
+	return key;
+}
+
+static bool FindInstanceSourceCheck(const ReadProvider &ip, const std::string &name, unsigned long long &hash) {
+	const std::map<InstanceSourceKey, unsigned long long>::const_iterator i = instance_source_checks.find(MakeInstanceSourceKey(ip, name));
+	if (i == instance_source_checks.end())
+		return false;
+	hash = i->second;
+	return true;
+}
+
+static bool LoadInstanceSource(const Reader &ir, const ReadProvider &ip, const std::string &name, bool silent, Data &data, unsigned long long &hash) {
+	ScopedReadHandle h(ip, name, silent);
+	if (!ir.is_valid(h))
+		return false;
+
+	if (!data.Resize(ir.size(h)) || ir.read(h, data.GetData(), data.GetSize()) != data.GetSize())
+		return false;
+
+	hash = XXH64(data.GetData(), data.GetSize(), 0);
+
+	instance_source_checks[MakeInstanceSourceKey(ip, name)] = hash;
+	return true;
+}
+
+static void AddInstancePrototypeSource(std::vector<InstancePrototypeSource> &sources, const InstancePrototypeSource &source) {
+	for (std::vector<InstancePrototypeSource>::const_iterator i = sources.begin(); i != sources.end(); ++i)
+		if (i->name == source.name && i->ip.open == source.ip.open)
+			return;
+	sources.push_back(source);
+}
+
+static bool AreInstancePrototypeNestedSourcesValid(const InstancePrototype &proto) {
+	Data data;
+	for (std::vector<InstancePrototypeSource>::const_iterator i = proto.nested_sources.begin(); i != proto.nested_sources.end(); ++i) {
+		unsigned long long hash;
+		if (!FindInstanceSourceCheck(i->ip, i->name, hash) && !LoadInstanceSource(i->ir, i->ip, i->name, true, data, hash))
+			return false;
+		if (hash != i->hash)
+			return false;
+	}
+	return true;
+}
+
+static bool AreInstancePrototypeResourcesValid(const InstancePrototype &proto, const PipelineResources &resources) {
+	for (std::vector<std::pair<ModelRef, std::string> >::const_iterator i = proto.models.begin(); i != proto.models.end(); ++i)
+		if (resources.models.GetName(i->first) != i->second)
+			return false;
+	for (std::vector<std::pair<TextureRef, std::string> >::const_iterator i = proto.textures.begin(); i != proto.textures.end(); ++i)
+		if (resources.textures.GetName(i->first) != i->second)
+			return false;
+	return true;
+}
+
+bool Scene::LoadInstance_(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, const PipelineInfo &pipeline,
+	LoadSceneContext &ctx, uint32_t flags) {
+	// scene level features go to the host scene and can not be served from a prototype
+	if (!instance_prototype_cache_enabled || (flags & (LSSF_Scene | LSSF_KeyValues)))
+		return LoadScene(ir, ScopedReadHandle(ip, name, flags & LSSF_Silent), name, *this, ir, ip, resources, pipeline, ctx, flags);
+
+	InstanceLoadScope_ scope;
+
+	Data data;
+	unsigned long long hash;
+	const bool checked = FindInstanceSourceCheck(ip, name, hash); // source content is only read when not yet checked during this load
+	if (!checked && !LoadInstanceSource(ir, ip, name, flags & LSSF_Silent, data, hash))
+		return false;
+
+	InstancePrototypeKey key;
+	key.name = name;
+	key.flags = flags;
+	key.recursion_level = ctx.recursion_level;
+	key.open = ip.open;
+	key.resources_uid = resources.uid;
+
+	InstancePrototype &proto = instance_prototypes[key];
+
+	if (!proto.scene || proto.hash != hash || !AreInstancePrototypeNestedSourcesValid(proto) || !AreInstancePrototypeResourcesValid(proto, resources)) {
+		ProfilerPerfSection section("Scene::LoadInstance_: Load Prototype");
+
+		if (checked && !LoadInstanceSource(ir, ip, name, flags & LSSF_Silent, data, hash))
+			return false;
+
+		proto = InstancePrototype();
+		proto.scene = shared_ptr<Scene>(new Scene);
+
+		LoadSceneContext proto_ctx;
+		proto_ctx.recursion_level = ctx.recursion_level;
+
+		instance_prototype_loads.push_back(&proto.nested_sources);
+		const bool loaded = LoadScene(g_data_reader, DataReadHandle(data), name, *proto.scene, ir, ip, resources, pipeline, proto_ctx, flags);
+		instance_prototype_loads.pop_back();
+
+		if (!loaded) {
+			instance_prototypes.erase(key);
+			return false;
+		}
+
+		proto.view = proto_ctx.view;
+		proto.hash = hash;
+
+		const Scene &proto_scene = *proto.scene;
+		for (uint32_t i = proto_scene.objects.first(); i != generational_vector_list<Object_>::invalid_idx; i = proto_scene.objects.next(i)) {
+			const Object_ &o = proto_scene.objects[i];
+			proto.models.push_back(std::make_pair(o.model, resources.models.GetName(o.model)));
+
+			for (std::vector<Material>::const_iterator j = o.materials.begin(); j != o.materials.end(); ++j)
+				for (std::map<atom, Material::Texture>::const_iterator k = j->textures.begin(); k != j->textures.end(); ++k)
+					proto.textures.push_back(std::make_pair(k->second.texture, resources.textures.GetName(k->second.texture)));
+		}
+	}
+
+	if (!instance_prototype_loads.empty()) {
+		std::vector<InstancePrototypeSource> &sources = *instance_prototype_loads.back();
+
+		InstancePrototypeSource source;
+		source.ir = ir;
+		source.ip = ip;
+		source.name = name;
+		source.hash = hash;
+
+		AddInstancePrototypeSource(sources, source);
+		for (std::vector<InstancePrototypeSource>::const_iterator i = proto.nested_sources.begin(); i != proto.nested_sources.end(); ++i)
+			AddInstancePrototypeSource(sources, *i);
+	}
+
+	ProfilerPerfSection section("Scene::LoadInstance_: Clone Prototype");
+
+	CloneRemap_ remap;
+	CloneBegin_(*proto.scene, remap);
+	CloneView_(*proto.scene, proto.view, remap, ctx.view);
+	CloneEnd_(*proto.scene, remap);
+	return true;
+}
+
+//
+void Scene::CloneBegin_(const Scene &src, CloneRemap_ &remap) const {
+	remap.nodes.assign(src.nodes.capacity(), InvalidNodeRef);
+	remap.transforms.assign(src.transforms.capacity(), InvalidComponentRef);
+	remap.cameras.assign(src.cameras.capacity(), InvalidComponentRef);
+	remap.objects.assign(src.objects.capacity(), InvalidComponentRef);
+	remap.lights.assign(src.lights.capacity(), InvalidComponentRef);
+	remap.rigid_bodies.assign(src.rigid_bodies.capacity(), InvalidComponentRef);
+	remap.collisions.assign(src.collisions.capacity(), InvalidComponentRef);
+	remap.scripts.assign(src.scripts.capacity(), InvalidComponentRef);
+	remap.instances.assign(src.instances.capacity(), InvalidComponentRef);
+	remap.anims.assign(src.anims.capacity(), InvalidAnimRef);
+	remap.scene_anims.assign(src.scene_anims.capacity(), InvalidSceneAnimRef);
+	remap.instance_hosts.clear();
+}
+
+NodeRef Scene::CloneNode_(const Scene &src, NodeRef ref, uint32_t flags_mask, CloneRemap_ &remap) {
+	if (!src.nodes.is_valid(ref))
+		return InvalidNodeRef;
+	if (remap.nodes[ref.idx] != InvalidNodeRef)
+		return remap.nodes[ref.idx];
+
+	Node_ node_;
+	{
+		const Node_ &src_node_ = src.nodes[ref.idx];
+
+		node_.name = src_node_.name;
+		node_.flags = src_node_.flags & flags_mask;
+
+		node_.components[NCI_Transform] = CloneComponent_(transforms, src.transforms, src_node_.components[NCI_Transform], remap.transforms);
+		node_.components[NCI_Camera] = CloneComponent_(cameras, src.cameras, src_node_.components[NCI_Camera], remap.cameras);
+		node_.components[NCI_Object] = CloneComponent_(objects, src.objects, src_node_.components[NCI_Object], remap.objects);
+		node_.components[NCI_Light] = CloneComponent_(lights, src.lights, src_node_.components[NCI_Light], remap.lights);
+		node_.components[NCI_RigidBody] = CloneComponent_(rigid_bodies, src.rigid_bodies, src_node_.components[NCI_RigidBody], remap.rigid_bodies);
+	}
+
+	const NodeRef clone_ref = remap.nodes[ref.idx] = nodes.add_ref(node_);
+
+	transforms.ref(node_.components[NCI_Transform]);
+	cameras.ref(node_.components[NCI_Camera]);
+	objects.ref(node_.components[NCI_Object]);
+	lights.ref(node_.components[NCI_Light]);
+	rigid_bodies.ref(node_.components[NCI_RigidBody]);
+
+	{
+		const gen_ref_map<std::vector<ComponentRef> >::const_iterator i = src.node_collisions.find(ref);
+		if (i != src.node_collisions.end()) {
+			std::vector<ComponentRef> refs(i->second.size());
+			for (size_t j = 0; j < refs.size(); ++j) {
+				refs[j] = CloneComponent_(collisions, src.collisions, i->second[j], remap.collisions);
+				collisions.ref(refs[j]);
+			}
+			node_collisions[clone_ref] = refs;
+		}
+	}
+
+	{
+		const gen_ref_map<std::vector<ComponentRef> >::const_iterator i = src.node_scripts.find(ref);
+		if (i != src.node_scripts.end()) {
+			std::vector<ComponentRef> refs(i->second.size());
+			for (size_t j = 0; j < refs.size(); ++j) {
+				refs[j] = CloneComponent_(scripts, src.scripts, i->second[j], remap.scripts);
+				scripts.ref(refs[j]);
+			}
+			node_scripts[clone_ref] = refs;
+		}
+	}
+
+	{
+		const gen_ref_map<ComponentRef>::const_iterator i = src.node_instance.find(ref);
+		if (i != src.node_instance.end()) {
+			const ComponentRef instance_ref = CloneComponent_(instances, src.instances, i->second, remap.instances);
+			if (instance_ref != InvalidComponentRef) {
+				instances[instance_ref.idx].play_anim_ref = InvalidScenePlayAnimRef; // started by CloneEnd_
+				SetNodeInstance(clone_ref, instance_ref);
+			}
+		}
+	}
+
+	if (remap.clone_instance_views) {
+		const gen_ref_map<SceneView>::const_iterator i = src.node_instance_view.find(ref);
+		if (i != src.node_instance_view.end()) {
+			const SceneView src_view = i->second; // cloning the view content might insert in the source side maps
+			SceneView view;
+			CloneView_(src, src_view, remap, view);
+			node_instance_view[clone_ref] = view;
+			remap.instance_hosts.push_back(clone_ref);
+		}
+	}
+
+	return clone_ref;
+}
+
+void Scene::CloneView_(const Scene &src, const SceneView &src_view, CloneRemap_ &remap, SceneView &view) {
+	for (std::vector<NodeRef>::const_iterator i = src_view.nodes.begin(); i != src_view.nodes.end(); ++i) {
+		const NodeRef ref = CloneNode_(src, *i, 0xffffffff, remap);
+		if (ref != InvalidNodeRef)
+			view.nodes.push_back(ref);
+	}
+
+	for (std::vector<AnimRef>::const_iterator i = src_view.anims.begin(); i != src_view.anims.end(); ++i)
+		if (src.anims.is_valid(*i)) {
+			if (remap.anims[i->idx] == InvalidAnimRef) {
+				const Anim anim = src.anims[i->idx];
+				remap.anims[i->idx] = anims.add_ref(anim);
+				gc_anims_dirty = true;
+			}
+			view.anims.push_back(remap.anims[i->idx]);
+		}
+
+	for (std::vector<SceneAnimRef>::const_iterator i = src_view.scene_anims.begin(); i != src_view.scene_anims.end(); ++i)
+		if (src.scene_anims.is_valid(*i)) {
+			if (remap.scene_anims[i->idx] == InvalidSceneAnimRef) {
+				SceneAnim scene_anim = src.scene_anims[i->idx];
+
+				scene_anim.scene_anim = src.anims.is_valid(scene_anim.scene_anim) ? remap.anims[scene_anim.scene_anim.idx] : InvalidAnimRef;
+
+				std::vector<NodeAnim> node_anims;
+				node_anims.reserve(scene_anim.node_anims.size());
+
+				for (std::vector<NodeAnim>::const_iterator j = scene_anim.node_anims.begin(); j != scene_anim.node_anims.end(); ++j)
+					if (src.nodes.is_valid(j->node) && src.anims.is_valid(j->anim)) {
+						NodeAnim node_anim;
+						node_anim.node = remap.nodes[j->node.idx];
+						node_anim.anim = remap.anims[j->anim.idx];
+
+						if (node_anim.node != InvalidNodeRef && node_anim.anim != InvalidAnimRef)
+							node_anims.push_back(node_anim);
+					}
+
+				scene_anim.node_anims = node_anims;
+				remap.scene_anims[i->idx] = scene_anims.add_ref(scene_anim);
+			}
+			view.scene_anims.push_back(remap.scene_anims[i->idx]);
+		}
+}
+
+void Scene::CloneEnd_(const Scene &src, const CloneRemap_ &remap) {
+	// fix parent references
+	for (size_t i = 0; i < remap.transforms.size(); ++i)
+		if (remap.transforms[i] != InvalidComponentRef) {
+			Transform_ &c = transforms[remap.transforms[i].idx];
+			c.parent = src.nodes.is_valid(c.parent) ? remap.nodes[c.parent.idx] : InvalidNodeRef;
+		}
+
+	// fix bone references
+	for (size_t i = 0; i < remap.objects.size(); ++i)
+		if (remap.objects[i] != InvalidComponentRef) {
+			Object_ &c = objects[remap.objects[i].idx];
+			for (std::vector<NodeRef>::iterator j = c.bones.begin(); j != c.bones.end(); ++j)
+				*j = src.nodes.is_valid(*j) ? remap.nodes[j->idx] : InvalidNodeRef;
+		}
+
+	ReadyWorldMatrices();
+
+	for (size_t i = 0; i < remap.transforms.size(); ++i)
+		if (remap.transforms[i] != InvalidComponentRef)
+			ComputeTransformWorldMatrix(remap.transforms[i].idx);
+
+	for (std::vector<NodeRef>::const_iterator i = remap.instance_hosts.begin(); i != remap.instance_hosts.end(); ++i)
+		NodeStartOnInstantiateAnim(*i);
+}
+
 bool Scene::NodeSetupInstance(
 	NodeRef ref, const Reader &ir, const ReadProvider &ip, PipelineResources &resources, const PipelineInfo &pipeline, uint32_t flags, int recursion_level) {
 	if (recursion_level > 4)
 		return true;
 
-	const std::map<NodeRef, ComponentRef>::iterator i = node_instance.find(ref);
+	const gen_ref_map<ComponentRef>::iterator i = node_instance.find(ref);
 	if (i == node_instance.end())
 		return false;
 
 	const bool host_is_enabled = IsNodeEnabled(ref);
 
-	if (instances.is_valid(i->second)) {
+	const ComponentRef instance_ref = i->second; // LoadScene might insert in node_instance and invalidate i
+
+	if (instances.is_valid(instance_ref)) {
 		LoadSceneContext ctx;
 		ctx.recursion_level = recursion_level;
 
 		{
-			const Instance_ &i_ = instances[i->second.idx];
-			if (!LoadScene(ir, ScopedReadHandle(ip, i_.name, flags & LSSF_Silent), i_.name, *this, ir, ip, resources, pipeline, ctx, flags))
+			const std::string name = instances[instance_ref.idx].name;
+			if (!LoadInstance_(ir, ip, name, resources, pipeline, ctx, flags))
 				return false;
 		}
 
-		Instance_ &i_ = instances[i->second.idx]; // [EJ12102019] LoadScene might reallocate instances buffer so fetch i_ anew
+		Instance_ &i_ = instances[instance_ref.idx]; // [EJ12102019] LoadScene might reallocate instances buffer so fetch i_ anew
 
 		for (std::vector<NodeRef>::iterator i = ctx.view.nodes.begin(); i != ctx.view.nodes.end(); ++i) {
 			Node_ &n = nodes[i->idx];
@@ -1488,7 +1998,7 @@ bool Scene::NodeSetupInstance(
 ScenePlayAnimRef Scene::NodeStartOnInstantiateAnim(NodeRef ref) {
 	NodeStopOnInstantiateAnim(ref);
 
-	const std::map<NodeRef, ComponentRef>::iterator i = node_instance.find(ref);
+	const gen_ref_map<ComponentRef>::iterator i = node_instance.find(ref);
 
 	if (i == node_instance.end())
 		return InvalidScenePlayAnimRef; // no instance on node
@@ -1501,7 +2011,7 @@ ScenePlayAnimRef Scene::NodeStartOnInstantiateAnim(NodeRef ref) {
 	if (i_.anim.empty())
 		return InvalidScenePlayAnimRef; // no anim to play on instantiation
 
-	const std::map<NodeRef, SceneView>::iterator i_view = node_instance_view.find(ref);
+	const gen_ref_map<SceneView>::iterator i_view = node_instance_view.find(ref);
 
 	if (i_view == node_instance_view.end())
 		return InvalidScenePlayAnimRef; // no instance view
@@ -1511,7 +2021,7 @@ ScenePlayAnimRef Scene::NodeStartOnInstantiateAnim(NodeRef ref) {
 }
 
 void Scene::NodeStopOnInstantiateAnim(NodeRef ref) {
-	const std::map<NodeRef, ComponentRef>::iterator i = node_instance.find(ref);
+	const gen_ref_map<ComponentRef>::iterator i = node_instance.find(ref);
 
 	if (i == node_instance.end())
 		return; // no instance on node
@@ -1535,7 +2045,7 @@ bool Scene::NodeSetupInstanceFromAssets(NodeRef ref, PipelineResources &resource
 
 const SceneView &Scene::GetNodeInstanceSceneView(NodeRef ref) const {
 	static SceneView dummy_view;
-	const std::map<NodeRef, SceneView>::const_iterator i = node_instance_view.find(ref);
+	const gen_ref_map<SceneView>::const_iterator i = node_instance_view.find(ref);
 	if (i == node_instance_view.end()) {
 		warn(fmt::format("No instance scene view on node ({}:{})", ref.idx, ref.gen));
 		return dummy_view;
@@ -1554,11 +2064,11 @@ void Scene::NodeMoveInstance(NodeRef from, NodeRef to) {
 		return;
 
 	NodeDestroyInstance(to); // drop current target instance scene view if any
-	node_instance.erase(to); // drop current target instance component if any
+	SetNodeInstance(to, InvalidComponentRef); // drop current target instance component if any
 
 	const bool tgt_disabled = nodes[to.idx].flags & NF_Disabled;
 
-	const std::map<NodeRef, SceneView>::iterator i = node_instance_view.find(from);
+	const gen_ref_map<SceneView>::iterator i = node_instance_view.find(from);
 
 	if (i != node_instance_view.end()) {
 		for (std::vector<NodeRef>::const_iterator n = i->second.nodes.begin(); n != i->second.nodes.end(); ++n) {
@@ -1571,15 +2081,18 @@ void Scene::NodeMoveInstance(NodeRef from, NodeRef to) {
 			// update disable flag
 			tgt_disabled ? DisableNode_(*n, true) : EnableNode_(*n, true);
 		}
-		node_instance_view[to] = i->second; // transfer instance view
+		const SceneView view = i->second;
+		node_instance_view.erase(i); // drop from source
+		node_instance_view[to] = view; // transfer instance view
 	}
 
-	node_instance_view.erase(i); // drop from source
-
-	if (node_instance.find(from) != node_instance.end())
-		node_instance[to] = node_instance[from];
+	const gen_ref_map<ComponentRef>::iterator j = node_instance.find(from);
 
-	node_instance.erase(from); // drop from source
+	if (j != node_instance.end()) {
+		const ComponentRef instance_ref = j->second;
+		node_instance.erase(j); // drop from source
+		node_instance[to] = instance_ref; // transfer instance component
+	}
 }
 
 //
@@ -1670,7 +2183,11 @@ Script Scene::CreateScript(const std::string &path) {
 	return script;
 }
 
-void Scene::DestroyScript(ComponentRef ref) { scripts.remove_ref(ref); }
+void Scene::DestroyScript(ComponentRef ref) {
+	if (scripts.refcount(ref))
+		gc_side_maps_dirty = true;
+	scripts.remove_ref(ref);
+}
 
 Script Scene::GetScript(ComponentRef ref) const {
 	Script script;
@@ -1743,7 +2260,7 @@ size_t Scene::GetNodeScriptCount(NodeRef ref) const {
 		return 0;
 	}
 
-	const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator i = node_scripts.find(ref);
+	const gen_ref_map<std::vector<ComponentRef> >::const_iterator i = node_scripts.find(ref);
 	return i != node_scripts.end() ? i->second.size() : 0;
 }
 
@@ -1760,14 +2277,16 @@ Script Scene::GetNodeScript(NodeRef ref, size_t idx) const {
 }
 
 ComponentRef Scene::GetNodeScriptRef(NodeRef ref, size_t idx) const {
-	std::map<NodeRef, std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_scripts.find(ref) : node_scripts.end();
+	gen_ref_map<std::vector<ComponentRef> >::const_iterator i = nodes.is_valid(ref) ? node_scripts.find(ref) : node_scripts.end();
 	return i != node_scripts.end() && idx < i->second.size() ? i->second[idx] : InvalidComponentRef;
 }
 
 void Scene::SetNodeScript(NodeRef ref, size_t idx, const Script &script) {
 	if (nodes.is_valid(ref)) {
-		node_scripts[ref].resize(idx + 1);
-		node_scripts[ref][idx] = script.ref;
+		std::vector<ComponentRef> &refs = node_scripts[ref];
+		if (idx >= refs.size())
+			refs.resize(idx + 1);
+		SetComponentRef_(scripts, refs[idx], script.ref);
 	} else {
 		warn("Invalid node");
 	}
@@ -1780,7 +2299,7 @@ void Scene::RemoveNodeScript(NodeRef ref, ComponentRef cref) {
 		for (size_t slot_idx = 0; slot_idx < scripts.size(); ++slot_idx)
 			if (scripts[slot_idx] == cref) {
 				scripts_detached_from_nodes[cref].insert(ref);
-				scripts[slot_idx] = invalid_gen_ref;
+				SetComponentRef_(this->scripts, scripts[slot_idx], invalid_gen_ref);
 			}
 
 		_ResizeComponents(scripts);
@@ -1796,7 +2315,7 @@ void Scene::RemoveNodeScript(NodeRef ref, size_t slot_idx) {
 		if (slot_idx < scripts.size())
 			if (scripts[slot_idx] != invalid_gen_ref) {
 				scripts_detached_from_nodes[scripts[slot_idx]].insert(ref);
-				scripts[slot_idx] = invalid_gen_ref;
+				SetComponentRef_(this->scripts, scripts[slot_idx], invalid_gen_ref);
 			}
 
 		_ResizeComponents(scripts);
@@ -1828,8 +2347,9 @@ std::vector<ComponentRef> Scene::GetScriptRefs() const {
 size_t Scene::GetScriptCount() const { return scene_scripts.size(); }
 
 void Scene::SetScript(size_t slot_idx, const Script &script) {
-	scene_scripts.resize(slot_idx + 1);
-	scene_scripts[slot_idx] = script.ref;
+	if (slot_idx >= scene_scripts.size())
+		scene_scripts.resize(slot_idx + 1);
+	SetComponentRef_(scripts, scene_scripts[slot_idx], script.ref);
 }
 
 Script Scene::GetScript(size_t slot_idx) const {
@@ -1964,11 +2484,123 @@ static bool IsBinaryScene(const Reader &ir, const Handle &h) {
 bool IsBinarySceneFile(const std::string &path) { return IsBinaryScene(g_file_reader, ScopedReadHandle(g_file_read_provider, path)); }
 bool IsBinarySceneAsset(const char *name) { return IsBinaryScene(g_assets_reader, ScopedReadHandle(g_assets_read_provider, name)); }
 
+static std::string scene_json_binary_cache_dir;
+
+void SetSceneJsonBinaryCacheDirectory(const std::string &path) { scene_json_binary_cache_dir = path; }
+const std::string &GetSceneJsonBinaryCacheDirectory() { return scene_json_binary_cache_dir; }
+
+// destroy what a failed load added to the scene, restore the load context
+static void RollbackSceneLoad(Scene &scene, LoadSceneContext &ctx, const LoadSceneContext &saved_ctx) {
+	for (size_t i = saved_ctx.view.nodes.size(); i < ctx.view.nodes.size(); ++i)
+		scene.DestroyNode(ctx.view.nodes[i]);
+	for (size_t i = saved_ctx.view.scene_anims.size(); i < ctx.view.scene_anims.size(); ++i)
+		scene.DestroySceneAnim(ctx.view.scene_anims[i]);
+	for (size_t i = saved_ctx.view.anims.size(); i < ctx.view.anims.size(); ++i)
+		scene.DestroyAnim(ctx.view.anims[i]);
+
+	scene.GarbageCollect();
+	ctx = saved_ctx;
+}
+
+static bool IsEmptyScene(const Scene &scene) {
+	return scene.GetAllNodeCount() == 0 && scene.GetAnims().empty() && scene.GetSceneAnims().empty() && scene.GetKeys().empty();
+}
+
+// write the cache to a temporary file first so that a concurrent or interrupted write never leaves a partial cache entry
+static void SaveSceneBinaryCache(const std::string &cache_path, const std::string &name, const Data &data) {
+	const std::string tmp_path = fmt::format("{}.{:x}.tmp", cache_path, time_now());
+
+	if (!SaveDataToFile(tmp_path, data) || !RenameFile(tmp_path, cache_path)) {
+		warn(fmt::format("Failed to write binary cache for scene '{}' to '{}'", name, cache_path));
+		Unlink(tmp_path);
+	}
+}
+
+static bool LoadSceneJsonFromBinaryCache(JsonLoadContext &json_ctx, const std::string &name, Scene &scene, const Reader &deps_ir,
+	const ReadProvider &deps_ip, PipelineResources &resources, const PipelineInfo &pipeline, LoadSceneContext &ctx, uint32_t flags) {
+	ProfilerPerfSection section("LoadSceneJsonFromBinaryCache", name);
+
+	const size_t size = json_ctx.buffer.size() - 1; // buffer is null-terminated
+	const unsigned long long hash = XXH64(&json_ctx.buffer[0], size, GetSceneBinaryFormatVersion());
+	const std::string cache_path = PathJoin(scene_json_binary_cache_dir, fmt::format("{:016x}.scn", hash));
+
+	Data data;
+
+	if (IsFile(cache_path) && LoadDataFromFile(cache_path, data)) {
+		data.Rewind();
+		if (IsBinaryScene(g_data_reader, DataReadHandle(data))) {
+			const LoadSceneContext saved_ctx = ctx;
+			if (LoadSceneBinaryFromData(data, name, scene, deps_ir, deps_ip, resources, pipeline, ctx, flags))
+				return true;
+			RollbackSceneLoad(scene, ctx, saved_ctx);
+		}
+		warn(fmt::format("Invalid binary cache for scene '{}', discarding it", name));
+		Unlink(cache_path);
+	}
+
+	// cache miss, load the JSON scene and write its binary version
+	if (!ParseJson(json_ctx))
+		return false;
+
+	data.Reset();
+
+	// a full load to an empty scene is saved as is, otherwise the cache is written from a temporary full load
+	if ((flags & LSSF_All) == LSSF_All && IsEmptyScene(scene)) {
+		if (!scene.Load_json(json_ctx.doc, name, deps_ir, deps_ip, resources, pipeline, ctx, flags))
+			return false;
+		if (SaveSceneBinaryToData(data, scene, resources, LSSF_All))
+			SaveSceneBinaryCache(cache_path, name, data);
+		return true;
+	}
+
+	{
+		Scene cache_scene;
+		LoadSceneContext cache_ctx;
+
+		if (cache_scene.Load_json(json_ctx.doc, name, deps_ir, deps_ip, resources, pipeline, cache_ctx, LSSF_All | (flags & LSSF_OptionsMask)) &&
+			SaveSceneBinaryToData(data, cache_scene, resources, LSSF_All))
+			SaveSceneBinaryCache(cache_path, name, data);
+	}
+
+	return scene.Load_json(json_ctx.doc, name, deps_ir, deps_ip, resources, pipeline, ctx, flags);
+}
+
+// JSON load contexts are created by the outermost scene load and reused by the instance loads it triggers, one per nesting level
+static std::vector<JsonLoadContext *> json_load_contexts;
+static size_t json_load_depth = 0;
+
+struct JsonLoadContextScope {
+	JsonLoadContextScope() {
+		if (json_load_depth == json_load_contexts.size())
+			json_load_contexts.push_back(new JsonLoadContext);
+		ctx = json_load_contexts[json_load_depth++];
+	}
+
+	~JsonLoadContextScope() {
+		if (--json_load_depth == 0) {
+			for (std::vector<JsonLoadContext *>::iterator i = json_load_contexts.begin(); i != json_load_contexts.end(); ++i)
+				delete *i;
+			json_load_contexts.clear();
+		}
+	}
+
+	JsonLoadContext *ctx;
+};
+
 static bool LoadSceneJson(const Reader &ir, const Handle &h, const std::string &name, Scene &scene, const Reader &deps_ir, const ReadProvider &deps_ip,
 	PipelineResources &resources, const PipelineInfo &pipeline, LoadSceneContext &ctx, uint32_t flags) {
-	rapidjson::Document jd;
-	LoadJson(ir, h, jd);
-	return scene.Load_json(jd, name, deps_ir, deps_ip, resources, pipeline, ctx, flags);
+	JsonLoadContextScope scope;
+	JsonLoadContext &json_ctx = *scope.ctx;
+	if (!ReadJson(ir, h, json_ctx))
+		return false;
+
+	// resource names must be resolved to be written to the binary cache
+	if (!scene_json_binary_cache_dir.empty() && !(flags & LSSF_DoNotLoadResources))
+		return LoadSceneJsonFromBinaryCache(json_ctx, name, scene, deps_ir, deps_ip, resources, pipeline, ctx, flags);
+
+	if (!ParseJson(json_ctx))
+		return false;
+	return scene.Load_json(json_ctx.doc, name, deps_ir, deps_ip, resources, pipeline, ctx, flags);
 }
 
 //
@@ -2064,22 +2696,33 @@ std::vector<Node> NodeRefsToNodes(const Scene &scene, const std::vector<NodeRef>
 //
 std::vector<NodeRef> DuplicateNodes(Scene &scene, const std::vector<NodeRef> &nodes, const Reader &deps_ir, const ReadProvider &deps_ip,
 	PipelineResources &resources, const PipelineInfo &pipeline) {
-	Data data;
+	ProfilerPerfSection section("DuplicateNodes");
 
-	if (!scene.SaveNodes_binary(g_data_writer, DataWriteHandle(data), nodes, resources)) {
-		warn("Failed to duplicate nodes, an error occurred while saving the node selection");
-		return std::vector<NodeRef>();
-	}
+	Scene::CloneRemap_ remap;
+	remap.clone_instance_views = false; // instances are setup anew, as they would be when loading the nodes
 
-	data.Rewind();
+	scene.CloneBegin_(scene, remap);
 
-	LoadSceneContext ctx;
-	if (!scene.LoadNodes_binary(g_data_reader, DataReadHandle(data), "DuplicateNodes", deps_ir, deps_ip, resources, pipeline, ctx)) {
-		warn("Failed to duplicate nodes, an error occurred while loading the node selection");
-		return std::vector<NodeRef>();
+	std::vector<NodeRef> refs;
+	refs.reserve(nodes.size());
+
+	for (std::vector<NodeRef>::const_iterator i = nodes.begin(); i != nodes.end(); ++i) {
+		const Scene::Node_ *node_ = scene.GetNode_(*i);
+		if (!node_ || (node_->flags & NF_Instantiated))
+			continue; // instantiated nodes are not serialized, do not duplicate them either
+		refs.push_back(scene.CloneNode_(scene, *i, NF_SerializedMask, remap));
 	}
 
-	return ctx.view.nodes;
+	scene.CloneEnd_(scene, remap);
+
+	// setup instances
+	for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+		if (scene.node_instance.find(*i) != scene.node_instance.end()) {
+			scene.NodeSetupInstance(*i, deps_ir, deps_ip, resources, pipeline, LSSF_AllNodeFeatures, 1);
+			scene.NodeStartOnInstantiateAnim(*i);
+		}
+
+	return refs;
 }
 
 static std::vector<NodeRef> GetNodeAndchildren(const Scene &scene, const std::vector<NodeRef> &refs) {
@@ -2181,7 +2824,10 @@ const AnimRef InvalidAnimRef;
 
 time_ns UnspecifiedAnimTime = std::numeric_limits<time_ns>::max();
 
-AnimRef Scene::AddAnim(Anim anim) { return anims.add_ref(anim); }
+AnimRef Scene::AddAnim(Anim anim) {
+	gc_anims_dirty = true; // not referenced by a scene animation yet
+	return anims.add_ref(anim);
+}
 
 std::vector<AnimRef> Scene::GetAnims() const {
 	std::vector<AnimRef> refs;
@@ -2405,7 +3051,7 @@ void Scene::EvaluateBoundAnim(const BoundToNodeAnim &bound_anim, time_ns t) {
 
 				Material &mat = obj->materials[mt->slot_idx];
 
-				std::map<std::string, Material::Value>::iterator i = mat.values.find(mt->value);
+				std::map<atom, Material::Value>::iterator i = mat.values.find(mt->value);
 				if (i == mat.values.end())
 					continue; // invalid material value name
 
@@ -2421,7 +3067,7 @@ void Scene::EvaluateBoundAnim(const BoundToNodeAnim &bound_anim, time_ns t) {
 		}
 
 		if (!anim.instance_anim_track.keys.empty()) {
-			std::map<NodeRef, SceneView>::iterator i = node_instance_view.find(bound_anim.node);
+			gen_ref_map<SceneView>::iterator i = node_instance_view.find(bound_anim.node);
 
 			if (i != node_instance_view.end()) {
 				int kf = numeric_cast<int>(anim.instance_anim_track.keys.size()) - 1;
@@ -2479,11 +3125,19 @@ void Scene::EvaluateBoundAnim(const BoundToNodeAnim &bound_anim, time_ns t) {
 //
 const SceneAnimRef InvalidSceneAnimRef;
 
-SceneAnimRef Scene::AddSceneAnim(SceneAnim anim) { return scene_anims.add_ref(anim); }
-void Scene::DestroySceneAnim(SceneAnimRef ref) { scene_anims.remove_ref(ref); }
+SceneAnimRef Scene::AddSceneAnim(SceneAnim anim) {
+	gc_anims_dirty = true;
+	return scene_anims.add_ref(anim);
+}
+
+void Scene::DestroySceneAnim(SceneAnimRef ref) {
+	gc_anims_dirty = true;
+	scene_anims.remove_ref(ref);
+}
 
 size_t Scene::GarbageCollectAnims() {
-	std::vector<bool> is_refd(anims.capacity(), false);
+	FrameArenaScope arena_scope;
+	std::vector<bool, frame_allocator<bool> > is_refd(anims.capacity(), false);
 
 	for (vector_list<SceneAnim>::iterator i = scene_anims.begin(); i != scene_anims.end(); ++i) {
 		if (i->scene_anim != InvalidAnimRef)
@@ -2514,7 +3168,10 @@ std::vector<SceneAnimRef> Scene::GetSceneAnims() const {
 	return refs;
 }
 
-SceneAnim *Scene::GetSceneAnim(SceneAnimRef ref) { return scene_anims.is_valid(ref) ? &scene_anims[ref.idx] : nullptr; }
+SceneAnim *Scene::GetSceneAnim(SceneAnimRef ref) {
+	gc_anims_dirty = true; // animation references might be modified through the returned pointer
+	return scene_anims.is_valid(ref) ? &scene_anims[ref.idx] : nullptr;
+}
 const SceneAnim *Scene::GetSceneAnim(SceneAnimRef ref) const { return scene_anims.is_valid(ref) ? &scene_anims[ref.idx] : nullptr; }
 
 SceneAnimRef Scene::GetSceneAnim(const std::string &name) const {
@@ -2585,7 +3242,8 @@ bool Scene::IsPlaying(ScenePlayAnimRef ref) const { return play_anims.is_valid(r
 void Scene::StopAnim(ScenePlayAnimRef ref) { play_anims.remove_ref(ref); }
 
 void Scene::UpdatePlayingAnims(time_ns dt) {
-	std::vector<ScenePlayAnimRef> clean_list;
+	FrameArenaScope arena_scope;
+	frame_vector<ScenePlayAnimRef>::type clean_list;
 
 	for (ScenePlayAnimRef i = play_anims.first_ref(); i != InvalidScenePlayAnimRef; i = play_anims.next_ref(i)) {
 		ScenePlayAnim &play_anim = play_anims[i.idx];
@@ -2633,7 +3291,7 @@ void Scene::UpdatePlayingAnims(time_ns dt) {
 		EvaluateBoundAnim(play_anim.bound_anim, t);
 	}
 
-	for (std::vector<ScenePlayAnimRef>::const_iterator i = clean_list.begin(); i != clean_list.end(); ++i)
+	for (frame_vector<ScenePlayAnimRef>::type::const_iterator i = clean_list.begin(); i != clean_list.end(); ++i)
 		play_anims.remove(i->idx); // no point in going through the gen_ref check
 }
 
@@ -2783,7 +3441,7 @@ Vec4 GetAnimableNodePropertyVec4(const Scene &scene, NodeRef ref, const std::str
 				if (slot_idx < obj.GetMaterialCount()) {
 					const Material &mat = obj.GetMaterial(slot_idx);
 
-					std::map<std::string, Material::Value>::const_iterator i = mat.values.find(value);
+					std::map<atom, Material::Value>::const_iterator i = mat.values.find(value);
 					if (i != mat.values.end())
 						return Vec4(i->second.value[0], i->second.value[1], i->second.value[2], i->second.value[3]);
 				}
@@ -2802,7 +3460,7 @@ void SetAnimableNodePropertyVec4(Scene &scene, NodeRef ref, const std::string &n
 				if (slot_idx < obj.GetMaterialCount()) {
 					Material &mat = obj.GetMaterial(slot_idx);
 
-					std::map<std::string, Material::Value>::iterator i = mat.values.find(value);
+					std::map<atom, Material::Value>::iterator i = mat.values.find(value);
 					if (i != mat.values.end()) {
 						i->second.value.resize(4);
 						i->second.value[0] = v.x;
@@ -2869,6 +3527,74 @@ std::vector<hg::Material *> Scene::GetMaterialsWithName(const std::string &name)
 	return mats;
 }
 
+//
+template <typename T> static bool IsResourceRefLess(const ResourceRef<T> &a, const ResourceRef<T> &b) {
+	return a.ref.idx != b.ref.idx ? a.ref.idx < b.ref.idx : a.ref.gen < b.ref.gen;
+}
+
+template <typename T> static void UpdateResourceRefs_(std::vector<ResourceRef<T> > &held, std::vector<ResourceRef<T> > &used, ResourceCache<T> &cache) {
+	std::sort(used.begin(), used.end(), &IsResourceRefLess<T>);
+	used.erase(std::unique(used.begin(), used.end()), used.end());
+
+	for (typename std::vector<ResourceRef<T> >::const_iterator i = used.begin(); i != used.end(); ++i)
+		cache.Touch(*i); // most recently used resources are evicted last
+
+	std::vector<ResourceRef<T> > diff;
+
+	std::set_difference(used.begin(), used.end(), held.begin(), held.end(), std::back_inserter(diff), &IsResourceRefLess<T>);
+	for (typename std::vector<ResourceRef<T> >::const_iterator i = diff.begin(); i != diff.end(); ++i)
+		cache.AddRef(*i);
+
+	diff.clear();
+
+	std::set_difference(held.begin(), held.end(), used.begin(), used.end(), std::back_inserter(diff), &IsResourceRefLess<T>);
+	for (typename std::vector<ResourceRef<T> >::const_iterator i = diff.begin(); i != diff.end(); ++i)
+		cache.Release(*i);
+
+	held.swap(used);
+}
+
+static void AddUsedTextureRef(std::vector<TextureRef> &refs, const PipelineResources &resources, TextureRef ref) {
+	if (resources.textures.IsValidRef(ref))
+		refs.push_back(ref);
+}
+
+void Scene::UpdateResourceRefs(PipelineResources &resources) {
+	std::vector<ModelRef> used_models;
+	std::vector<TextureRef> used_textures;
+
+	for (gen_ref ref = objects.first_ref(); objects.is_valid(ref); ref = objects.next_ref(ref)) {
+		const Object_ &obj = objects[ref.idx];
+
+		if (resources.models.IsValidRef(obj.model))
+			used_models.push_back(obj.model);
+
+		for (std::vector<Material>::const_iterator i = obj.materials.begin(); i != obj.materials.end(); ++i)
+			for (std::map<atom, Material::Texture>::const_iterator j = i->textures.begin(); j != i->textures.end(); ++j)
+				AddUsedTextureRef(used_textures, resources, j->second.texture);
+	}
+
+	AddUsedTextureRef(used_textures, resources, environment.probe.irradiance_map);
+	AddUsedTextureRef(used_textures, resources, environment.probe.radiance_map);
+	AddUsedTextureRef(used_textures, resources, environment.brdf_map);
+
+	if (resource_refs_owner && resource_refs_owner != &resources)
+		ReleaseResourceRefs(*resource_refs_owner);
+
+	UpdateResourceRefs_(model_refs, used_models, resources.models);
+	UpdateResourceRefs_(texture_refs, used_textures, resources.textures);
+	resource_refs_owner = &resources;
+}
+
+void Scene::ReleaseResourceRefs(PipelineResources &resources) {
+	std::vector<ModelRef> no_models;
+	std::vector<TextureRef> no_textures;
+
+	UpdateResourceRefs_(model_refs, no_models, resources.models);
+	UpdateResourceRefs_(texture_refs, no_textures, resources.textures);
+	resource_refs_owner = nullptr;
+}
+
 //
 std::string GetAnimableNodePropertyString(const Scene &scene, NodeRef ref, const std::string &name) {
 	if (const Node node = scene.GetNode(ref)) {
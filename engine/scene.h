@@ -7,8 +7,10 @@
 #include "engine/node.h"
 #include "engine/render_pipeline.h"
 
+#include "foundation/atom.h"
 #include "foundation/easing.h"
 #include "foundation/frustum.h"
+#include "foundation/gen_ref_map.h"
 #include "foundation/generational_vector_list.h"
 #include "foundation/matrix4.h"
 #include "foundation/matrix44.h"
@@ -60,7 +62,7 @@ enum NodeStringAnimTarget { NSAT_Count };
 struct BoundToNodeMaterialAnim {
 	int8_t track_idx; // anim track idx
 	uint8_t slot_idx; // material slot idx
-	std::string value; // material value name
+	atom value; // material value name
 };
 
 struct SceneBoundAnim;
@@ -168,6 +170,13 @@ struct LoadSceneContext {
 
 enum NodeComponentIdx { NCI_Transform, NCI_Camera, NCI_Object, NCI_Light, NCI_RigidBody, NCI_Count };
 
+// node component masks
+static const uint32_t NCM_Transform = 1 << NCI_Transform;
+static const uint32_t NCM_Camera = 1 << NCI_Camera;
+static const uint32_t NCM_Object = 1 << NCI_Object;
+static const uint32_t NCM_Light = 1 << NCI_Light;
+static const uint32_t NCM_RigidBody = 1 << NCI_RigidBody;
+
 // serialized node flags
 static const uint32_t NF_SerializedMask = 0x0000ffff;
 static const uint32_t NF_Disabled = 0x00000001; // node is disabled
@@ -190,14 +199,39 @@ public:
 		Call this method after removing nodes from the scene. Components with
 		no reference will be removed from the scene. Try to batch node removal
 		and perform a single call to this function to improve performance.
+
+		Components are reference counted by the nodes and the scene using them,
+		only components which might have become orphaned since the last
+		collection are visited.
 	**/
 	size_t GarbageCollect();
+	/**
+		@short Clear orphaned scene content within a time budget.
+
+		Perform as much of the pending collection work as possible in the
+		allotted time, the remaining work is resumed by the next call. This
+		can be called every frame to spread the collection cost over time.
+	**/
+	size_t GarbageCollect(time_ns t_budget);
+	/// Return `true` if some collection work is pending.
+	bool IsGarbageCollectPending() const;
 
 	// node
 	Node CreateNode(std::string name = std::string());
 	void DestroyNode(NodeRef ref);
 	void DestroyNode(const Node &node) { DestroyNode(node.ref); }
 
+	/**
+		@short Create several nodes at once.
+
+		Storage for the new nodes and their components is reserved upfront. A new
+		component of each type set in `components` (see `NCM_Transform`, `NCM_Camera`...)
+		is created and assigned to each node.
+	**/
+	std::vector<NodeRef> CreateNodes(size_t count, uint32_t components = 0, const std::string &name = std::string());
+	/// Destroy several nodes at once.
+	void DestroyNodes(const std::vector<NodeRef> &refs);
+
 	Node GetNode(const std::string &name) const;
 	Node GetNode(NodeRef ref) const;
 	Node GetNodeEx(const std::string &path) const;
@@ -570,7 +604,7 @@ public:
 	Script GetScript(size_t slot_idx) const;
 
 	const std::vector<ComponentRef> &GetSceneScripts() const { return scene_scripts; }
-	const std::map<NodeRef, std::vector<ComponentRef> > &GetNodeScripts() const { return node_scripts; }
+	const gen_ref_map<std::vector<ComponentRef> > &GetNodeScripts() const { return node_scripts; }
 
 	const std::map<ComponentRef, std::set<NodeRef> > &GetScriptsDetachedFromNodes() const { return scripts_detached_from_nodes; }
 	const std::set<ComponentRef> &GetScriptsDetachedFromScene() const { return scripts_detached_from_scene; }
@@ -685,6 +719,21 @@ public:
 	std::string GetValue(const std::string &key) const;
 	void SetValue(const std::string &key, const std::string &value);
 
+	/**
+		@short Update the references this scene holds on the resources it uses.
+
+		The models and material textures of the scene objects and the environment textures are referenced
+		(see ResourceCache::AddRef) and marked as used (see ResourceCache::Touch), resources the scene no longer uses
+		are released. Call this method after loading or modifying the scene and after clearing it to release
+		everything it used, then call DestroyReleasedResources to free the resources no scene uses anymore.
+
+		The references are released when the scene is cleared or destroyed, the resources must outlive the scene or
+		ReleaseResourceRefs must be called before they are destroyed.
+	**/
+	void UpdateResourceRefs(PipelineResources &resources);
+	/// Release all references this scene holds on resources.
+	void ReleaseResourceRefs(PipelineResources &resources);
+
 	// serialization (member as we directly access low-level structures for better performances)
 	bool Save_binary(const Writer &iw, const Handle &h, const PipelineResources &resources, uint32_t flags = LSSF_All,
 		const std::vector<NodeRef> *nodes_to_save = nullptr) const;
@@ -704,17 +753,88 @@ public:
 private:
 	std::map<std::string, std::string> key_values;
 
+	std::vector<ModelRef> model_refs; // resources referenced by UpdateResourceRefs
+	std::vector<TextureRef> texture_refs;
+	PipelineResources *resource_refs_owner; // resources the references are held on
+
 	friend void DumpSceneMemoryFootprint();
 
 	intrusive_shared_ptr_st<SceneRef> scene_ref;
 
-	size_t GarbageCollectPass();
+	bool GarbageCollectStep_(size_t &removed_count);
+	void DestroyNodeSideMaps_(NodeRef ref);
+	void GarbageCollectNode_(NodeRef ref);
+	void GarbageCollectSideMaps_();
+
+	std::vector<NodeRef> gc_nodes; // nodes which instance changed since the last collection
+	std::vector<SceneView> gc_views; // instance views of destroyed nodes
+	bool gc_side_maps_dirty; // a component referenced by a node was destroyed, side maps must be fully cleaned up
+	bool gc_anims_dirty;
+
+	// component storage reference counted by the nodes and the scene
+	template <typename T> class ComponentList_ : public generational_vector_list<T> {
+	public:
+		gen_ref add_ref(const T &v) { return track_(generational_vector_list<T>::add_ref(v)); }
+#if __cplusplus >= 201103L
+		gen_ref add_ref(T &&v) { return track_(generational_vector_list<T>::add_ref(std::move(v))); }
+#endif
+
+		void reserve(size_t count) {
+			generational_vector_list<T>::reserve(count);
+			if (count > refcounts.size())
+				refcounts.resize(count, 0);
+		}
+
+		void remove_ref(gen_ref ref) {
+			if (this->is_valid(ref))
+				refcounts[ref.idx] = 0;
+			generational_vector_list<T>::remove_ref(ref);
+		}
+
+		void clear() {
+			generational_vector_list<T>::clear();
+			refcounts.clear();
+			unreferenced.clear();
+		}
+
+		void ref(gen_ref ref) {
+			if (this->is_valid(ref))
+				++refcounts[ref.idx];
+		}
+
+		void unref(gen_ref ref) {
+			if (this->is_valid(ref) && refcounts[ref.idx] > 0)
+				if (--refcounts[ref.idx] == 0)
+					unreferenced.push_back(ref);
+		}
+
+		uint32_t refcount(gen_ref ref) const { return this->is_valid(ref) ? refcounts[ref.idx] : 0; }
+
+		std::vector<gen_ref> unreferenced; // collection candidates, might have been referenced again since
+
+	private:
+		std::vector<uint32_t> refcounts;
+
+		gen_ref track_(gen_ref ref) {
+			if (ref.idx >= refcounts.size())
+				refcounts.resize(size_t(ref.idx) + 64, 0);
+			refcounts[ref.idx] = 0;
+			unreferenced.push_back(ref); // a new component is not referenced until assigned
+			return ref;
+		}
+	};
+
+	template <typename T> static void SetComponentRef_(ComponentList_<T> &l, ComponentRef &slot, ComponentRef ref) {
+		l.ref(ref); // reference first, ref might be the current slot value
+		l.unref(slot);
+		slot = ref;
+	}
 
 	// nodes
 	struct Node_ { // 52B
 		Node_() : flags(0) {}
 
-		std::string name; // 8B
+		atom name; // 8B
 		ComponentRef components[NCI_Count]; // 40B
 		uint32_t flags; // 4B
 	};
@@ -735,11 +855,6 @@ private:
 		return node_ ? node_->components[I] : invalid_gen_ref;
 	}
 
-	template <int I> inline void SetNodeComponentRef_(NodeRef nref, ComponentRef cref) {
-		if (Node_ *node_ = this->GetNode_(nref))
-			node_->components[I] = cref;
-	}
-
 	template <typename T> inline T *GetComponent_(generational_vector_list<T> &l, ComponentRef ref) { return l.is_valid(ref) ? &l.value(ref.idx) : nullptr; }
 
 	template <typename T> inline const T *GetComponent_(const generational_vector_list<T> &l, ComponentRef ref) const {
@@ -809,11 +924,11 @@ private:
 		uint8_t rolling_friction;
 	};
 
-	generational_vector_list<Transform_> transforms;
-	generational_vector_list<Camera_> cameras;
-	generational_vector_list<Object_> objects;
-	generational_vector_list<Light_> lights;
-	generational_vector_list<RigidBody_> rigid_bodies;
+	ComponentList_<Transform_> transforms;
+	ComponentList_<Camera_> cameras;
+	ComponentList_<Object_> objects;
+	ComponentList_<Light_> lights;
+	ComponentList_<RigidBody_> rigid_bodies;
 
 	//
 	struct Collision_ {
@@ -825,8 +940,8 @@ private:
 		TransformTRS trs;
 	};
 
-	generational_vector_list<Collision_> collisions;
-	std::map<NodeRef, std::vector<ComponentRef> > node_collisions;
+	ComponentList_<Collision_> collisions;
+	gen_ref_map<std::vector<ComponentRef> > node_collisions;
 
 	//
 	struct Script_ {
@@ -834,10 +949,10 @@ private:
 		std::map<std::string, ScriptParam> params;
 	};
 
-	generational_vector_list<Script_> scripts;
+	ComponentList_<Script_> scripts;
 
 	std::vector<ComponentRef> scene_scripts;
-	std::map<NodeRef, std::vector<ComponentRef> > node_scripts;
+	gen_ref_map<std::vector<ComponentRef> > node_scripts;
 
 	std::set<ComponentRef> scripts_detached_from_scene; // will be used to call OnDetachFromScene
 	std::map<ComponentRef, std::set<NodeRef> > scripts_detached_from_nodes; // will be used to call OnDetachFromNode
@@ -852,10 +967,52 @@ private:
 		ScenePlayAnimRef play_anim_ref;
 	};
 
-	generational_vector_list<Instance_> instances; // create/destroy
+	ComponentList_<Instance_> instances; // create/destroy
+
+	gen_ref_map<ComponentRef> node_instance; // node to instance component
+	gen_ref_map<SceneView> node_instance_view; // node to instance scene view
+
+	bool LoadInstance_(const Reader &ir, const ReadProvider &ip, const std::string &name, PipelineResources &resources, const PipelineInfo &pipeline,
+		LoadSceneContext &ctx, uint32_t flags);
+
+	// instance sources are read and hashed once for the lifetime of the outermost scope
+	struct InstanceLoadScope_ {
+		InstanceLoadScope_();
+		~InstanceLoadScope_();
+	};
+
+	// node cloning, references are remapped through flat tables indexed by source slot
+	struct CloneRemap_ {
+		CloneRemap_() : clone_instance_views(true) {}
+
+		bool clone_instance_views; // when false, instance components are cloned but their content must be setup again
+
+		std::vector<NodeRef> nodes;
+		std::vector<ComponentRef> transforms, cameras, objects, lights, rigid_bodies, collisions, scripts, instances;
+		std::vector<AnimRef> anims;
+		std::vector<SceneAnimRef> scene_anims;
+
+		std::vector<NodeRef> instance_hosts; // cloned nodes with an instance view
+	};
+
+	template <typename T>
+	ComponentRef CloneComponent_(ComponentList_<T> &dst, const ComponentList_<T> &src, ComponentRef ref, std::vector<ComponentRef> &remap) {
+		if (!src.is_valid(ref))
+			return InvalidComponentRef;
+		if (remap[ref.idx] == InvalidComponentRef) {
+			const T v = src[ref.idx]; // src might be dst, copy before the list storage grows
+			remap[ref.idx] = dst.add_ref(v);
+		}
+		return remap[ref.idx];
+	}
 
-	std::map<NodeRef, ComponentRef> node_instance; // node to instance component
-	std::map<NodeRef, SceneView> node_instance_view; // node to instance scene view
+	void CloneBegin_(const Scene &src, CloneRemap_ &remap) const;
+	NodeRef CloneNode_(const Scene &src, NodeRef ref, uint32_t flags_mask, CloneRemap_ &remap);
+	void CloneView_(const Scene &src, const SceneView &src_view, CloneRemap_ &remap, SceneView &view);
+	void CloneEnd_(const Scene &src, const CloneRemap_ &remap);
+
+	friend std::vector<NodeRef> DuplicateNodes(Scene &scene, const std::vector<NodeRef> &nodes, const Reader &deps_ir, const ReadProvider &deps_ip,
+		PipelineResources &resources, const PipelineInfo &pipeline);
 
 	//
 	friend void LoadComponent(Transform_ *data_, const Reader &ir, const Handle &h);
@@ -992,6 +1149,16 @@ bool SaveSceneBinaryToData(Data &data, const Scene &scene, const PipelineResourc
 bool IsBinarySceneFile(const std::string &path);
 bool IsBinarySceneAsset(const std::string &name);
 
+/**
+	@short Binary cache for JSON scenes.
+
+	When a cache directory is set, JSON scenes loaded from file or assets are looked up in this directory by a hash of their content and of the scene
+	binary format version. The binary version is loaded when found, otherwise the JSON scene is parsed and its binary version written to the cache.
+	An empty path disables the cache (default).
+**/
+void SetSceneJsonBinaryCacheDirectory(const std::string &path);
+const std::string &GetSceneJsonBinaryCacheDirectory();
+
 bool LoadSceneJsonFromFile(
 	const std::string &path, Scene &scene, PipelineResources &resources, const PipelineInfo &pipeline, LoadSceneContext &ctx, uint32_t flags = LSSF_All);
 bool LoadSceneJsonFromAssets(
@@ -1011,6 +1178,18 @@ bool LoadSceneFromFile(
 bool LoadSceneFromAssets(
 	const std::string &name, Scene &scene, PipelineResources &resources, const PipelineInfo &pipeline, LoadSceneContext &ctx, uint32_t flags = LSSF_All);
 
+/**
+	@short Instance prototype cache.
+
+	Instance sources are loaded once per source, load flags and pipeline resources then cloned for each instance.
+	A cached prototype is checked against a hash of its source content and against the resources it references before each use.
+	Sources are read and hashed once per scene load, instances of the same source only pay for the check once.
+**/
+void EnableInstancePrototypeCache(bool enable);
+bool IsInstancePrototypeCacheEnabled();
+void ClearInstancePrototypeCache();
+size_t GetInstancePrototypeCacheSize();
+
 //
 std::vector<NodeRef> DuplicateNodes(Scene &scene, const std::vector<NodeRef> &nodes, const Reader &deps_ir, const ReadProvider &deps_ip,
 	PipelineResources &resources, const PipelineInfo &pipeline);
@@ -218,9 +218,7 @@ static void LoadProbe(Probe &probe, const Reader &ir, const Handle &h, const Rea
 	if (!tex_name.empty())
 		probe.radiance_map = SkipLoadOrQueueTextureLoad(deps_ir, deps_ip, tex_name, resources, queue_texture_loads, do_not_load_resources, silent);
 
-	uint8_t type;
-	Read(ir, h, type);
-	probe.type = ProbeType(type);
+	Read(ir, h, probe.type);
 	Read(ir, h, probe.parallax);
 	Read(ir, h, probe.trs);
 }
@@ -228,7 +226,7 @@ static void LoadProbe(Probe &probe, const Reader &ir, const Handle &h, const Rea
 static void SkipProbe(const Reader &ir, const Handle &h) {
 	SkipString(ir, h);
 	SkipString(ir, h);
-	ir.seek(h, sizeof(uint8_t) * 2 + sizeof(TransformTRS), SM_Current);
+	ir.seek(h, sizeof(ProbeType) + sizeof(uint8_t) + sizeof(TransformTRS), SM_Current);
 }
 
 //
@@ -306,7 +304,7 @@ bool Scene::Save_binary(
 						used_component_refs[NCI_RigidBody].insert(node_->components[NCI_RigidBody]);
 
 					{
-						const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator j = node_collisions.find(*i);
+						const gen_ref_map<std::vector<ComponentRef> >::const_iterator j = node_collisions.find(*i);
 						if (j != node_collisions.end())
 							for (std::vector<ComponentRef>::const_iterator k = j->second.begin(); k != j->second.end(); ++k)
 								used_collision_refs.insert(*k);
@@ -314,14 +312,14 @@ bool Scene::Save_binary(
 				}
 
 				if (save_flags & LSSF_Scripts) {
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator j = node_scripts.find(*i);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator j = node_scripts.find(*i);
 					if (j != node_scripts.end())
 						for (std::vector<ComponentRef>::const_iterator k = j->second.begin(); k != j->second.end(); ++k)
 							used_script_refs.insert(*k);
 				}
 
 				{
-					const std::map<NodeRef, ComponentRef>::const_iterator j = node_instance.find(*i);
+					const gen_ref_map<ComponentRef>::const_iterator j = node_instance.find(*i);
 					if (j != node_instance.end())
 						used_instance_refs.insert(j->second);
 				}
@@ -424,7 +422,7 @@ bool Scene::Save_binary(
 						Write<uint32_t>(iw, h, 0xffffffff);
 					}
 
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator c = node_collisions.find(ref);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator c = node_collisions.find(ref);
 					if (c != node_collisions.end()) {
 						Write(iw, h, numeric_cast<uint32_t>(c->second.size())); // collision count
 						for (std::vector<ComponentRef>::const_iterator j = c->second.begin(); j != c->second.end(); ++j) {
@@ -437,7 +435,7 @@ bool Scene::Save_binary(
 				}
 
 				if (save_flags & LSSF_Scripts) {
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator c = node_scripts.find(ref);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator c = node_scripts.find(ref);
 					if (c != node_scripts.end()) {
 						Write(iw, h, numeric_cast<uint32_t>(c->second.size())); // script count
 						for (std::vector<ComponentRef>::const_iterator j = c->second.begin(); j != c->second.end(); ++j) {
@@ -450,7 +448,7 @@ bool Scene::Save_binary(
 				}
 
 				{
-					const std::map<NodeRef, ComponentRef>::const_iterator &c = node_instance.find(ref);
+					const gen_ref_map<ComponentRef>::const_iterator &c = node_instance.find(ref);
 					if (c != node_instance.end()) {
 						const std::set<ComponentRef>::iterator &i = used_instance_refs.find(c->second);
 						Write(iw, h, numeric_cast<uint32_t>(std::distance(used_instance_refs.begin(), i)));
@@ -676,29 +674,30 @@ bool Scene::Load_binary(const Reader &ir, const Handle &h, const std::string &na
 
 			const uint32_t transform_idx = Read<uint32_t>(ir, h);
 			if (transform_idx != 0xffffffff)
-				node_.components[NCI_Transform] = transform_refs[transform_idx];
+				SetComponentRef_(transforms, node_.components[NCI_Transform], transform_refs[transform_idx]);
 
 			const uint32_t camera_idx = Read<uint32_t>(ir, h);
 			if (camera_idx != 0xffffffff)
-				node_.components[NCI_Camera] = camera_refs[camera_idx];
+				SetComponentRef_(cameras, node_.components[NCI_Camera], camera_refs[camera_idx]);
 
 			const uint32_t object_idx = Read<uint32_t>(ir, h);
 			if (object_idx != 0xffffffff)
-				node_.components[NCI_Object] = object_refs[object_idx];
+				SetComponentRef_(objects, node_.components[NCI_Object], object_refs[object_idx]);
 
 			const uint32_t light_idx = Read<uint32_t>(ir, h);
 			if (light_idx != 0xffffffff)
-				node_.components[NCI_Light] = light_refs[light_idx];
+				SetComponentRef_(lights, node_.components[NCI_Light], light_refs[light_idx]);
 
 			if (file_flags & LSSF_Physics) {
 				const uint32_t rigid_body_idx = Read<uint32_t>(ir, h);
 				if (rigid_body_idx != 0xffffffff)
-					node_.components[NCI_RigidBody] = rigid_body_refs[rigid_body_idx];
+					SetComponentRef_(rigid_bodies, node_.components[NCI_RigidBody], rigid_body_refs[rigid_body_idx]);
 
 				const uint32_t collision_count = Read<uint32_t>(ir, h);
 				for (uint32_t j = 0; j < collision_count; ++j) {
 					const uint32_t col_idx = Read<uint32_t>(ir, h);
 					node_collisions[node_ref].push_back(collision_refs[col_idx]);
+					collisions.ref(collision_refs[col_idx]);
 				}
 			}
 
@@ -707,12 +706,13 @@ bool Scene::Load_binary(const Reader &ir, const Handle &h, const std::string &na
 				for (uint32_t j = 0; j < node_script_count; ++j) {
 					const uint32_t script_idx = Read<uint32_t>(ir, h);
 					node_scripts[node_ref].push_back(script_refs[script_idx]);
+					scripts.ref(script_refs[script_idx]);
 				}
 			}
 
 			const uint32_t instance_idx = Read<uint32_t>(ir, h);
 			if (instance_idx != 0xffffffff) {
-				node_instance[node_ref] = instance_refs[instance_idx];
+				SetNodeInstance(node_ref, instance_refs[instance_idx]);
 				node_with_instance_to_setup.push_back(node_ref);
 			}
 		}
@@ -720,6 +720,7 @@ bool Scene::Load_binary(const Reader &ir, const Handle &h, const std::string &na
 		// setup instances
 		if (!(load_flags & LSSF_DoNotLoadResources)) {
 			ProfilerPerfSection section("Scene::Load_binary: Setup Instances");
+			InstanceLoadScope_ scope;
 
 			for (std::vector<NodeRef>::const_iterator i = node_with_instance_to_setup.begin(); i != node_with_instance_to_setup.end(); ++i) {
 				NodeSetupInstance(*i, deps_ir, deps_ip, resources, pipeline, LSSF_AllNodeFeatures | (load_flags & LSSF_OptionsMask), ctx.recursion_level + 1);
@@ -78,8 +78,8 @@ void SaveComponent(const Scene::Object_ *data_, rapidjson::Document &jd, rapidjs
 
 void SaveComponent(const Scene::Light_ *data_, rapidjson::Document &jd, rapidjson::Value &js) {
 	js.SetObject();
-	set_json_key(jd, js, "type", data_->type);
-	set_json_key(jd, js, "shadow_type", data_->shadow_type);
+	set_json_key(jd, js, "type", LightType_to_string(data_->type));
+	set_json_key(jd, js, "shadow_type", LightShadowType_to_string(data_->shadow_type));
 	set_json_key(jd, js, "diffuse", data_->diffuse);
 	set_json_key(jd, js, "diffuse_intensity", data_->diffuse_intensity);
 	set_json_key(jd, js, "specular", data_->specular);
@@ -94,7 +94,11 @@ void SaveComponent(const Scene::Light_ *data_, rapidjson::Document &jd, rapidjso
 
 void SaveComponent(const Scene::RigidBody_ *data_, rapidjson::Document &jd, rapidjson::Value &js) {
 	js.SetObject();
-	set_json_key(jd, js, "type", data_->type);
+	{
+		rapidjson::Value js_type;
+		RigidBodyType_to_json(jd, js_type, data_->type);
+		set_json_key(jd, js, "type", js_type);
+	}
 	set_json_key(jd, js, "linear_damping", unpack_float(data_->linear_damping));
 	set_json_key(jd, js, "angular_damping", unpack_float(data_->angular_damping));
 	set_json_key(jd, js, "restitution", unpack_float(data_->restitution));
@@ -104,7 +108,11 @@ void SaveComponent(const Scene::RigidBody_ *data_, rapidjson::Document &jd, rapi
 
 void SaveComponent(const Scene::Collision_ *data_, rapidjson::Document &jd, rapidjson::Value &js) {
 	js.SetObject();
-	set_json_key(jd, js, "type", data_->type);
+	{
+		rapidjson::Value js_type;
+		CollisionType_to_json(jd, js_type, data_->type);
+		set_json_key(jd, js, "type", js_type);
+	}
 	set_json_key(jd, js, "mass", data_->mass);
 	set_json_key(jd, js, "path", data_->resource_path);
 	set_json_key(jd, js, "pos", data_->trs.pos);
@@ -149,7 +157,7 @@ void SaveComponent(const Scene::Instance_ *data_, rapidjson::Document &jd, rapid
 
 	if (!data_->anim.empty()) {
 		set_json_key(jd, js, "anim", data_->anim);
-		set_json_key(jd, js, "loop_mode", data_->loop_mode);
+		set_json_key(jd, js, "loop_mode", AnimLoopMode_to_string(data_->loop_mode));
 	}
 }
 
@@ -158,8 +166,12 @@ static void SaveProbe(const Probe &probe, rapidjson::Document &jd, rapidjson::Va
 	set_json_key(jd, js, "irradiance_map", resources.textures.GetName(probe.irradiance_map));
 	set_json_key(jd, js, "radiance_map", resources.textures.GetName(probe.radiance_map));
 
-	set_json_key(jd, js, "type", probe.type);
-	set_json_key(jd, js, "parallax", probe.parallax);
+	{
+		rapidjson::Value js_type;
+		ProbeType_to_json(jd, js_type, probe.type);
+		set_json_key(jd, js, "type", js_type);
+	}
+	set_json_key(jd, js, "parallax", unpack_float(probe.parallax));
 
 	set_json_key(jd, js, "pos", probe.trs.pos);
 	set_json_key(jd, js, "rot", probe.trs.rot);
@@ -362,21 +374,21 @@ void Scene::Save_json(
 					used_component_refs[NCI_RigidBody].insert(node_->components[NCI_RigidBody]);
 
 				{
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator &i = node_collisions.find(*j);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator &i = node_collisions.find(*j);
 					if (i != node_collisions.end())
 						for (std::vector<ComponentRef>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
 							used_collision_refs.insert(*j);
 				}
 
 				{
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator &i = node_scripts.find(*j);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator &i = node_scripts.find(*j);
 					if (i != node_scripts.end())
 						for (std::vector<ComponentRef>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
 							used_script_refs.insert(*j);
 				}
 
 				{
-					const std::map<NodeRef, ComponentRef>::const_iterator &i = node_instance.find(*j);
+					const gen_ref_map<ComponentRef>::const_iterator &i = node_instance.find(*j);
 					if (i != node_instance.end())
 						used_instance_refs.insert(i->second);
 				}
@@ -527,7 +539,7 @@ void Scene::Save_json(
 				}
 
 				{
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator c = node_collisions.find(ref);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator c = node_collisions.find(ref);
 
 					if (c != node_collisions.end()) {
 						rapidjson::Value js_node_cols(rapidjson::kArrayType);
@@ -547,7 +559,7 @@ void Scene::Save_json(
 				}
 
 				{
-					const std::map<NodeRef, std::vector<ComponentRef> >::const_iterator c = node_scripts.find(ref);
+					const gen_ref_map<std::vector<ComponentRef> >::const_iterator c = node_scripts.find(ref);
 
 					if (c != node_scripts.end()) {
 						rapidjson::Value js_node_scripts(rapidjson::kArrayType);
@@ -567,7 +579,7 @@ void Scene::Save_json(
 				}
 
 				{
-					const std::map<NodeRef, ComponentRef>::const_iterator &c = node_instance.find(ref);
+					const gen_ref_map<ComponentRef>::const_iterator &c = node_instance.find(ref);
 					if (c != node_instance.end()) {
 						const std::set<ComponentRef>::iterator &i = used_instance_refs.find(c->second);
 						const uint32_t idx = numeric_cast<uint32_t>(std::distance(used_instance_refs.begin(), i));
@@ -578,6 +590,8 @@ void Scene::Save_json(
 				js_nodes.PushBack(js_node, jd.GetAllocator());
 			}
 		}
+
+		set_json_key(jd, js, "nodes", js_nodes);
 	}
 
 	if (save_flags & LSSF_Scene) {
@@ -804,7 +818,7 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 				ctx.node_refs[idx] = node.ref;
 				ctx.view.nodes.push_back(node.ref);
 
-				get_json_key<std::string>(js_node, "name", node_.name);
+				get_json_key(js_node, "name", node_.name);
 
 				if (get_json_key<bool>(js_node, "disabled"))
 					nodes_to_disable.push_back(node.ref);
@@ -814,23 +828,23 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 
 					const uint32_t transform_idx = js_node_components[NCI_Transform].GetUint();
 					if (transform_idx != 0xffffffff)
-						node_.components[NCI_Transform] = transform_refs[transform_idx];
+						SetComponentRef_(transforms, node_.components[NCI_Transform], transform_refs[transform_idx]);
 
 					const uint32_t camera_idx = js_node_components[NCI_Camera].GetUint();
 					if (camera_idx != 0xffffffff)
-						node_.components[NCI_Camera] = camera_refs[camera_idx];
+						SetComponentRef_(cameras, node_.components[NCI_Camera], camera_refs[camera_idx]);
 
 					const uint32_t object_idx = js_node_components[NCI_Object].GetUint();
 					if (object_idx != 0xffffffff)
-						node_.components[NCI_Object] = object_refs[object_idx];
+						SetComponentRef_(objects, node_.components[NCI_Object], object_refs[object_idx]);
 
 					const uint32_t light_idx = js_node_components[NCI_Light].GetUint();
 					if (light_idx != 0xffffffff)
-						node_.components[NCI_Light] = light_refs[light_idx];
+						SetComponentRef_(lights, node_.components[NCI_Light], light_refs[light_idx]);
 
 					const uint32_t rigid_body_idx = js_node_components[NCI_RigidBody].GetUint();
 					if (rigid_body_idx != 0xffffffff)
-						node_.components[NCI_RigidBody] = rigid_body_refs[rigid_body_idx];
+						SetComponentRef_(rigid_bodies, node_.components[NCI_RigidBody], rigid_body_refs[rigid_body_idx]);
 				}
 
 				{
@@ -846,6 +860,7 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 							if (col_idx != 0xffffffff) {
 								const ComponentRef col_ref = col_refs[col_idx];
 								node_collisions[node.ref].push_back(col_ref);
+								collisions.ref(col_ref);
 							} else {
 								node_collisions[node.ref].push_back(InvalidComponentRef);
 							}
@@ -864,8 +879,9 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 							const uint32_t script_idx = get_json_key<uint32_t>(js_scripts->value[i], "idx");
 
 							if (script_idx != 0xffffffff) {
-								const ComponentRef script_ref = col_refs[script_idx];
+								const ComponentRef script_ref = script_refs[script_idx];
 								node_scripts[node.ref].push_back(script_ref);
+								scripts.ref(script_ref);
 							} else {
 								node_scripts[node.ref].push_back(InvalidComponentRef);
 							}
@@ -879,7 +895,7 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 					if (js_node_instance != js_node.MemberEnd()) {
 						const uint32_t instance_idx = js_node_instance->value.GetUint();
 						if (instance_idx != 0xffffffff) {
-							node_instance[node.ref] = instance_refs[instance_idx];
+							SetNodeInstance(node.ref, instance_refs[instance_idx]);
 							node_with_instance_to_setup.push_back(node.ref);
 						}
 					}
@@ -887,12 +903,15 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 			}
 
 			// setup instances
-			if (!(load_flags & LSSF_DoNotLoadResources))
+			if (!(load_flags & LSSF_DoNotLoadResources)) {
+				InstanceLoadScope_ scope;
+
 				for (std::vector<NodeRef>::const_iterator i = node_with_instance_to_setup.begin(); i != node_with_instance_to_setup.end(); ++i) {
 					NodeSetupInstance(
 						*i, deps_ir, deps_ip, resources, pipeline, LSSF_AllNodeFeatures | (load_flags & LSSF_OptionsMask), ctx.recursion_level + 1);
 					NodeStartOnInstantiateAnim(*i);
 				}
+			}
 
 			// fix parent references
 			for (std::vector<ComponentRef>::const_iterator i = transform_refs.begin(); i != transform_refs.end(); ++i) {
@@ -970,8 +989,12 @@ bool Scene::Load_json(const rapidjson::Value &js, const std::string &name, const
 						const bool can_change_current_camera = current_camera == InvalidNodeRef || !(load_flags & LSSF_DoNotChangeCurrentCameraIfValid);
 
 						if (can_change_current_camera) {
-							const uint32_t current_camera_idx = j->value.GetUint();
-							current_camera = ctx.node_refs[current_camera_idx];
+							if (j->value.IsNull()) {
+								current_camera = InvalidNodeRef;
+							} else {
+								const uint32_t current_camera_idx = j->value.GetUint();
+								current_camera = ctx.node_refs[current_camera_idx];
+							}
 						}
 					} else if (name == "ambient") {
 						from_json(j->value, environment.ambient);
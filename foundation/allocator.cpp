@@ -0,0 +1,94 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "foundation/allocator.h"
+#include "foundation/assert.h"
+
+#include <cstdlib>
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace hg {
+
+static void *default_alloc(size_t size, MemoryTag, void *) { return malloc(size); }
+static void default_free(void *p, size_t, MemoryTag, void *) { free(p); }
+
+static Allocator current_allocator = {default_alloc, default_free, 0};
+
+void SetAllocator(const Allocator &allocator) { current_allocator = allocator; }
+const Allocator &GetAllocator() { return current_allocator; }
+
+//
+#if _WIN32
+typedef LONG_PTR atomic_size_t;
+static inline size_t atomic_add(volatile atomic_size_t &v, ptrdiff_t d) { return size_t(InterlockedExchangeAddSizeT(reinterpret_cast<volatile SIZE_T *>(&v), SIZE_T(d)) + d); }
+static inline bool atomic_cas(volatile atomic_size_t &v, size_t expected, size_t desired) {
+	return size_t(InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile *>(&v), reinterpret_cast<PVOID>(desired), reinterpret_cast<PVOID>(expected))) == expected;
+}
+#else
+typedef size_t atomic_size_t;
+static inline size_t atomic_add(volatile atomic_size_t &v, ptrdiff_t d) { return __sync_add_and_fetch(&v, size_t(d)); }
+static inline bool atomic_cas(volatile atomic_size_t &v, size_t expected, size_t desired) { return __sync_bool_compare_and_swap(&v, expected, desired); }
+#endif
+
+struct TagCounters {
+	volatile atomic_size_t live_size, peak_size, live_count, alloc_count;
+};
+
+static TagCounters tag_counters[MT_Count]; // zero-initialized
+
+//
+void *Allocate(size_t size, MemoryTag tag) {
+	__ASSERT__(tag < MT_Count);
+
+	void *p = current_allocator.alloc(size, tag, current_allocator.user);
+
+	if (p) {
+		TagCounters &c = tag_counters[tag];
+
+		const size_t live_size = atomic_add(c.live_size, ptrdiff_t(size));
+		for (size_t peak_size = c.peak_size; live_size > peak_size; peak_size = c.peak_size)
+			if (atomic_cas(c.peak_size, peak_size, live_size))
+				break;
+
+		atomic_add(c.live_count, 1);
+		atomic_add(c.alloc_count, 1);
+	}
+
+	return p;
+}
+
+void Deallocate(void *p, size_t size, MemoryTag tag) {
+	if (!p)
+		return;
+
+	__ASSERT__(tag < MT_Count);
+
+	current_allocator.free(p, size, tag, current_allocator.user);
+
+	TagCounters &c = tag_counters[tag];
+	atomic_add(c.live_size, -ptrdiff_t(size));
+	atomic_add(c.live_count, -1);
+}
+
+//
+MemoryStats GetMemoryStats(MemoryTag tag) {
+	__ASSERT__(tag < MT_Count);
+	const TagCounters &c = tag_counters[tag];
+
+	MemoryStats stats;
+	stats.live_size = size_t(c.live_size);
+	stats.peak_size = size_t(c.peak_size);
+	stats.live_count = size_t(c.live_count);
+	stats.alloc_count = size_t(c.alloc_count);
+	return stats;
+}
+
+const char *GetMemoryTagName(MemoryTag tag) {
+	static const char *names[MT_Count] = {"Default", "Containers", "Data", "Picture", "Scene", "Anim", "Resources", "FrameArena"};
+	return tag < MT_Count ? names[tag] : "Invalid";
+}
+
+} // namespace hg
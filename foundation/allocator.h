@@ -0,0 +1,96 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <new>
+
+namespace hg {
+
+/// Subsystem an allocation is accounted to.
+enum MemoryTag {
+	MT_Default,
+	MT_Containers,
+	MT_Data,
+	MT_Picture,
+	MT_Scene,
+	MT_Anim,
+	MT_Resources,
+	MT_FrameArena,
+	MT_Count
+};
+
+const char *GetMemoryTagName(MemoryTag tag);
+
+/*
+	Allocator
+
+	Allocations made through Allocate/Deallocate are routed to the current allocator and accounted per memory tag.
+	The allocator must return memory suitably aligned for any fundamental type, as malloc does. Deallocate is
+	always called with the size and tag the block was allocated with.
+
+	The default allocator uses malloc/free.
+*/
+struct Allocator {
+	void *(*alloc)(size_t size, MemoryTag tag, void *user);
+	void (*free)(void *p, size_t size, MemoryTag tag, void *user);
+	void *user;
+};
+
+/// Set the allocator, must be called before any allocation is made as memory must be released by the allocator that allocated it.
+void SetAllocator(const Allocator &allocator);
+const Allocator &GetAllocator();
+
+void *Allocate(size_t size, MemoryTag tag = MT_Default);
+void Deallocate(void *p, size_t size, MemoryTag tag = MT_Default);
+
+struct MemoryStats {
+	size_t live_size; // bytes currently allocated
+	size_t peak_size; // highest live_size
+	size_t live_count; // blocks currently allocated
+	size_t alloc_count; // total number of allocations
+};
+
+/// Return the memory statistics of a tag, counters are updated atomically and can be queried from any thread.
+MemoryStats GetMemoryStats(MemoryTag tag);
+
+/// Standard allocator going through Allocate/Deallocate, eg. std::vector<float, tagged_allocator<float, MT_Anim> >.
+template <typename T, MemoryTag tag> class tagged_allocator {
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U> struct rebind { typedef tagged_allocator<U, tag> other; };
+
+	tagged_allocator() {}
+	template <typename U> tagged_allocator(const tagged_allocator<U, tag> &) {}
+
+	pointer address(reference v) const { return &v; }
+	const_pointer address(const_reference v) const { return &v; }
+
+	pointer allocate(size_type n, const void * = 0) {
+		void *p = Allocate(n * sizeof(T), tag);
+		if (!p)
+			throw std::bad_alloc();
+		return reinterpret_cast<pointer>(p);
+	}
+	void deallocate(pointer p, size_type n) { Deallocate(p, n * sizeof(T), tag); }
+
+	size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	void construct(pointer p, const T &v) { new (p) T(v); }
+	void destroy(pointer p) { p->~T(); }
+
+	bool operator==(const tagged_allocator &) const { return true; }
+	bool operator!=(const tagged_allocator &) const { return false; }
+};
+
+} // namespace hg
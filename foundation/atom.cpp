@@ -0,0 +1,95 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "foundation/atom.h"
+#include "foundation/cext.h"
+
+#include <cstring>
+#include <vector>
+
+namespace hg {
+
+static uint32_t hash_string(const char *s, size_t size) { // FNV-1a
+	uint32_t h = 2166136261U;
+	for (size_t i = 0; i < size; ++i)
+		h = (h ^ uint8_t(s[i])) * 16777619U;
+	return h;
+}
+
+struct AtomTable {
+	AtomTable() : buckets(1024, nullptr), count(0) {
+		empty.hash = hash_string("", 0);
+		empty.next = nullptr;
+	}
+
+	std::vector<atom::entry *> buckets; // chained, the bucket count is a power of 2
+	size_t count;
+
+	atom::entry empty;
+
+	const atom::entry *find(const char *s, size_t size, uint32_t hash) const {
+		if (size == 0)
+			return &empty;
+
+		for (const atom::entry *e = buckets[hash & (buckets.size() - 1)]; e; e = e->next)
+			if (e->hash == hash && e->str.size() == size && memcmp(e->str.data(), s, size) == 0)
+				return e;
+		return nullptr;
+	}
+
+	const atom::entry *intern(const char *s, size_t size) {
+		const uint32_t hash = hash_string(s, size);
+
+		if (const atom::entry *e = find(s, size, hash))
+			return e;
+
+		if (count >= buckets.size())
+			grow();
+
+		atom::entry *e = new atom::entry;
+		e->hash = hash;
+		e->str.assign(s, size);
+
+		atom::entry *&bucket = buckets[hash & (buckets.size() - 1)];
+		e->next = bucket;
+		bucket = e;
+
+		++count;
+		return e;
+	}
+
+	void grow() {
+		std::vector<atom::entry *> new_buckets(buckets.size() * 2, nullptr);
+
+		for (size_t i = 0; i < buckets.size(); ++i)
+			for (atom::entry *e = buckets[i]; e;) {
+				atom::entry *next = e->next;
+				atom::entry *&bucket = new_buckets[e->hash & (new_buckets.size() - 1)];
+				e->next = bucket;
+				bucket = e;
+				e = next;
+			}
+
+		buckets.swap(new_buckets);
+	}
+};
+
+static AtomTable &atom_table() {
+	static AtomTable *table = new AtomTable; // never destroyed, atoms might be used during static initialization and destruction
+	return *table;
+}
+
+//
+atom::atom() : e(&atom_table().empty) {}
+atom::atom(const std::string &s) : e(atom_table().intern(s.data(), s.size())) {}
+atom::atom(const char *s) : e(atom_table().intern(s, strlen(s))) {}
+
+bool FindAtom(const std::string &s, atom &a) {
+	const atom::entry *e = atom_table().find(s.data(), s.size(), hash_string(s.data(), s.size()));
+	if (e)
+		a.e = e;
+	return e != nullptr;
+}
+
+size_t GetAtomCount() { return atom_table().count; }
+
+} // namespace hg
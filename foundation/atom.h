@@ -0,0 +1,71 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace hg {
+
+/*
+	atom
+
+	- Interned string, atoms built from equal strings share the same storage.
+	- Comparing two atoms is a pointer comparison.
+	- Ordering is deterministic (string hash then string content) but not lexicographic.
+	- Interned strings are never released.
+	- Creating atoms is not thread-safe.
+
+	Implicitly converts from and to std::string so that string-based APIs can
+	store atoms without changing their signature.
+*/
+class atom {
+public:
+	atom();
+	atom(const std::string &s);
+	atom(const char *s);
+
+	const std::string &str() const { return e->str; }
+	const char *c_str() const { return e->str.c_str(); }
+
+	operator const std::string &() const { return e->str; }
+
+	bool empty() const { return e->str.empty(); }
+	size_t size() const { return e->str.size(); }
+
+	uint32_t hash() const { return e->hash; }
+
+	bool operator==(const atom &a) const { return e == a.e; }
+	bool operator!=(const atom &a) const { return e != a.e; }
+
+	bool operator<(const atom &a) const { return e != a.e && (e->hash != a.e->hash ? e->hash < a.e->hash : e->str < a.e->str); }
+
+	struct entry {
+		uint32_t hash;
+		std::string str;
+		entry *next;
+	};
+
+private:
+	friend bool FindAtom(const std::string &s, atom &a);
+
+	const entry *e;
+};
+
+// comparing to a string does not intern it
+inline bool operator==(const atom &a, const std::string &s) { return a.str() == s; }
+inline bool operator!=(const atom &a, const std::string &s) { return a.str() != s; }
+inline bool operator==(const std::string &s, const atom &a) { return a.str() == s; }
+inline bool operator!=(const std::string &s, const atom &a) { return a.str() != s; }
+inline bool operator==(const atom &a, const char *s) { return a.str() == s; }
+inline bool operator!=(const atom &a, const char *s) { return a.str() != s; }
+inline bool operator==(const char *s, const atom &a) { return a.str() == s; }
+inline bool operator!=(const char *s, const atom &a) { return a.str() != s; }
+
+/// Get the atom of a string without interning it, return false if no atom was ever built from this string.
+bool FindAtom(const std::string &s, atom &a);
+
+/// Return the number of interned strings.
+size_t GetAtomCount();
+
+} // namespace hg
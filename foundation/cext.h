@@ -14,7 +14,7 @@
 
 namespace hg {
 
-#if __cplusplus <= 201103L // upto C++11
+#if __cplusplus < 201103L // before C++11
 #define nullptr NULL
 #define constexpr
 #endif
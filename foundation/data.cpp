@@ -1,6 +1,7 @@
 // HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
 
 #include "foundation/data.h"
+#include "foundation/allocator.h"
 #include "foundation/file.h"
 
 namespace hg {
@@ -31,16 +32,27 @@ Data &Data::operator=(const Data &data) {
 }
 
 #if __cplusplus >= 201103L
+Data::Data(Data &&data) : data_(data.data_), size_(data.size_), capacity_(data.capacity_), has_ownership(data.has_ownership), cursor(data.cursor) {
+	data.data_ = nullptr;
+	data.size_ = data.capacity_ = 0;
+	data.has_ownership = false;
+	data.cursor = 0;
+}
+
 Data &Data::operator=(Data &&data) {
+	if (&data == this)
+		return *this;
+
 	Free();
 
 	data_ = data.data_;
 	size_ = data.size_;
+	capacity_ = data.capacity_;
 	has_ownership = data.has_ownership;
 	cursor = data.cursor;
 
 	data.data_ = nullptr;
-	data.size_ = 0;
+	data.size_ = data.capacity_ = 0;
 	data.has_ownership = false;
 	data.cursor = 0;
 
@@ -52,7 +64,7 @@ bool Data::Reserve(size_t size) {
 	const size_t new_capacity = (size / 8192 + 1) * 8192; // grow in 8KB increments
 
 	if (new_capacity > capacity_) {
-		uint8_t *_data_ = new uint8_t[new_capacity];
+		uint8_t *_data_ = reinterpret_cast<uint8_t *>(Allocate(new_capacity, MT_Data));
 		if (_data_ == nullptr)
 			return false;
 
@@ -60,7 +72,7 @@ bool Data::Reserve(size_t size) {
 			std::copy(data_, data_ + size_, _data_);
 
 		if (has_ownership)
-			delete[] data_;
+			Deallocate(data_, capacity_, MT_Data);
 		has_ownership = true;
 
 		data_ = _data_;
@@ -118,7 +130,7 @@ size_t Data::Read(void *data, size_t size) const {
 
 void Data::Free() {
 	if (has_ownership)
-		delete[] data_;
+		Deallocate(data_, capacity_, MT_Data);
 
 	data_ = nullptr;
 	size_ = 0;
@@ -28,6 +28,34 @@
 
 namespace hg {
 
+#if !_WIN32
+// some filesystems do not report the entry type, query it without following links
+static int GetDirEntryType(const std::string &path, const struct dirent *ent) {
+	unsigned char d_type = ent->d_type;
+
+	if (d_type == DT_UNKNOWN) {
+		struct stat info;
+		if (lstat(PathJoin(path, ent->d_name).c_str(), &info) != 0)
+			return 0;
+
+		if (S_ISDIR(info.st_mode))
+			d_type = DT_DIR;
+		else if (S_ISREG(info.st_mode))
+			d_type = DT_REG;
+		else if (S_ISLNK(info.st_mode))
+			d_type = DT_LNK;
+	}
+
+	if (d_type == DT_DIR)
+		return DE_Dir;
+	if (d_type == DT_REG)
+		return DE_File;
+	if (d_type == DT_LNK)
+		return DE_Link;
+	return 0;
+}
+#endif
+
 std::vector<DirEntry> ListDir(const std::string &path, int mask) {
 	std::vector<DirEntry> entries;
 
@@ -70,16 +98,7 @@ std::vector<DirEntry> ListDir(const std::string &path, int mask) {
 		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
 			continue;
 
-		DirEntry entry;
-
-		int type = 0;
-
-		if (ent->d_type == DT_DIR)
-			type = DE_Dir;
-		else if (ent->d_type == DT_REG)
-			type = DE_File;
-		else if (ent->d_type == DT_LNK)
-			type = DE_Link;
+		const int type = GetDirEntryType(path, ent);
 
 		// TODO: stat() missing infos
 		if (mask & type) {
@@ -132,7 +151,7 @@ std::vector<DirEntry> ListDirRecursive(const std::string &path, int mask) {
 	while (struct dirent *ent = readdir(dir)) {
 		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
 			continue;
-		if (ent->d_type == DT_DIR) {
+		if (GetDirEntryType(path, ent) == DE_Dir) {
 			elms[0] = path;
 			elms[1] = ent->d_name;
 			const std::vector<DirEntry> sub_entries = ListDirRecursive(PathJoin(elms), mask);
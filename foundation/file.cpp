@@ -5,6 +5,8 @@
 #include <Windows.h>
 #include <sys/stat.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -16,6 +18,7 @@
 #include "foundation/log.h"
 #include "foundation/rand.h"
 #include "foundation/string.h"
+#include "foundation/thread.h"
 
 //#include <cstdio>
 #include <fmt/format.h>
@@ -24,7 +27,14 @@
 
 namespace hg {
 
+// the handle table is shared by all threads, file operations resolve the handle under lock then run unlocked
 static generational_vector_list<FILE *> files;
+static Mutex files_lock;
+
+static FILE *_GetFILE(File file) {
+	ScopedLock lock(files_lock);
+	return files.is_valid(file.ref) ? files[file.ref.idx] : nullptr;
+}
 
 static FILE *_Open(const std::string &path, const std::string &mode, bool silent = false) {
 	FILE *file = nullptr;
@@ -43,7 +53,11 @@ static FILE *_Open(const std::string &path, const std::string &mode, bool silent
 }
 
 static inline File from_posix_FILE(FILE *f) {
-	File out = {f ? files.add_ref(f) : invalid_gen_ref};
+	File out;
+	if (f) {
+		ScopedLock lock(files_lock);
+		out.ref = files.add_ref(f);
+	}
 	return out;
 }
 
@@ -54,21 +68,32 @@ File OpenWriteText(const std::string &path) { return from_posix_FILE(_Open(path,
 File OpenAppendText(const std::string &path) { return from_posix_FILE(_Open(path, "a")); }
 
 bool Close(File file) {
-	if (!files.is_valid(file.ref))
-		return false;
-	fclose(files[file.ref.idx]);
-	files.remove_ref(file.ref);
+	FILE *f;
+	{
+		ScopedLock lock(files_lock);
+		if (!files.is_valid(file.ref))
+			return false;
+		f = files[file.ref.idx];
+		files.remove_ref(file.ref);
+	}
+	fclose(f);
 	return true;
 }
 
-bool IsValid(File file) { return files.is_valid(file.ref); }
+bool IsValid(File file) {
+	ScopedLock lock(files_lock);
+	return files.is_valid(file.ref);
+}
 
-bool IsEOF(File file) { return files.is_valid(file.ref) ? feof(files[file.ref.idx]) != 0 : true; }
+bool IsEOF(File file) {
+	FILE *f = _GetFILE(file);
+	return f ? feof(f) != 0 : true;
+}
 
 size_t GetSize(File file) {
-	if (!files.is_valid(file.ref))
+	FILE *s = _GetFILE(file);
+	if (!s)
 		return 0;
-	FILE *s = files[file.ref.idx];
 	long t = ftell(s);
 	fseek(s, 0, SEEK_END);
 	long size = ftell(s);
@@ -76,9 +101,15 @@ size_t GetSize(File file) {
 	return size;
 }
 
-size_t Read(File file, void *data, size_t size) { return files.is_valid(file.ref) ? fread(data, 1, size, files[file.ref.idx]) : 0; }
+size_t Read(File file, void *data, size_t size) {
+	FILE *f = _GetFILE(file);
+	return f ? fread(data, 1, size, f) : 0;
+}
 
-size_t Write(File file, const void *data, size_t size) { return files.is_valid(file.ref) ? fwrite(data, 1, size, files[file.ref.idx]) : 0; }
+size_t Write(File file, const void *data, size_t size) {
+	FILE *f = _GetFILE(file);
+	return f ? fwrite(data, 1, size, f) : 0;
+}
 
 bool Seek(File file, ptrdiff_t offset, SeekMode mode) {
 	int _mode;
@@ -88,14 +119,19 @@ bool Seek(File file, ptrdiff_t offset, SeekMode mode) {
 		_mode = SEEK_CUR;
 	else
 		_mode = SEEK_END;
-	return files.is_valid(file.ref) ? (fseek(files[file.ref.idx], long(offset), _mode) == 0) : false;
+	FILE *f = _GetFILE(file);
+	return f ? (fseek(f, long(offset), _mode) == 0) : false;
 }
 
-size_t Tell(File file) { return files.is_valid(file.ref) ? ftell(files[file.ref.idx]) : 0; }
+size_t Tell(File file) {
+	FILE *f = _GetFILE(file);
+	return f ? ftell(f) : 0;
+}
 
 void Rewind(File file) {
-	if (files.is_valid(file.ref))
-		fseek(files[file.ref.idx], 0, SEEK_SET);
+	FILE *f = _GetFILE(file);
+	if (f)
+		fseek(f, 0, SEEK_SET);
 }
 
 //
@@ -143,6 +179,77 @@ bool Unlink(const std::string &path) {
 #endif
 }
 
+//
+bool MapFile(const std::string &path, MappedFile &map) {
+	map.data = nullptr;
+	map.size = 0;
+	map.handle = nullptr;
+
+#if _WIN32
+	const std::wstring wpath = utf8_to_wchar(path);
+
+	HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file); // the mapping keeps the file open
+	if (!mapping)
+		return false;
+
+	const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	map.data = reinterpret_cast<const uint8_t *>(data);
+	map.size = size_t(size.QuadPart);
+	map.handle = mapping;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps the file open
+	if (data == MAP_FAILED)
+		return false;
+
+	map.data = reinterpret_cast<const uint8_t *>(data);
+	map.size = size_t(info.st_size);
+#endif
+	return true;
+}
+
+void UnmapFile(MappedFile &map) {
+	if (!map.data)
+		return;
+
+#if _WIN32
+	UnmapViewOfFile(map.data);
+	CloseHandle(map.handle);
+#else
+	munmap(const_cast<uint8_t *>(map.data), map.size);
+#endif
+
+	map.data = nullptr;
+	map.size = 0;
+	map.handle = nullptr;
+}
+
 //
 bool CopyFile(const std::string &src, const std::string &dst) {
 #if _WIN32
@@ -169,6 +276,16 @@ bool CopyFile(const std::string &src, const std::string &dst) {
 #endif
 }
 
+bool RenameFile(const std::string &src, const std::string &dst) {
+#if _WIN32
+	const std::wstring wsrc = utf8_to_wchar(src);
+	const std::wstring wdst = utf8_to_wchar(dst);
+	return ::MoveFileExW(wsrc.c_str(), wdst.c_str(), MOVEFILE_REPLACE_EXISTING) ? true : false;
+#else
+	return rename(src.c_str(), dst.c_str()) == 0;
+#endif
+}
+
 //
 bool FileToData(const std::string &path, Data &data, bool silent) {
 	File file = Open(path, silent);
@@ -16,6 +16,7 @@
 
 namespace hg {
 
+/// File handle, handles can be opened and closed from any thread but a handle must not be used by several threads at once.
 struct File {
 	gen_ref ref;
 };
@@ -69,6 +70,8 @@ template <typename T> bool Write(File file, const T &v) { return Write(file, &v,
 
 /// Copy a file on the local filesystem.
 bool CopyFile(const std::string &src, const std::string &dst);
+/// Rename a file on the local filesystem, replacing the destination if it exists.
+bool RenameFile(const std::string &src, const std::string &dst);
 
 /// Return the content of a file on the local filesystem as a string.
 std::string FileToString(const std::string &path, bool silent = false);
@@ -88,4 +91,15 @@ struct ScopedFile {
 	File f;
 };
 
+/// Read-only memory mapping of a file on the local filesystem.
+struct MappedFile {
+	const uint8_t *data;
+	size_t size;
+	void *handle;
+};
+
+/// Map a file in memory, the mapping stays valid until UnmapFile is called even if the file is closed or unlinked.
+bool MapFile(const std::string &path, MappedFile &map);
+void UnmapFile(MappedFile &map);
+
 } // namespace hg
@@ -0,0 +1,125 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "foundation/frame_arena.h"
+#include "foundation/allocator.h"
+#include "foundation/assert.h"
+#include "foundation/cext.h"
+#include "foundation/thread.h"
+
+namespace hg {
+
+static const size_t frame_arena_block_size = 256 * 1024;
+
+struct FrameArena {
+	FrameArena() : block(0), offset(0), base(0), alloc_count(0), alloc_size(0), peak_size(0), reserved_size(0) {}
+	~FrameArena() {
+		for (size_t i = 0; i < blocks.size(); ++i)
+			Deallocate(blocks[i].data, blocks[i].size, MT_FrameArena);
+	}
+
+	struct Block {
+		uint8_t *data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+
+	size_t block, offset; // allocation cursor
+	size_t base; // total size of the blocks before the current one
+
+	size_t alloc_count, alloc_size, peak_size, reserved_size;
+
+	void *alloc(size_t size, size_t align) {
+		__ASSERT__(align && !(align & (align - 1))); // power of 2
+
+		if (size > std::numeric_limits<size_t>::max() - align)
+			return nullptr;
+
+		for (;;) {
+			if (block < blocks.size()) {
+				const Block &b = blocks[block];
+				const size_t aligned = ((reinterpret_cast<uintptr_t>(b.data) + offset + align - 1) & ~uintptr_t(align - 1)) - reinterpret_cast<uintptr_t>(b.data);
+
+				if (aligned + size <= b.size) {
+					offset = aligned + size;
+
+					++alloc_count;
+					alloc_size += size;
+					if (base + offset > peak_size)
+						peak_size = base + offset;
+
+					return b.data + aligned;
+				}
+
+				base += b.size; // does not fit, move to the next block
+				++block;
+				offset = 0;
+			} else {
+				Block b;
+				b.size = size + align > frame_arena_block_size ? size + align : frame_arena_block_size;
+				b.data = reinterpret_cast<uint8_t *>(Allocate(b.size, MT_FrameArena));
+				if (!b.data)
+					return nullptr;
+
+				blocks.push_back(b);
+				reserved_size += b.size;
+			}
+		}
+	}
+
+	void rewind(size_t block_, size_t offset_) {
+		block = block_;
+		offset = offset_;
+
+		base = 0;
+		for (size_t i = 0; i < block && i < blocks.size(); ++i)
+			base += blocks[i].size;
+	}
+};
+
+static HG_THREAD_LOCAL FrameArena *tls_frame_arena = nullptr;
+
+static FrameArena &GetFrameArena() {
+	if (!tls_frame_arena)
+		tls_frame_arena = new FrameArena;
+	return *tls_frame_arena;
+}
+
+//
+void *FrameAlloc(size_t size, size_t align) { return GetFrameArena().alloc(size, align); }
+
+void ResetFrameArena() {
+	if (!tls_frame_arena)
+		return;
+
+	FrameArena &arena = *tls_frame_arena;
+	arena.rewind(0, 0);
+	arena.alloc_count = arena.alloc_size = arena.peak_size = 0;
+}
+
+void FreeFrameArena() {
+	delete tls_frame_arena;
+	tls_frame_arena = nullptr;
+}
+
+FrameArenaStats GetFrameArenaStats() {
+	FrameArenaStats stats = {0, 0, 0, 0};
+	if (tls_frame_arena) {
+		stats.alloc_count = tls_frame_arena->alloc_count;
+		stats.alloc_size = tls_frame_arena->alloc_size;
+		stats.peak_size = tls_frame_arena->peak_size;
+		stats.reserved_size = tls_frame_arena->reserved_size;
+	}
+	return stats;
+}
+
+//
+FrameArenaScope::FrameArenaScope() {
+	const FrameArena &arena = GetFrameArena();
+	block = arena.block;
+	offset = arena.offset;
+}
+
+FrameArenaScope::~FrameArenaScope() { GetFrameArena().rewind(block, offset); }
+
+} // namespace hg
@@ -0,0 +1,96 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/cext.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace hg {
+
+/*
+	Frame arena
+
+	- Linear allocator for transient allocations, each thread has its own arena.
+	- Allocating is a pointer bump, freeing is a no-op.
+	- ResetFrameArena() releases all allocations of the calling thread at once and should be called once per frame.
+	- FrameArenaScope releases the allocations made during its lifetime, code using the arena internally
+	  should open a scope so that it does not depend on the application resetting the arena.
+
+	Memory allocated from the arena must not be kept across a reset or outside of the scope it was allocated in.
+*/
+/// Return null if the arena cannot grow to fit the allocation.
+void *FrameAlloc(size_t size, size_t align = 16);
+
+/// Release all allocations of the calling thread arena, memory blocks are kept for the next frame.
+void ResetFrameArena();
+/// Release all allocations and memory blocks of the calling thread arena.
+void FreeFrameArena();
+
+struct FrameArenaStats {
+	size_t alloc_count; // allocations since the last reset
+	size_t alloc_size; // bytes allocated since the last reset
+	size_t peak_size; // highest arena usage since the last reset
+	size_t reserved_size; // bytes held by the arena memory blocks
+};
+
+/// Return the calling thread arena statistics.
+FrameArenaStats GetFrameArenaStats();
+
+class FrameArenaScope {
+public:
+	FrameArenaScope();
+	~FrameArenaScope();
+
+private:
+	size_t block, offset;
+
+	FrameArenaScope(const FrameArenaScope &);
+	FrameArenaScope &operator=(const FrameArenaScope &);
+};
+
+/// Standard allocator allocating from the calling thread arena, throws std::bad_alloc if the arena cannot grow.
+template <typename T> class frame_allocator {
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <typename U> struct rebind { typedef frame_allocator<U> other; };
+
+	frame_allocator() {}
+	template <typename U> frame_allocator(const frame_allocator<U> &) {}
+
+	pointer address(reference v) const { return &v; }
+	const_pointer address(const_reference v) const { return &v; }
+
+	pointer allocate(size_type n, const void * = 0) {
+		void *p = n <= max_size() ? FrameAlloc(n * sizeof(T), sizeof(T) < 16 ? 8 : 16) : nullptr;
+		if (!p)
+			throw std::bad_alloc();
+		return reinterpret_cast<pointer>(p);
+	}
+	void deallocate(pointer, size_type) {}
+
+	size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	void construct(pointer p, const T &v) { new (p) T(v); }
+	void destroy(pointer p) { p->~T(); }
+
+	bool operator==(const frame_allocator &) const { return true; }
+	bool operator!=(const frame_allocator &) const { return false; }
+};
+
+/// std::vector allocating from the calling thread arena, eg. frame_vector<NodeRef>::type refs;
+template <typename T> struct frame_vector { typedef std::vector<T, frame_allocator<T> > type; };
+
+} // namespace hg
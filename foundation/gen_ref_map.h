@@ -0,0 +1,108 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/generational_vector_list.h"
+
+#include <utility>
+#include <vector>
+
+namespace hg {
+
+/*
+	gen_ref_map
+
+	- A map of gen_ref to T with constant time lookup/insert/erase.
+	- Entries are stored densely, an index table maps a reference index to its entry.
+	- Only the reference generation stored in the map is found.
+	- Fast iteration, in no particular order.
+
+	Memory usage: size() * (sizeof(T) + sizeof(gen_ref)) + highest index * sizeof(uint32_t) + k
+
+	Inserting an entry invalidates all iterators, erasing an entry invalidates
+	iterators to the erased and last entries.
+*/
+template <typename T> class gen_ref_map {
+public:
+	typedef std::pair<gen_ref, T> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin() { return values.begin(); }
+	iterator end() { return values.end(); }
+	const_iterator begin() const { return values.begin(); }
+	const_iterator end() const { return values.end(); }
+
+	size_t size() const { return values.size(); }
+	bool empty() const { return values.empty(); }
+
+	iterator find(gen_ref ref) {
+		const uint32_t pos = position(ref);
+		return pos == npos ? values.end() : values.begin() + pos;
+	}
+
+	const_iterator find(gen_ref ref) const {
+		const uint32_t pos = position(ref);
+		return pos == npos ? values.end() : values.begin() + pos;
+	}
+
+	size_t count(gen_ref ref) const { return position(ref) == npos ? 0 : 1; }
+
+	T &operator[](gen_ref ref) {
+		if (ref.idx >= positions.size())
+			positions.resize(size_t(ref.idx) + 64, uint32_t(npos));
+
+		uint32_t &pos = positions[ref.idx];
+
+		if (pos == npos) {
+			pos = uint32_t(values.size());
+			values.push_back(value_type(ref, T()));
+		} else if (values[pos].first != ref) {
+			values[pos] = value_type(ref, T()); // entry left by a previous generation of this index
+		}
+
+		return values[pos].second;
+	}
+
+	void erase(iterator i) {
+		const size_t pos = i - values.begin();
+		positions[i->first.idx] = npos;
+
+		if (pos + 1 != values.size()) {
+			value_type &last = values.back();
+			values[pos].first = last.first;
+			std::swap(values[pos].second, last.second);
+			positions[last.first.idx] = uint32_t(pos);
+		}
+
+		values.pop_back();
+	}
+
+	size_t erase(gen_ref ref) {
+		const iterator i = find(ref);
+		if (i == values.end())
+			return 0;
+		erase(i);
+		return 1;
+	}
+
+	void clear() {
+		positions.clear();
+		values.clear();
+	}
+
+private:
+	static const uint32_t npos = 0xffffffff;
+
+	uint32_t position(gen_ref ref) const {
+		if (ref.idx >= positions.size())
+			return npos;
+		const uint32_t pos = positions[ref.idx];
+		return pos != npos && values[pos].first == ref ? pos : npos;
+	}
+
+	std::vector<uint32_t> positions;
+	std::vector<value_type> values;
+};
+
+} // namespace hg
@@ -4,6 +4,7 @@
 
 #include "foundation/assert.h"
 #include "foundation/cext.h"
+#include "foundation/packed_vector_list.h"
 #include "foundation/vector_list.h"
 
 namespace hg {
@@ -20,30 +21,39 @@ inline bool operator!=(gen_ref a, gen_ref b) { return a.idx != b.idx || a.gen !=
 
 inline bool operator<(gen_ref a, gen_ref b) { return a.gen == b.gen ? a.idx < b.idx : a.gen < b.gen; }
 
-template <typename T> class generational_vector_list : public vector_list<T> {
+// S is the entry storage, either vector_list<T> or packed_vector_list<T>
+template <typename T, typename S = vector_list<T> > class generational_vector_list : public S {
 public:
 	gen_ref add_ref(const T &v) {
 		gen_ref ref;
-		ref.idx = vector_list<T>::add(v);
+		ref.idx = S::add(v);
 		if (ref.idx >= generations.size())
 			generations.resize(size_t(ref.idx) + 64);
 		ref.gen = generations[ref.idx];
 		return ref;
 	}
 
-#if __cpluscplus >= 201103L
+#if __cplusplus >= 201103L
 	gen_ref add_ref(T &&v) {
-		auto idx = vector_list<T>::add(std::forward<T>(v));
-		if (idx >= generations.size())
-			generations.resize(size_t(idx) + 64);
-		return {idx, generations[idx]};
+		gen_ref ref;
+		ref.idx = S::add(std::move(v));
+		if (ref.idx >= generations.size())
+			generations.resize(size_t(ref.idx) + 64);
+		ref.gen = generations[ref.idx];
+		return ref;
 	}
 #endif
 
+	void reserve(size_t count) {
+		S::reserve(count);
+		if (count > generations.size())
+			generations.resize(count);
+	}
+
 	void remove_ref(gen_ref ref) {
 		if (is_valid(ref)) {
 			++generations[ref.idx]; // increase generation for this index
-			this->remove(ref.idx);
+			this->erase(ref.idx);
 		}
 	}
 
@@ -79,7 +89,7 @@ public:
 	bool is_valid(gen_ref ref) const { return this->is_used(ref.idx) && ref.idx < generations.size() && ref.gen == generations[ref.idx]; }
 
 	void clear() {
-		vector_list<T>::clear();
+		S::clear();
 		generations.clear();
 	}
 
@@ -0,0 +1,296 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "foundation/job.h"
+#include "foundation/assert.h"
+#include "foundation/frame_arena.h"
+
+#include <deque>
+
+namespace hg {
+
+struct JobQueue {
+	Mutex lock;
+	std::deque<Job> jobs;
+};
+
+struct JobSystem {
+	std::vector<Thread *> threads;
+	std::vector<JobQueue *> queues;
+
+	volatile int32_t pending; // queued jobs not yet picked
+	volatile int32_t next_queue; // round-robin queue for jobs queued from a non-worker thread
+
+	Mutex sleep_lock;
+	ConditionVariable wake;
+	size_t sleeping;
+	bool stop;
+
+	JobSystem() : pending(0), next_queue(0), sleeping(0), stop(false) {}
+
+	static void Push(const Job &job);
+	static bool Pop(Job &job);
+	static void Execute(const Job &job);
+
+	static void Worker(void *user);
+};
+
+static JobSystem *job_system = nullptr;
+static HG_THREAD_LOCAL size_t tls_worker = 0; // worker index + 1, 0 if the thread is not a worker
+
+//
+void JobSystem::Push(const Job &job) {
+	JobSystem *sys = job_system;
+
+	if (!sys) {
+		Execute(job);
+		return;
+	}
+
+	const size_t queue_count = sys->queues.size();
+	JobQueue &queue = *sys->queues[tls_worker ? tls_worker - 1 : size_t(uint32_t(AtomicAdd(sys->next_queue, 1))) % queue_count];
+
+	{
+		ScopedLock lock(queue.lock);
+		queue.jobs.push_back(job);
+	}
+
+	AtomicAdd(sys->pending, 1);
+
+	ScopedLock lock(sys->sleep_lock);
+	if (sys->sleeping)
+		sys->wake.notify_one();
+}
+
+bool JobSystem::Pop(Job &job) {
+	JobSystem *sys = job_system;
+
+	if (!sys || AtomicLoad(sys->pending) == 0)
+		return false;
+
+	const size_t queue_count = sys->queues.size();
+
+	if (tls_worker) { // newest job of our own queue
+		JobQueue &queue = *sys->queues[tls_worker - 1];
+
+		ScopedLock lock(queue.lock);
+		if (!queue.jobs.empty()) {
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			AtomicAdd(sys->pending, -1);
+			return true;
+		}
+	}
+
+	const size_t first = tls_worker ? tls_worker : 0;
+
+	for (size_t i = 0; i < queue_count; ++i) { // steal the oldest job of another queue
+		JobQueue &queue = *sys->queues[(first + i) % queue_count];
+
+		ScopedLock lock(queue.lock);
+		if (!queue.jobs.empty()) {
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			AtomicAdd(sys->pending, -1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(const Job &job) {
+	job.func(job.user);
+
+	JobCounter *counter = job.counter;
+	if (!counter)
+		return;
+
+	// the counter can be released by a waiting thread as soon as it reads zero, keep it alive until we are done with it
+	AtomicAdd(counter->releasing, 1);
+
+	if (AtomicAdd(counter->count, -1) == 0) {
+		std::vector<Job> dependents;
+		{
+			ScopedLock lock(counter->lock);
+			dependents.swap(counter->dependents);
+		}
+
+		for (size_t i = 0; i < dependents.size(); ++i)
+			Push(dependents[i]);
+	}
+
+	AtomicAdd(counter->releasing, -1); // do not touch the counter past this point
+}
+
+void JobSystem::Worker(void *user) {
+	JobSystem &sys = *job_system;
+	tls_worker = reinterpret_cast<size_t>(user);
+
+	for (;;) {
+		Job job;
+		if (Pop(job)) {
+			Execute(job);
+			continue;
+		}
+
+		ScopedLock lock(sys.sleep_lock);
+
+		while (!sys.stop && AtomicLoad(sys.pending) == 0) {
+			++sys.sleeping;
+			sys.wake.wait(sys.sleep_lock);
+			--sys.sleeping;
+		}
+
+		if (sys.stop && AtomicLoad(sys.pending) == 0)
+			break;
+	}
+
+	FreeFrameArena();
+	tls_worker = 0;
+}
+
+//
+JobCounter::JobCounter() : count(0), releasing(0) {}
+JobCounter::~JobCounter() { WaitJobCounter(*this); }
+
+bool JobCounter::is_done() const { return AtomicLoad(count) == 0 && AtomicLoad(releasing) == 0; }
+
+//
+bool StartJobSystem(size_t worker_count) {
+	if (job_system)
+		return false;
+
+	if (worker_count == 0)
+		return true;
+
+	JobSystem *sys = new JobSystem;
+	for (size_t i = 0; i < worker_count; ++i)
+		sys->queues.push_back(new JobQueue);
+
+	job_system = sys;
+
+	for (size_t i = 0; i < worker_count; ++i) {
+		Thread *thread = new Thread;
+		sys->threads.push_back(thread);
+
+		if (!thread->start(JobSystem::Worker, reinterpret_cast<void *>(i + 1))) {
+			StopJobSystem();
+			return false;
+		}
+	}
+	return true;
+}
+
+void StopJobSystem() {
+	JobSystem *sys = job_system;
+	if (!sys)
+		return;
+
+	__ASSERT__(!tls_worker);
+
+	{
+		ScopedLock lock(sys->sleep_lock);
+		sys->stop = true;
+		sys->wake.notify_all();
+	}
+
+	for (size_t i = 0; i < sys->threads.size(); ++i)
+		delete sys->threads[i]; // joins
+
+	job_system = nullptr;
+
+	for (size_t i = 0; i < sys->queues.size(); ++i) {
+		__ASSERT__(sys->queues[i]->jobs.empty());
+		delete sys->queues[i];
+	}
+
+	delete sys;
+}
+
+size_t GetJobWorkerCount() { return job_system ? job_system->threads.size() : 0; }
+
+size_t GetDefaultJobWorkerCount() {
+	const size_t count = GetHardwareThreadCount();
+	return count > 1 ? count - 1 : 1;
+}
+
+bool IsJobWorkerThread() { return tls_worker != 0; }
+
+//
+void RunJob(JobFunc func, void *user, JobCounter *counter, JobCounter *dependency) {
+	__ASSERT__(func);
+	__ASSERT__(!counter || counter != dependency);
+
+	Job job = {func, user, counter};
+
+	if (counter)
+		AtomicAdd(counter->count, 1);
+
+	if (dependency) {
+		ScopedLock lock(dependency->lock);
+		if (AtomicLoad(dependency->count) != 0) {
+			dependency->dependents.push_back(job); // queued by the last job of the dependency
+			return;
+		}
+	}
+
+	JobSystem::Push(job);
+}
+
+void WaitJobCounter(const JobCounter &counter) {
+	while (!counter.is_done()) {
+		Job job;
+		if (JobSystem::Pop(job))
+			JobSystem::Execute(job);
+		else
+			ThreadYield();
+	}
+}
+
+//
+struct ParallelForRange {
+	ParallelForFunc func;
+	void *user;
+	size_t begin, end;
+};
+
+static void ParallelForJob(void *user) {
+	const ParallelForRange &range = *reinterpret_cast<const ParallelForRange *>(user);
+	range.func(range.begin, range.end, range.user);
+}
+
+void ParallelFor(size_t begin, size_t end, size_t grain, ParallelForFunc func, void *user) {
+	if (end <= begin)
+		return;
+
+	const size_t size = end - begin, worker_count = GetJobWorkerCount();
+
+	if (worker_count == 0) {
+		func(begin, end, user);
+		return;
+	}
+
+	if (grain == 0) {
+		grain = size / ((worker_count + 1) * 4);
+		if (grain == 0)
+			grain = 1;
+	}
+
+	const size_t range_count = (size + grain - 1) / grain;
+
+	std::vector<ParallelForRange> ranges(range_count);
+	for (size_t i = 0; i < range_count; ++i) {
+		ranges[i].func = func;
+		ranges[i].user = user;
+		ranges[i].begin = begin + i * grain;
+		ranges[i].end = i + 1 < range_count ? ranges[i].begin + grain : end;
+	}
+
+	JobCounter counter;
+	for (size_t i = 1; i < range_count; ++i)
+		RunJob(ParallelForJob, &ranges[i], &counter);
+
+	ParallelForJob(&ranges[0]); // first range runs on the calling thread
+	WaitJobCounter(counter);
+}
+
+} // namespace hg
@@ -0,0 +1,86 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/cext.h"
+#include "foundation/thread.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace hg {
+
+/*
+	Job system
+
+	- Fixed pool of worker threads, each owning a job queue.
+	- A worker runs the newest job of its own queue first and steals the oldest job of another queue when its own is empty.
+	- Jobs queued from a thread that is not a worker are distributed round-robin across the worker queues.
+	- A JobCounter tracks the jobs it was passed to, waiting on a counter runs queued jobs on the waiting thread.
+	- A job can depend on a counter, it is only queued once that counter reaches zero.
+	- When started with 0 workers (or not started at all) jobs run immediately on the calling thread.
+*/
+typedef void (*JobFunc)(void *user);
+
+class JobCounter;
+
+struct Job {
+	JobFunc func;
+	void *user;
+	JobCounter *counter;
+};
+
+class JobCounter {
+public:
+	JobCounter();
+	~JobCounter(); // waits for the counter to reach zero
+
+	/// Return true once every job passed to this counter has completed.
+	bool is_done() const;
+
+private:
+	friend void RunJob(JobFunc, void *, JobCounter *, JobCounter *);
+	friend struct JobSystem;
+
+	mutable volatile int32_t count; // jobs in flight
+	mutable volatile int32_t releasing; // jobs still touching the counter after completing
+
+	Mutex lock;
+	std::vector<Job> dependents; // jobs waiting for the counter to reach zero
+
+	JobCounter(const JobCounter &);
+	JobCounter &operator=(const JobCounter &);
+};
+
+/// Start the job system with a number of worker threads, return false if the system is already started or a thread could not be created.
+bool StartJobSystem(size_t worker_count);
+/// Run all queued jobs then stop the worker threads.
+void StopJobSystem();
+
+/// Return the number of worker threads, 0 if the system is not started.
+size_t GetJobWorkerCount();
+/// Return the recommended number of worker threads: one per hardware thread minus the calling thread.
+size_t GetDefaultJobWorkerCount();
+
+/// Return true if the calling thread is a job system worker.
+bool IsJobWorkerThread();
+
+/**
+	Queue a job. The counter, if any, is incremented immediately and decremented once the job has completed.
+	If a dependency is given the job is only queued once the dependency counter reaches zero.
+*/
+void RunJob(JobFunc func, void *user, JobCounter *counter = nullptr, JobCounter *dependency = nullptr);
+
+/// Wait for a counter to reach zero, queued jobs are run on the calling thread while waiting.
+void WaitJobCounter(const JobCounter &counter);
+
+typedef void (*ParallelForFunc)(size_t begin, size_t end, void *user);
+
+/**
+	Call func over the [begin;end[ range split in sub-ranges of at most grain elements and wait for completion.
+	A grain of 0 picks a size yielding a few sub-ranges per worker. With 0 workers func is called once on the whole range.
+*/
+void ParallelFor(size_t begin, size_t end, size_t grain, ParallelForFunc func, void *user);
+
+} // namespace hg
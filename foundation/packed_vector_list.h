@@ -0,0 +1,202 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include "foundation/assert.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace hg {
+
+/*
+	packed_vector_list
+
+	- Same interface as vector_list, can be used as the storage of a generational_vector_list.
+	- Entries in use are kept densely packed (sparse set), iteration cost only depends on size().
+	- Removing an entry moves the last entry in its place, entries do move in memory.
+	- Store less than 2^32-1 entries.
+
+	Memory usage: size() * (sizeof(T) + sizeof(uint32_t)) + highest index * 2 * sizeof(uint32_t) + k
+
+	Prefer vector_list when pointers to entries must remain valid or entries
+	are expensive to copy. Prefer packed_vector_list for small entries with
+	frequent add/remove that are mostly accessed by iterating the container.
+*/
+template <typename T> class packed_vector_list {
+public:
+	static const uint32_t invalid_idx = 0xffffffff;
+
+	packed_vector_list() {}
+	explicit packed_vector_list(size_t count) { reserve(count); }
+
+	//
+	void reserve(size_t count) {
+		values_.reserve(count);
+		dense_idx_.reserve(count);
+
+		const uint32_t capacity_ = uint32_t(sparse_.size());
+
+		if (count > capacity_) {
+			sparse_.resize(count, uint32_t(invalid_idx));
+
+			free_.reserve(count);
+			for (uint32_t i = uint32_t(count); i > capacity_; --i)
+				free_.push_back(i - 1); // lowest index on top of the free stack
+		}
+	}
+
+	size_t size() const { return values_.size(); }
+	size_t capacity() const { return sparse_.size(); }
+
+	void clear() {
+		values_.clear();
+		dense_idx_.clear();
+		sparse_.clear();
+		free_.clear();
+	}
+
+	//
+	T &operator[](size_t i) { return values_[sparse_[i]]; }
+	const T &operator[](size_t i) const { return values_[sparse_[i]]; }
+
+	T &value(size_t i) { return values_[sparse_[i]]; }
+	const T &value(size_t i) const { return values_[sparse_[i]]; }
+
+	//
+	uint32_t first() const { return dense_idx_.empty() ? invalid_idx : dense_idx_[0]; }
+
+	uint32_t next(uint32_t from) const {
+		const uint32_t pos = sparse_[from] + 1;
+		return pos < dense_idx_.size() ? dense_idx_[pos] : invalid_idx;
+	}
+
+	//
+	bool is_used(uint32_t i) const { return i < sparse_.size() && sparse_[i] != invalid_idx; }
+
+	//
+	class iterator {
+	public:
+		inline iterator(packed_vector_list<T> *c_, uint32_t pos_) : c(c_), pos(pos_) {}
+
+		inline T &operator*() const { return c->values_[pos]; }
+		inline T *operator->() const { return &c->values_[pos]; }
+
+		inline bool operator==(const iterator &i_) const { return pos == i_.pos; }
+		inline bool operator!=(const iterator &i_) const { return pos != i_.pos; }
+		inline iterator &operator++() {
+			++pos;
+			return *this;
+		}
+		inline iterator operator++(int) {
+			iterator tmp = *this;
+			++pos;
+			return tmp;
+		}
+
+		inline uint32_t idx() const { return c->dense_idx_[pos]; }
+
+	private:
+		packed_vector_list<T> *c;
+		uint32_t pos;
+	};
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, uint32_t(values_.size())); }
+
+	struct const_iterator {
+	public:
+		inline const_iterator(const packed_vector_list<T> *c_, uint32_t pos_) : c(c_), pos(pos_) {}
+
+		inline const T &operator*() const { return c->values_[pos]; }
+		inline const T *operator->() const { return &c->values_[pos]; }
+
+		inline bool operator==(const const_iterator &i_) const { return pos == i_.pos; }
+		inline bool operator!=(const const_iterator &i_) const { return pos != i_.pos; }
+		inline void operator++() { ++pos; }
+
+		inline uint32_t idx() const { return c->dense_idx_[pos]; }
+
+	private:
+		const packed_vector_list<T> *c;
+		uint32_t pos;
+	};
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, uint32_t(values_.size())); }
+
+	//
+	uint32_t add(const T &v) {
+		if (free_.empty())
+			reserve(sparse_.size() * 2 + 16);
+
+		const uint32_t i = free_.back();
+		free_.pop_back();
+
+		values_.push_back(v);
+		dense_idx_.push_back(i);
+		sparse_[i] = uint32_t(values_.size() - 1);
+		return i;
+	}
+
+#if __cplusplus >= 201103L
+	uint32_t add(T &&v) {
+		if (free_.empty())
+			reserve(sparse_.size() * 2 + 16);
+
+		const uint32_t i = free_.back();
+		free_.pop_back();
+
+		values_.push_back(std::move(v));
+		dense_idx_.push_back(i);
+		sparse_[i] = uint32_t(values_.size() - 1);
+		return i;
+	}
+#endif
+
+	uint32_t remove(uint32_t i) {
+		const uint32_t pos = sparse_[i];
+		erase(i);
+		return pos < dense_idx_.size() ? dense_idx_[pos] : invalid_idx; // last entry moved in place of the removed one
+	}
+
+	void erase(uint32_t i) {
+		__ASSERT__(is_used(i)); // assert entry is in use
+
+		const uint32_t pos = sparse_[i], last = uint32_t(values_.size() - 1);
+
+		if (pos != last) {
+#if __cplusplus >= 201103L
+			values_[pos] = std::move(values_[last]);
+#else
+			values_[pos] = values_[last];
+#endif
+			dense_idx_[pos] = dense_idx_[last];
+			sparse_[dense_idx_[pos]] = pos;
+		}
+
+		values_.pop_back();
+		dense_idx_.pop_back();
+
+		sparse_[i] = invalid_idx;
+		free_.push_back(i);
+	}
+
+	void compact() {
+		std::vector<T>(values_).swap(values_);
+		std::vector<uint32_t>(dense_idx_).swap(dense_idx_);
+	}
+
+private:
+	friend class iterator;
+	friend struct const_iterator;
+
+	std::vector<T> values_; // entries in use, densely packed
+	std::vector<uint32_t> dense_idx_; // index of each packed entry
+	std::vector<uint32_t> sparse_; // index to packed entry position
+	std::vector<uint32_t> free_; // free indexes stack
+};
+
+} // namespace hg
@@ -3,6 +3,7 @@
 #include "foundation/profiler.h"
 #include "foundation/log.h"
 #include "foundation/math.h"
+#include "foundation/thread.h"
 
 #include <algorithm>
 #include <fmt/format.h>
@@ -32,6 +33,8 @@ static std::vector<Section> sections;
 static uint32_t frame = 0;
 static ProfilerFrame last_frame_profile;
 
+static Mutex profiler_lock; // sections can be opened from worker threads
+
 //
 static size_t GetTaskBucket(const std::string &name) { return XXH32(name.data(), name.length(), 0) & 255; }
 
@@ -68,7 +71,7 @@ static bool _compare_tree_entry(const ProfilerFrame::Task &a, const ProfilerFram
 	return task_a_name_length < task_b_name_length;
 }
 
-ProfilerFrame CaptureProfilerFrame() {
+static ProfilerFrame CaptureProfilerFrame_() {
 	ProfilerFrame f;
 	f.frame = frame;
 
@@ -125,9 +128,16 @@ ProfilerFrame CaptureProfilerFrame() {
 	return f;
 }
 
+ProfilerFrame CaptureProfilerFrame() {
+	ScopedLock lock(profiler_lock);
+	return CaptureProfilerFrame_();
+}
+
 //
 ProfilerFrame EndProfilerFrame() {
-	ProfilerFrame profiler_frame = CaptureProfilerFrame();
+	ScopedLock lock(profiler_lock);
+
+	ProfilerFrame profiler_frame = CaptureProfilerFrame_();
 
 	for (size_t i = 0; i < task_bucket_count; ++i)
 		task_buckets[i].clear();
@@ -187,6 +197,8 @@ void PrintProfilerFrame(const ProfilerFrame &frame) {
 
 //
 ProfilerSectionIndex BeginProfilerSection(const std::string &name, const std::string &section_details) {
+	ScopedLock lock(profiler_lock);
+
 	const size_t bucket_idx = GetTaskBucket(name);
 	const size_t task_idx = GetTaskInBucket(bucket_idx, name);
 	Task &task = tasks[task_idx];
@@ -203,6 +215,8 @@ ProfilerSectionIndex BeginProfilerSection(const std::string &name, const std::st
 }
 
 void EndProfilerSection(ProfilerSectionIndex section_index) {
+	ScopedLock lock(profiler_lock);
+
 	if (section_index < sections.size() && sections[section_index].start != 0)
 		sections[section_index].end = time_now();
 }
@@ -14,9 +14,6 @@ struct ProfilerFrame {
 
 	struct Section {
 		Section() : start(0), end(0) {}
-#if __cpluplus >= 201103L
-		Section(Section &&s) : thread_id(s.thread_id), start(s.start), end(s.end), details(std::move(s.details)) {}
-#endif
 
 		time_ns start, end;
 		std::string details;
@@ -37,7 +34,7 @@ struct ProfilerFrame {
 //
 typedef size_t ProfilerSectionIndex;
 
-/// Begin a named profiler section. Call EndProfilerSection to end the section.
+/// Begin a named profiler section. Call EndProfilerSection to end the section. Sections can be opened from any thread.
 ProfilerSectionIndex BeginProfilerSection(const std::string &name, const std::string &section_details = std::string());
 void EndProfilerSection(ProfilerSectionIndex section_index);
 
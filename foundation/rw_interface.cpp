@@ -36,6 +36,16 @@ bool Write(const Writer &i, const Handle &h, const std::string &v) {
 	return Write(i, h, size) && i.write(h, v.data(), size) == size;
 }
 
+bool Read(const Reader &i, const Handle &h, atom &v) {
+	std::string s;
+	if (!Read(i, h, s))
+		return false;
+	v = s;
+	return true;
+}
+
+bool Write(const Writer &i, const Handle &h, const atom &v) { return Write(i, h, v.str()); }
+
 //
 bool SkipString(const Reader &i, const Handle &h) {
 	uint16_t size;
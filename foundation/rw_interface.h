@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "foundation/assert.h"
+#include "foundation/atom.h"
 #include "foundation/seek_mode.h"
 
 #include <cassert>
@@ -84,6 +85,9 @@ template <typename T> bool Skip(const Reader &i, const Handle &h) { return Seek(
 bool Read(const Reader &i, const Handle &h, std::string &v);
 bool Write(const Writer &i, const Handle &h, const std::string &v);
 
+bool Read(const Reader &i, const Handle &h, atom &v);
+bool Write(const Writer &i, const Handle &h, const atom &v);
+
 //
 size_t Tell(const Reader &i, const Handle &h);
 size_t Tell(const Writer &i, const Handle &h);
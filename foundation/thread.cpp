@@ -0,0 +1,147 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include "foundation/thread.h"
+#include "foundation/assert.h"
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace hg {
+
+#if _WIN32
+int32_t AtomicAdd(volatile int32_t &v, int32_t d) { return int32_t(InterlockedExchangeAdd(reinterpret_cast<volatile LONG *>(&v), LONG(d))) + d; }
+int32_t AtomicLoad(volatile int32_t &v) { return int32_t(InterlockedCompareExchange(reinterpret_cast<volatile LONG *>(&v), 0, 0)); }
+bool AtomicCompareExchange(volatile int32_t &v, int32_t expected, int32_t desired) {
+	return InterlockedCompareExchange(reinterpret_cast<volatile LONG *>(&v), LONG(desired), LONG(expected)) == LONG(expected);
+}
+
+//
+Mutex::Mutex() : m(new CRITICAL_SECTION) { InitializeCriticalSection(reinterpret_cast<CRITICAL_SECTION *>(m)); }
+Mutex::~Mutex() {
+	DeleteCriticalSection(reinterpret_cast<CRITICAL_SECTION *>(m));
+	delete reinterpret_cast<CRITICAL_SECTION *>(m);
+}
+
+void Mutex::lock() { EnterCriticalSection(reinterpret_cast<CRITICAL_SECTION *>(m)); }
+bool Mutex::try_lock() { return TryEnterCriticalSection(reinterpret_cast<CRITICAL_SECTION *>(m)) != FALSE; }
+void Mutex::unlock() { LeaveCriticalSection(reinterpret_cast<CRITICAL_SECTION *>(m)); }
+
+//
+ConditionVariable::ConditionVariable() : c(new CONDITION_VARIABLE) { InitializeConditionVariable(reinterpret_cast<CONDITION_VARIABLE *>(c)); }
+ConditionVariable::~ConditionVariable() { delete reinterpret_cast<CONDITION_VARIABLE *>(c); }
+
+void ConditionVariable::wait(Mutex &m) { SleepConditionVariableCS(reinterpret_cast<CONDITION_VARIABLE *>(c), reinterpret_cast<CRITICAL_SECTION *>(m.m), INFINITE); }
+void ConditionVariable::notify_one() { WakeConditionVariable(reinterpret_cast<CONDITION_VARIABLE *>(c)); }
+void ConditionVariable::notify_all() { WakeAllConditionVariable(reinterpret_cast<CONDITION_VARIABLE *>(c)); }
+
+//
+unsigned long __stdcall Thread::entry(void *self) {
+	Thread *t = reinterpret_cast<Thread *>(self);
+	t->func(t->user);
+	return 0;
+}
+
+bool Thread::start(void (*func_)(void *), void *user_) {
+	__ASSERT__(!h);
+
+	func = func_;
+	user = user_;
+	h = CreateThread(NULL, 0, entry, this, 0, NULL);
+	return h != 0;
+}
+
+void Thread::join() {
+	if (!h)
+		return;
+
+	WaitForSingleObject(h, INFINITE);
+	CloseHandle(h);
+	h = 0;
+}
+
+void ThreadYield() { SwitchToThread(); }
+
+size_t GetHardwareThreadCount() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? size_t(info.dwNumberOfProcessors) : 1;
+}
+#else
+int32_t AtomicAdd(volatile int32_t &v, int32_t d) { return __sync_add_and_fetch(&v, d); }
+int32_t AtomicLoad(volatile int32_t &v) { return __sync_add_and_fetch(&v, 0); }
+bool AtomicCompareExchange(volatile int32_t &v, int32_t expected, int32_t desired) { return __sync_bool_compare_and_swap(&v, expected, desired); }
+
+//
+Mutex::Mutex() : m(new pthread_mutex_t) { pthread_mutex_init(reinterpret_cast<pthread_mutex_t *>(m), NULL); }
+Mutex::~Mutex() {
+	pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t *>(m));
+	delete reinterpret_cast<pthread_mutex_t *>(m);
+}
+
+void Mutex::lock() { pthread_mutex_lock(reinterpret_cast<pthread_mutex_t *>(m)); }
+bool Mutex::try_lock() { return pthread_mutex_trylock(reinterpret_cast<pthread_mutex_t *>(m)) == 0; }
+void Mutex::unlock() { pthread_mutex_unlock(reinterpret_cast<pthread_mutex_t *>(m)); }
+
+//
+ConditionVariable::ConditionVariable() : c(new pthread_cond_t) { pthread_cond_init(reinterpret_cast<pthread_cond_t *>(c), NULL); }
+ConditionVariable::~ConditionVariable() {
+	pthread_cond_destroy(reinterpret_cast<pthread_cond_t *>(c));
+	delete reinterpret_cast<pthread_cond_t *>(c);
+}
+
+void ConditionVariable::wait(Mutex &m) { pthread_cond_wait(reinterpret_cast<pthread_cond_t *>(c), reinterpret_cast<pthread_mutex_t *>(m.m)); }
+void ConditionVariable::notify_one() { pthread_cond_signal(reinterpret_cast<pthread_cond_t *>(c)); }
+void ConditionVariable::notify_all() { pthread_cond_broadcast(reinterpret_cast<pthread_cond_t *>(c)); }
+
+//
+void *Thread::entry(void *self) {
+	Thread *t = reinterpret_cast<Thread *>(self);
+	t->func(t->user);
+	return NULL;
+}
+
+bool Thread::start(void (*func_)(void *), void *user_) {
+	__ASSERT__(!h);
+
+	func = func_;
+	user = user_;
+
+	pthread_t *t = new pthread_t;
+	if (pthread_create(t, NULL, entry, this) != 0) {
+		delete t;
+		return false;
+	}
+
+	h = t;
+	return true;
+}
+
+void Thread::join() {
+	if (!h)
+		return;
+
+	pthread_t *t = reinterpret_cast<pthread_t *>(h);
+	pthread_join(*t, NULL);
+	delete t;
+	h = 0;
+}
+
+void ThreadYield() { sched_yield(); }
+
+size_t GetHardwareThreadCount() {
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? size_t(count) : 1;
+}
+#endif
+
+//
+Thread::Thread() : h(0), func(0), user(0) {}
+Thread::~Thread() { join(); }
+
+} // namespace hg
@@ -0,0 +1,104 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if _MSC_VER
+#define HG_THREAD_LOCAL __declspec(thread)
+#else
+#define HG_THREAD_LOCAL __thread
+#endif
+
+namespace hg {
+
+/// Atomically add to a value and return the new value, acts as a full memory barrier.
+int32_t AtomicAdd(volatile int32_t &v, int32_t d);
+/// Atomically load a value, acts as a full memory barrier.
+int32_t AtomicLoad(volatile int32_t &v);
+/// Atomically replace a value if it is equal to expected, return true on success.
+bool AtomicCompareExchange(volatile int32_t &v, int32_t expected, int32_t desired);
+
+//
+class Mutex {
+public:
+	Mutex();
+	~Mutex();
+
+	void lock();
+	bool try_lock();
+	void unlock();
+
+private:
+	friend class ConditionVariable;
+	void *m;
+
+	Mutex(const Mutex &);
+	Mutex &operator=(const Mutex &);
+};
+
+class ScopedLock {
+public:
+	explicit ScopedLock(Mutex &m_) : m(m_) { m.lock(); }
+	~ScopedLock() { m.unlock(); }
+
+private:
+	Mutex &m;
+
+	ScopedLock(const ScopedLock &);
+	ScopedLock &operator=(const ScopedLock &);
+};
+
+class ConditionVariable {
+public:
+	ConditionVariable();
+	~ConditionVariable();
+
+	/// Atomically release the mutex and wait, the mutex is locked again when returning. Spurious wake-ups are possible.
+	void wait(Mutex &m);
+	void notify_one();
+	void notify_all();
+
+private:
+	void *c;
+
+	ConditionVariable(const ConditionVariable &);
+	ConditionVariable &operator=(const ConditionVariable &);
+};
+
+//
+class Thread {
+public:
+	Thread();
+	~Thread(); // joins the thread if it is running
+
+	/// Start running a function on a new thread, return false if the thread could not be created.
+	bool start(void (*func)(void *user), void *user);
+	void join();
+
+	bool is_running() const { return h != 0; }
+
+private:
+	void *h;
+
+	void (*func)(void *);
+	void *user;
+
+#if _WIN32
+	static unsigned long __stdcall entry(void *self);
+#else
+	static void *entry(void *self);
+#endif
+
+	Thread(const Thread &);
+	Thread &operator=(const Thread &);
+};
+
+/// Yield the remainder of the calling thread time slice.
+void ThreadYield();
+
+/// Return the number of hardware threads, at least 1.
+size_t GetHardwareThreadCount();
+
+} // namespace hg
@@ -2,8 +2,14 @@
 
 #pragma once
 
+#include "foundation/allocator.h"
+#include "foundation/assert.h"
+#include "foundation/cext.h"
+
 #include <cstring>
 #include <iterator>
+#include <new>
+#include <utility>
 #include <vector>
 
 namespace hg {
@@ -12,15 +18,18 @@ namespace hg {
 	vector_list (for lack of a better name)
 
 	- A container of T with linear lookup/add/remove by key.
-	- Store less than 16000000 entries.
+	- Store less than 2^31 entries.
 	- Automatically recycle indexes.
-	- Can defragment storage.
+	- Entries are stored in fixed size chunks and never move in memory.
 	- Fast iteration.
 
-	Memory usage: size() * sizeof(T) + highest index * sizeof(uint32_t) + k
+	Memory usage: allocated chunks * chunk_size * sizeof(T) + highest index * (sizeof(uint32_t) + sizeof(uint8_t)) + k
+
+	Growing the container allocates new chunks, existing entries are neither
+	copied nor moved and pointers to them stay valid until they are removed.
 
-	compact() deals with storage fragmentation issues and should be called when
-	storage() is vastly superior to size() (2-3x larger).
+	compact() releases the chunks holding no entry in use and should be called
+	when capacity() is vastly superior to size() (2-3x larger).
 
 	shrink() shrink the index table to the minimum size possible.
 */
@@ -28,20 +37,58 @@ template <typename T> class vector_list {
 public:
 	static const uint32_t invalid_idx = 0xffffffff;
 
-	vector_list() : storage_capacity_(0), storage_(nullptr), idx_(), size_(0), free_(0) {}
-	explicit vector_list(size_t count) : storage_capacity_(0), storage_(nullptr), idx_(), size_(0), free_(0) { reserve(count); }
+	static const uint32_t chunk_shift = 8;
+	static const uint32_t chunk_size = 1 << chunk_shift; // entries per chunk
+
+	vector_list() : idx_(), size_(0), free_(0), tag_(MT_Containers) {}
+	explicit vector_list(size_t count) : idx_(), size_(0), free_(0), tag_(MT_Containers) { reserve(count); }
+
+	vector_list(const vector_list<T> &v) : idx_(), size_(0), free_(0), tag_(v.tag_) { *this = v; }
+	~vector_list() { clear(); }
+
+#if __cplusplus >= 201103L
+	vector_list(vector_list<T> &&v) : idx_(), size_(0), free_(0), tag_(v.tag_) { swap_(v); }
+
+	vector_list<T> &operator=(vector_list<T> &&v) {
+		if (&v != this) {
+			clear();
+			swap_(v); // chunks are handed over, entries are neither copied nor moved
+		}
+		return *this;
+	}
+#endif
+
+	vector_list<T> &operator=(const vector_list<T> &v) {
+		if (&v != this) {
+			clear();
+
+			for (uint32_t i = v.first(); i != invalid_idx; i = v.next(i))
+				new (acquire_slot_(i)) T(v[i]);
+
+			idx_ = v.idx_;
+			skip_ = v.skip_;
+			size_ = v.size_;
+			free_ = v.free_;
+		}
+		return *this;
+	}
+
+	/// Set the memory tag chunks are accounted to, must be set before any entry is added.
+	void set_memory_tag(MemoryTag tag) {
+		__ASSERT__(chunks_.empty());
+		tag_ = tag;
+	}
+	MemoryTag get_memory_tag() const { return tag_; }
 
 	//
 	void reserve(size_t count) {
-		__ASSERT__(count < 0x00ffffff);
+		__ASSERT__(count < max_entries);
 		const uint32_t capacity_ = uint32_t(idx_.size());
 
 		if (count > capacity_) {
-			reserve_storage_(count);
-
-			idx_.resize(count);
-			for (uint32_t i = capacity_; i < count; ++i)
-				idx_[i] = make_free_idx(i + 1, 1);
+			grow_(count);
+			for (size_t c = capacity_ >> chunk_shift; c <= ((count - 1) >> chunk_shift); ++c)
+				acquire_slot_(uint32_t(c << chunk_shift));
 		}
 	}
 
@@ -50,33 +97,33 @@ public:
 
 	void clear() {
 		for (uint32_t i = first(); i != invalid_idx; i = next(i))
-			reinterpret_cast<T *>(storage_)[i].~T();
+			slot_(i)->~T();
 
-		free(storage_);
-		storage_ = nullptr;
-		storage_capacity_ = 0;
+		for (size_t i = 0; i < chunks_.size(); ++i)
+			Deallocate(chunks_[i], sizeof(T) * chunk_size, tag_);
+		chunks_.clear();
 
 		idx_.clear();
+		skip_.clear();
 
 		size_ = 0;
 		free_ = 0;
 	}
 
 	//
-	T &operator[](size_t i) { return reinterpret_cast<T *>(storage_)[idx_[i]]; }
-	const T &operator[](size_t i) const { return reinterpret_cast<const T *>(storage_)[idx_[i]]; }
+	T &operator[](size_t i) { return *slot_(uint32_t(i)); }
+	const T &operator[](size_t i) const { return *slot_(uint32_t(i)); }
 
-	T &value(size_t i) { return reinterpret_cast<T *>(storage_)[idx_[i]]; }
-	const T &value(size_t i) const { return reinterpret_cast<const T *>(storage_)[idx_[i]]; }
+	T &value(size_t i) { return *slot_(uint32_t(i)); }
+	const T &value(size_t i) const { return *slot_(uint32_t(i)); }
 
 	//
 	uint32_t first() const {
 		const size_t idx_count = idx_.size();
 		for (uint32_t i = 0; i < idx_count;) {
-			const uint32_t idx = idx_[i];
-			if (!is_free_idx(idx))
+			if (!is_free_idx(idx_[i]))
 				return i;
-			i += get_free_skip(idx);
+			i += skip_[i];
 		}
 		return invalid_idx;
 	}
@@ -85,10 +132,9 @@ public:
 		const size_t idx_count = idx_.size();
 		++from;
 		while (from < idx_count) {
-			const uint32_t idx = idx_[from];
-			if (!is_free_idx(idx))
+			if (!is_free_idx(idx_[from]))
 				return from;
-			from += get_free_skip(idx);
+			from += skip_[from];
 		}
 		return invalid_idx;
 	}
@@ -149,17 +195,17 @@ public:
 
 	//
 	uint32_t add(const T &v) {
-		__ASSERT__(size_ < 0x00ffffff);
+		__ASSERT__(size_ < max_entries);
 		const size_t capacity_ = capacity();
 
 		if (size_ == capacity_)
-			reserve(capacity_ * 2 + 16);
+			grow_(capacity_ * 2 + 16);
 
 		const uint32_t i = free_;
-		free_ = get_free_idx(idx_[free_]);
+		new (acquire_slot_(i)) T(v); // emplace_back, entries never move so v might be an entry of this container
 
+		free_ = get_free_idx(idx_[i]);
 		idx_[i] = i;
-		new (reinterpret_cast<T *>(storage_) + i) T(v); // emplace_back
 
 		backward_fix_free_skip(i, 0);
 
@@ -167,19 +213,19 @@ public:
 		return i;
 	}
 
-#if __cpluplus >= 201103L
+#if __cplusplus >= 201103L
 	uint32_t add(T &&v) {
-		__ASSERT__(size_ < 0x00ffffff);
+		__ASSERT__(size_ < max_entries);
 		const size_t capacity_ = capacity();
 
 		if (size_ == capacity_)
-			reserve(capacity_ * 2 + 16);
+			grow_(capacity_ * 2 + 16);
 
 		const uint32_t i = free_;
-		free_ = get_free_idx(idx_[free_]);
+		new (acquire_slot_(i)) T(std::move(v)); // emplace_back
 
+		free_ = get_free_idx(idx_[i]);
 		idx_[i] = i;
-		new (reinterpret_cast<T *>(storage_) + i) T(std::forward<T>(v)); // emplace_back
 
 		backward_fix_free_skip(i, 0);
 
@@ -190,60 +236,42 @@ public:
 
 	uint32_t remove(uint32_t i) {
 		const uint32_t n = next(i); // next entry in use
+		erase(i);
+		return n;
+	}
 
-		{
-			const uint32_t idx = idx_[i];
-			__ASSERT__(!is_free_idx(idx)); // assert entry is in use
-			reinterpret_cast<T *>(storage_)[idx].~T(); // destroy object
-		}
+	// same as remove() without looking up the next entry in use, which can be costly in long free runs
+	void erase(uint32_t i) {
+		__ASSERT__(!is_free_idx(idx_[i])); // assert entry is in use
+		slot_(i)->~T(); // destroy object
 
 		uint32_t free_skip = 1;
-		if ((i + 1) < idx_.size()) {
-			const uint32_t idx = idx_[i + 1];
-			if (is_free_idx(idx)) {
-				const uint32_t next_free_skip = get_free_skip(idx);
-				if (next_free_skip < 0x7f)
-					free_skip += next_free_skip;
-			}
-		}
+		if ((i + 1) < idx_.size())
+			if (is_free_idx(idx_[i + 1]) && skip_[i + 1] < max_free_skip)
+				free_skip += skip_[i + 1];
 
-		idx_[i] = make_free_idx(free_, free_skip); // store the free list node and the number of free indexes to skip while iterating
+		set_free_idx(i, free_, free_skip); // store the free list node and the number of free indexes to skip while iterating
 		free_ = i; // make this index the free list root
 
 		backward_fix_free_skip(i, free_skip); // updating all free skip values leading to this new free entry
 
 		--size_;
-
-		return n;
 	}
 
-	//
+	// release chunks holding no entry in use, they are allocated again when an entry is added to them
 	void compact() {
-		const size_t adjusted_storage_size = get_storage_adjusted_reserve(size_);
-		void *new_storage = malloc(sizeof(T) * adjusted_storage_size);
+		for (size_t c = 0; c < chunks_.size(); ++c) {
+			if (!chunks_[c])
+				continue;
 
-		const size_t idx_count = idx_.size();
+			const uint32_t chunk_start = uint32_t(c << chunk_shift), chunk_end = chunk_start + chunk_size;
 
-		size_t c = 0;
-		for (size_t i = 0; i < idx_count;) {
-			const uint32_t idx = idx_[i];
-			if (!is_free_idx(idx)) {
-				idx_[i] = c;
-#if __cplusplus >= 201103L
-				reinterpret_cast<T *>(new_storage)[c] = std::move(reinterpret_cast<T *>(storage_)[idx]);
-#else
-				reinterpret_cast<T *>(new_storage)[c] = reinterpret_cast<T *>(storage_)[idx];
-#endif
-				++c;
-				++i;
-			} else {
-				i += get_free_skip(idx);
+			const uint32_t i = chunk_start == 0 ? first() : next(chunk_start - 1);
+			if (i == invalid_idx || i >= chunk_end) {
+				Deallocate(chunks_[c], sizeof(T) * chunk_size, tag_);
+				chunks_[c] = nullptr;
 			}
 		}
-
-		free(storage_);
-		storage_capacity_ = adjusted_storage_size;
-		storage_ = new_storage;
 	}
 
 	// [todo]
@@ -258,89 +286,74 @@ public:
 #endif
 
 private:
-	size_t storage_capacity_; //, storage_size_;
-	void *storage_;
+	static const uint32_t max_entries = 0x7fffffff;
+	static const uint32_t max_free_skip = 0xff;
 
-#if __cplusplus >= 201103L
-	template <typename U = T>
-	inline typename std::enable_if<std::is_trivially_copyable<U>::value, void>::type transfer_storage(U *new_storage, const size_t new_storage_size) {
-#ifdef __STDC_LIB_EXT1__
-		memcpy_s(new_storage, new_storage_size, storage_, sizeof(U) * storage_capacity_);
-#else
-		memcpy(new_storage, storage_, sizeof(U) * storage_capacity_); // flawfinder: ignore
-#endif
-	}
+	std::vector<void *> chunks_;
 
-	template <typename U = T>
-	inline typename std::enable_if<(!std::is_trivially_copyable<U>::value) && std::is_move_constructible<U>::value, void>::type transfer_storage(
-		U *new_storage, const size_t new_storage_size) {
-		for (auto i = first(); i != invalid_idx; i = next(i)) {
-			U *dst = reinterpret_cast<U *>(new_storage) + i;
-			U *src = reinterpret_cast<U *>(storage_) + i;
-			new (dst) T(std::move(*src));
-		}
-	}
+	std::vector<uint32_t> idx_;
+	std::vector<uint8_t> skip_; // number of free indexes to skip while iterating, only meaningful for free indexes
 
-	template <typename U = T>
-	inline typename std::enable_if<(!std::is_trivially_copyable<U>::value) && (!std::is_move_constructible<U>::value), void>::type transfer_storage(
-		U *new_storage, const size_t new_storage_size) {
-		for (auto i = first(); i != invalid_idx; i = next(i)) {
-			U *dst = reinterpret_cast<U *>(new_storage) + i;
-			U *src = reinterpret_cast<U *>(storage_) + i;
-			new (dst) U(*src);
-		}
-	}
-#else
-	template <typename U> inline void transfer_storage(U *new_storage, const size_t new_storage_size) {
-		for (uint32_t i = first(); i != invalid_idx; i = next(i)) {
-			U *dst = reinterpret_cast<U *>(new_storage) + i;
-			U *src = reinterpret_cast<U *>(storage_) + i;
-			new (dst) U(*src);
-		}
+	size_t size_;
+	uint32_t free_;
+
+	MemoryTag tag_;
+
+	void swap_(vector_list<T> &v) {
+		chunks_.swap(v.chunks_);
+		idx_.swap(v.idx_);
+		skip_.swap(v.skip_);
+		std::swap(size_, v.size_);
+		std::swap(free_, v.free_);
+		std::swap(tag_, v.tag_); // chunks are accounted to the tag they were allocated with
 	}
-#endif // __cplusplus >= 201103L
-
-	void reserve_storage_(size_t capacity) {
-		if (capacity > storage_capacity_) {
-			void *new_storage_ = malloc(sizeof(T) * capacity);
-			transfer_storage((T *)new_storage_, sizeof(T) * capacity);
-			for (uint32_t i = first(); i != invalid_idx; i = next(i))
-				reinterpret_cast<T *>(storage_)[i].~T();
-			free(storage_);
-			storage_ = new_storage_;
-			storage_capacity_ = capacity;
-		}
+
+	inline T *slot_(uint32_t i) const { return reinterpret_cast<T *>(chunks_[i >> chunk_shift]) + (i & (chunk_size - 1)); }
+
+	T *acquire_slot_(uint32_t i) {
+		const size_t c = i >> chunk_shift;
+		if (c >= chunks_.size())
+			chunks_.resize(c + 1, nullptr);
+		if (!chunks_[c])
+			chunks_[c] = Allocate(sizeof(T) * chunk_size, tag_);
+		return slot_(i);
 	}
 
-	std::vector<uint32_t> idx_;
+	void grow_(size_t count) {
+		__ASSERT__(count < max_entries);
+		const uint32_t capacity_ = uint32_t(idx_.size());
 
-	size_t size_;
-	uint32_t free_;
+		idx_.resize(count);
+		skip_.resize(count);
 
-	static size_t get_storage_adjusted_reserve(size_t size) { return size + size / 8; }
+		for (uint32_t i = capacity_; i < count; ++i) {
+			const uint32_t free_skip = uint32_t(count) - i; // skip to the end of the new free run
+			set_free_idx(i, i + 1, free_skip < max_free_skip ? free_skip : max_free_skip);
+		}
+	}
 
 	static bool is_free_idx(uint32_t idx) { return idx & 0x80000000; }
-	static uint32_t make_free_idx(uint32_t free_idx, uint32_t free_skip) {
-		__ASSERT__(free_idx < 0x00ffffff);
-		__ASSERT__(free_skip < 128);
-		return 0x80000000 | ((free_skip & 0x7f) << 24) | (free_idx & 0x00ffffff);
+	static uint32_t get_free_idx(uint32_t idx) { return idx & 0x7fffffff; }
+
+	void set_free_idx(uint32_t i, uint32_t free_idx, uint32_t free_skip) {
+		__ASSERT__(free_idx <= max_entries);
+		__ASSERT__(free_skip <= max_free_skip);
+		idx_[i] = 0x80000000 | free_idx;
+		skip_[i] = uint8_t(free_skip);
 	}
-	static uint32_t get_free_skip(uint32_t idx) { return (idx >> 24) & 0x7f; }
-	static uint32_t get_free_idx(uint32_t idx) { return idx & 0x00ffffff; }
 
 	void backward_fix_free_skip(uint32_t i, uint32_t free_skip) { // fix free_skip chain leading to this entry (costly backward memory access...)
 		// TODO EJ move backward one cache line then process forward
 		while (i > 0) {
 			--i;
-			const uint32_t idx = idx_[i];
-			if (!is_free_idx(idx))
+			if (!is_free_idx(idx_[i]))
 				break;
 
 			++free_skip;
-			if (free_skip > 0x7f)
-				free_skip = 1;
+			if (free_skip > max_free_skip)
+				break; // free skip values further back cannot reach this entry and are left untouched, keeps removal O(1) in long free runs
 
-			idx_[i] = make_free_idx(get_free_idx(idx), free_skip);
+			skip_[i] = uint8_t(free_skip);
 		}
 	}
 };
@@ -968,4 +968,13 @@ void test_anim() {
 
 	DeleteEmptyAnimTracks(anim);
 	TEST_CHECK(anim.bool_tracks.size() == 1);
+
+#if __cplusplus >= 201103L
+	const AnimTrackT<bool>::Key *key = &anim.bool_tracks[0].keys[0];
+
+	Anim moved(std::move(anim)); // tracks and keys are handed over, not copied
+	TEST_CHECK(anim.bool_tracks.empty());
+	TEST_CHECK(&moved.bool_tracks[0].keys[0] == key);
+	TEST_CHECK(moved.t_end == time_from_ms(1200));
+#endif
 }
@@ -0,0 +1,164 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "engine/asset_pack.h"
+
+#include "foundation/file.h"
+
+#include "../utils.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+
+using namespace hg;
+
+static AssetPackInput MakeInput(const std::string &name, const std::string &content, AssetPackCompression compression, uint32_t alignment) {
+	AssetPackInput input;
+	input.name = name;
+	input.path = hg::test::CreateTempFilepath();
+	input.compression = compression;
+	input.alignment = alignment;
+	StringToFile(input.path, content);
+	return input;
+}
+
+static std::string EntryContent(const AssetPack &pack, const AssetPackEntry &entry) {
+	Data data;
+	if (!ReadAssetPackEntry(pack, entry, data))
+		return "<error>";
+	return std::string(reinterpret_cast<const char *>(data.GetData()), data.GetSize());
+}
+
+void test_asset_pack() {
+	std::string random(4096, 0);
+	for (size_t i = 0; i < random.size(); ++i)
+		random[i] = char((i * 2654435761u) >> 13);
+
+	std::vector<AssetPackInput> inputs;
+	inputs.push_back(MakeInput("textures/a.bin", random, APC_None, 4096));
+	inputs.push_back(MakeInput("lorem.txt", hg::test::LoremIpsum, APC_Deflate, 16));
+	inputs.push_back(MakeInput("small.txt", "abc", APC_Deflate, 1)); // does not compress, stored
+	inputs.push_back(MakeInput("empty.txt", "", APC_Deflate, 64));
+	inputs.push_back(MakeInput("models/b.bin", random + random, APC_None, 256));
+
+	const std::string path = hg::test::CreateTempFilepath();
+	TEST_CHECK(WriteAssetPack(path, inputs));
+	TEST_CHECK(IsAssetPack(path));
+
+	{
+		AssetPack pack;
+		TEST_ASSERT(OpenAssetPack(path, pack));
+		TEST_CHECK(pack.entry_count == inputs.size());
+
+		for (uint32_t i = 1; i < pack.entry_count; ++i)
+			TEST_CHECK(pack.entries[i - 1].hash <= pack.entries[i].hash); // sorted TOC
+
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			const AssetPackEntry *entry = FindAssetPackEntry(pack, inputs[i].name);
+			TEST_ASSERT(entry != nullptr);
+			TEST_CHECK(GetAssetPackEntryName(pack, *entry) == inputs[i].name);
+			TEST_CHECK(entry->offset % inputs[i].alignment == 0);
+			TEST_CHECK((reinterpret_cast<uintptr_t>(GetAssetPackEntryData(pack, *entry)) & (inputs[i].alignment - 1)) == 0);
+			TEST_CHECK(EntryContent(pack, *entry) == FileToString(inputs[i].path));
+		}
+
+		// stored entries are usable in place
+		const AssetPackEntry *a = FindAssetPackEntry(pack, "textures/a.bin");
+		TEST_CHECK(a->compression == APC_None);
+		TEST_CHECK(a->size == random.size());
+		TEST_CHECK(memcmp(GetAssetPackEntryData(pack, *a), random.data(), random.size()) == 0);
+
+		const AssetPackEntry *lorem = FindAssetPackEntry(pack, "lorem.txt");
+		TEST_CHECK(lorem->compression == APC_Deflate);
+		TEST_CHECK(lorem->size < lorem->uncompressed_size);
+		TEST_CHECK(FindAssetPackEntry(pack, "small.txt")->compression == APC_None);
+		TEST_CHECK(FindAssetPackEntry(pack, "empty.txt")->uncompressed_size == 0);
+
+		TEST_CHECK(FindAssetPackEntry(pack, "missing.txt") == nullptr);
+		TEST_CHECK(FindAssetPackEntry(pack, "lorem.tx") == nullptr);
+
+		CloseAssetPack(pack);
+		TEST_CHECK(pack.entries == nullptr);
+	}
+
+	// rejected inputs
+	{
+		std::vector<AssetPackInput> duplicates(inputs.begin(), inputs.begin() + 2);
+		duplicates.push_back(inputs[0]);
+		TEST_CHECK(!WriteAssetPack(hg::test::CreateTempFilepath(), duplicates));
+
+		std::vector<AssetPackInput> bad_alignment(1, inputs[0]);
+		bad_alignment[0].alignment = 3;
+		TEST_CHECK(!WriteAssetPack(hg::test::CreateTempFilepath(), bad_alignment));
+
+		std::vector<AssetPackInput> large_alignment(1, inputs[0]);
+		large_alignment[0].alignment = 2 * AssetPackMaxAlignment; // beyond the alignment guaranteed by the mapping
+		TEST_CHECK(!WriteAssetPack(hg::test::CreateTempFilepath(), large_alignment));
+
+		std::vector<AssetPackInput> missing(1, inputs[0]);
+		missing[0].path = "missing.bin";
+		TEST_CHECK(!WriteAssetPack(hg::test::CreateTempFilepath(), missing));
+	}
+
+	// corrupted packs
+	{
+		AssetPack pack;
+
+		const std::string not_a_pack = hg::test::CreateTempFilepath();
+		StringToFile(not_a_pack, hg::test::LoremIpsum);
+		TEST_CHECK(!IsAssetPack(not_a_pack));
+		TEST_CHECK(!OpenAssetPack(not_a_pack, pack));
+		TEST_CHECK(!OpenAssetPack("missing.hgpack", pack));
+
+		const std::string content = FileToString(path);
+		const std::string truncated = hg::test::CreateTempFilepath();
+		StringToFile(truncated, content.substr(0, content.size() - 8));
+		TEST_CHECK(IsAssetPack(truncated));
+		TEST_CHECK(!OpenAssetPack(truncated, pack));
+
+		// lookups bisect the TOC, a pack whose entries are not sorted by hash is rejected
+		AssetPackHeader header;
+		memcpy(&header, content.data(), sizeof(header));
+
+		std::string unsorted = content;
+		char *toc = &unsorted[size_t(header.toc_offset)];
+		std::swap_ranges(toc, toc + sizeof(AssetPackEntry), toc + sizeof(AssetPackEntry));
+
+		const std::string unsorted_path = hg::test::CreateTempFilepath();
+		StringToFile(unsorted_path, unsorted);
+		TEST_CHECK(IsAssetPack(unsorted_path));
+		TEST_CHECK(!OpenAssetPack(unsorted_path, pack));
+
+		// payloads must be at the alignment recorded in their entry
+		AssetPackEntry entry;
+		memcpy(&entry, &content[size_t(header.toc_offset)], sizeof(entry));
+
+		const uint64_t misaligned_offset = sizeof(AssetPackHeader) + 1;
+		const uint8_t too_aligned = 13;
+
+		std::string misaligned = content, over_aligned = content;
+		memcpy(&misaligned[size_t(header.toc_offset) + offsetof(AssetPackEntry, offset)], &misaligned_offset, sizeof(misaligned_offset));
+		misaligned[size_t(header.toc_offset) + offsetof(AssetPackEntry, align_log2)] = 1;
+		over_aligned[size_t(header.toc_offset) + offsetof(AssetPackEntry, align_log2)] = char(too_aligned);
+
+		const std::string misaligned_path = hg::test::CreateTempFilepath(), over_aligned_path = hg::test::CreateTempFilepath();
+		StringToFile(misaligned_path, misaligned);
+		StringToFile(over_aligned_path, over_aligned);
+		TEST_CHECK(entry.size < header.toc_offset - misaligned_offset); // only the alignment is invalid
+		TEST_CHECK(!OpenAssetPack(misaligned_path, pack));
+		TEST_CHECK(!OpenAssetPack(over_aligned_path, pack));
+
+		Unlink(not_a_pack);
+		Unlink(truncated);
+		Unlink(unsorted_path);
+		Unlink(misaligned_path);
+		Unlink(over_aligned_path);
+	}
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+		Unlink(inputs[i].path);
+	Unlink(path);
+}
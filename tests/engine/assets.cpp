@@ -0,0 +1,382 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "engine/asset_pack.h"
+#include "engine/assets.h"
+
+#include "foundation/dir.h"
+#include "foundation/file.h"
+#include "foundation/path_tools.h"
+#include "foundation/thread.h"
+
+#include "../utils.h"
+
+#include <miniz.h>
+#include <string.h>
+
+#if !_WIN32
+#include <unistd.h>
+#endif
+
+using namespace hg;
+
+static bool CreatePackage(const std::string &path, const char *name, const std::string &content, mz_uint level = MZ_DEFAULT_COMPRESSION) {
+	mz_zip_archive zip;
+	mz_zip_zero_struct(&zip);
+
+	if (!mz_zip_writer_init_file(&zip, path.c_str(), 0))
+		return false;
+
+	const bool ok = mz_zip_writer_add_mem(&zip, name, content.data(), content.size(), level) && mz_zip_writer_finalize_archive(&zip);
+	mz_zip_writer_end(&zip);
+	return ok;
+}
+
+struct AssetStress {
+	std::string folder_content, package_content;
+	volatile int32_t failures;
+};
+
+static bool ReadAsset(const std::string &name, const std::string &expected) {
+	Asset asset = OpenAsset(name, true);
+	if (!IsValid(asset))
+		return false;
+
+	std::string content(GetSize(asset), 0);
+	const bool ok = content.size() == expected.size() && Read(asset, &content[0], content.size()) == content.size() && content == expected;
+	Close(asset);
+	return ok;
+}
+
+static void OpenReadCloseAssets(void *user) {
+	AssetStress &stress = *reinterpret_cast<AssetStress *>(user);
+
+	for (int i = 0; i < 200; ++i) {
+		if (!ReadAsset("folder.txt", stress.folder_content) || !ReadAsset("package.txt", stress.package_content))
+			AtomicAdd(stress.failures, 1);
+
+		// mounted and unmounted concurrently, must either fail cleanly or succeed
+		Asset asset = OpenAsset("transient.txt", true);
+		if (IsValid(asset)) {
+			std::string content(GetSize(asset), 0);
+			if (Read(asset, &content[0], content.size()) != content.size() || content != "transient")
+				AtomicAdd(stress.failures, 1);
+		}
+		Close(asset);
+	}
+}
+
+static std::string MakeEntryContent(size_t size) {
+	std::string content(size, 0);
+	for (size_t i = 0; i < size; ++i)
+		content[i] = char('a' + (i * 7 + i / 13) % 26);
+	return content;
+}
+
+static void CheckPackageEntry(const std::string &name, const std::string &content) {
+	Asset asset = OpenAsset(name);
+	TEST_ASSERT(IsValid(asset));
+	TEST_CHECK(GetSize(asset) == content.size());
+
+	// read in small chunks
+	{
+		std::string read;
+		char chunk[1000];
+		for (size_t count; (count = Read(asset, chunk, sizeof(chunk))) != 0;)
+			read.append(chunk, count);
+		TEST_CHECK(read == content);
+		TEST_CHECK(IsEOF(asset));
+		TEST_CHECK(Tell(asset) == content.size());
+	}
+
+	char c;
+
+	// seek modes, backward seeks restart inflated entries
+	TEST_CHECK(Seek(asset, 100, SM_Start));
+	TEST_CHECK(Tell(asset) == 100);
+	TEST_CHECK(Read(asset, &c, 1) == 1 && c == content[100]);
+
+	TEST_CHECK(Seek(asset, 1000, SM_Current));
+	TEST_CHECK(Tell(asset) == 1101);
+	TEST_CHECK(Read(asset, &c, 1) == 1 && c == content[1101]);
+
+	TEST_CHECK(Seek(asset, -10, SM_End));
+	TEST_CHECK(Tell(asset) == content.size() - 10);
+	TEST_CHECK(Read(asset, &c, 1) == 1 && c == content[content.size() - 10]);
+
+	TEST_CHECK(Seek(asset, -50, SM_Current));
+	TEST_CHECK(Read(asset, &c, 1) == 1 && c == content[content.size() - 59]);
+
+	TEST_CHECK(!Seek(asset, -1, SM_Start));
+	TEST_CHECK(!Seek(asset, 1, SM_End));
+	TEST_CHECK(Tell(asset) == content.size() - 58);
+
+	// partial read at the end of the entry
+	TEST_CHECK(Seek(asset, -4, SM_End));
+	char tail[16];
+	TEST_CHECK(Read(asset, tail, sizeof(tail)) == 4);
+	TEST_CHECK(std::string(tail, 4) == content.substr(content.size() - 4));
+	TEST_CHECK(Read(asset, tail, sizeof(tail)) == 0);
+
+	Close(asset);
+}
+
+static void test_package_entries() {
+	const std::string stored_package = hg::test::CreateTempFilepath(), deflated_package = hg::test::CreateTempFilepath();
+	const std::string content = MakeEntryContent(1024 * 1024 + 17);
+
+	TEST_CHECK(CreatePackage(stored_package, "stored.bin", content, MZ_NO_COMPRESSION));
+	TEST_CHECK(CreatePackage(deflated_package, "deflated.bin", content, MZ_BEST_COMPRESSION));
+
+	TEST_CHECK(AddAssetsPackage(stored_package));
+	TEST_CHECK(AddAssetsPackage(deflated_package));
+
+	CheckPackageEntry("stored.bin", content);
+	CheckPackageEntry("deflated.bin", content);
+
+	{
+		Asset stored = OpenAsset("stored.bin");
+		size_t size = 0;
+		const void *data = GetAssetData(stored, size);
+		TEST_CHECK(data != nullptr && size == content.size() && memcmp(data, content.data(), size) == 0);
+		Close(stored);
+	}
+
+	TEST_CHECK(AssetToString("deflated.bin").compare(0, content.size(), content) == 0);
+
+	{
+		// an open entry outlives its package being unmounted
+		Asset stored = OpenAsset("stored.bin"), deflated = OpenAsset("deflated.bin");
+		RemoveAssetsPackage(stored_package);
+		RemoveAssetsPackage(deflated_package);
+		TEST_CHECK(!IsAssetFile("stored.bin"));
+
+		std::string a(content.size(), 0), b(content.size(), 0);
+		TEST_CHECK(Read(stored, &a[0], a.size()) == a.size());
+		TEST_CHECK(Read(deflated, &b[0], b.size()) == b.size());
+		TEST_CHECK(a == content);
+		TEST_CHECK(b == content);
+
+		Close(stored);
+		Close(deflated);
+	}
+
+	Unlink(stored_package);
+	Unlink(deflated_package);
+}
+
+static void test_asset_pack_entries() {
+	const std::string content = MakeEntryContent(1024 * 1024 + 17);
+
+	std::vector<AssetPackInput> inputs(2);
+	inputs[0].name = "packed/stored.bin";
+	inputs[0].compression = APC_None;
+	inputs[1].name = "packed/deflated.bin";
+	inputs[1].compression = APC_Deflate;
+
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		inputs[i].path = hg::test::CreateTempFilepath();
+		inputs[i].alignment = 64;
+		TEST_CHECK(StringToFile(inputs[i].path, content));
+	}
+
+	const std::string pack = hg::test::CreateTempFilepath();
+	TEST_CHECK(WriteAssetPack(pack, inputs));
+	TEST_CHECK(AddAssetsPackage(pack));
+
+	TEST_CHECK(IsAssetFile("packed/stored.bin"));
+	CheckPackageEntry("packed/stored.bin", content);
+	CheckPackageEntry("packed/deflated.bin", content);
+
+	{
+		// stored entries are addressable in place, deflated entries must be read
+		Asset stored = OpenAsset("packed/stored.bin"), deflated = OpenAsset("packed/deflated.bin");
+
+		size_t size = 0;
+		const void *data = GetAssetData(stored, size);
+		TEST_CHECK(data != nullptr);
+		TEST_CHECK(size == content.size());
+		TEST_CHECK(data && memcmp(data, content.data(), content.size()) == 0);
+		TEST_CHECK((reinterpret_cast<uintptr_t>(data) & 63) == 0);
+
+		TEST_CHECK(GetAssetData(deflated, size) == nullptr);
+
+		Close(stored);
+		Close(deflated);
+		TEST_CHECK(GetAssetData(stored, size) == nullptr);
+	}
+
+	RemoveAssetsPackage(pack);
+	TEST_CHECK(!IsAssetFile("packed/stored.bin"));
+
+	Unlink(pack);
+	for (size_t i = 0; i < inputs.size(); ++i)
+		Unlink(inputs[i].path);
+}
+
+static void test_assets_index() {
+	const std::string root = PathJoin(hg::test::GetTempDirectoryName(), "hg_assets_index_test");
+	const std::string folder_a = PathJoin(root, "a"), folder_b = PathJoin(root, "b");
+	const std::string package_a = hg::test::CreateTempFilepath(), package_b = hg::test::CreateTempFilepath();
+
+	MkTree(PathJoin(folder_a, "sub"));
+	MkTree(folder_b);
+
+	TEST_CHECK(StringToFile(PathJoin(folder_a, "shared.txt"), "folder a"));
+	TEST_CHECK(StringToFile(PathJoin(folder_a, "sub/nested.txt"), "nested"));
+	TEST_CHECK(StringToFile(PathJoin(folder_b, "shared.txt"), "folder b"));
+	TEST_CHECK(CreatePackage(package_a, "shared.txt", "package a"));
+	TEST_CHECK(CreatePackage(package_b, "shared.txt", "package b"));
+
+	// packages mounted first still come after folders, most recently mounted first
+	TEST_CHECK(AddAssetsPackage(package_a));
+	TEST_CHECK(AddAssetsPackage(package_b));
+	TEST_CHECK(AssetToString("shared.txt").c_str() == std::string("package b"));
+
+	TEST_CHECK(AddAssetsFolder(folder_a));
+	TEST_CHECK(AssetToString("shared.txt").c_str() == std::string("folder a"));
+	{
+		Asset file = OpenAsset("shared.txt");
+		size_t size;
+		TEST_CHECK(GetAssetData(file, size) == nullptr); // filesystem assets are only read
+		Close(file);
+	}
+	TEST_CHECK(AddAssetsFolder(folder_b));
+	TEST_CHECK(AssetToString("shared.txt").c_str() == std::string("folder b"));
+	TEST_CHECK(FindAssetPath("shared.txt") == PathJoin(folder_b, "shared.txt"));
+
+	TEST_CHECK(AssetToString("sub/nested.txt").c_str() == std::string("nested"));
+	TEST_CHECK(AssetToString("./sub//nested.txt").c_str() == std::string("nested"));
+	TEST_CHECK(IsAssetFile("sub/nested.txt"));
+	TEST_CHECK(FindAssetPath("missing.txt").empty());
+
+	RemoveAssetsFolder(folder_b);
+	TEST_CHECK(AssetToString("shared.txt").c_str() == std::string("folder a"));
+	RemoveAssetsFolder(folder_a);
+	RemoveAssetsPackage(package_b);
+	TEST_CHECK(AssetToString("shared.txt").c_str() == std::string("package a"));
+	TEST_CHECK(FindAssetPath("shared.txt").empty()); // only found in a package
+
+	// files created in a mounted folder are seen once the index is refreshed
+	TEST_CHECK(AddAssetsFolder(folder_b));
+	TEST_CHECK(StringToFile(PathJoin(folder_b, "late.txt"), "late"));
+	TEST_CHECK(!IsAssetFile("late.txt"));
+	RefreshAssetsIndex();
+	TEST_CHECK(IsAssetFile("late.txt"));
+	TEST_CHECK(AssetToString("late.txt").c_str() == std::string("late"));
+	TEST_CHECK(FindAssetPath("late.txt") == PathJoin(folder_b, "late.txt"));
+
+	// names the index cannot hold resolve as they did before it
+	TEST_CHECK(AssetToString("../b/late.txt").c_str() == std::string("late"));
+	TEST_CHECK(!IsAssetFile("../b/missing.txt"));
+	TEST_CHECK(!IsAssetFile("b..late.txt"));
+#if _WIN32
+	TEST_CHECK(AssetToString("LATE.txt").c_str() == std::string("late"));
+#endif
+
+	RemoveAssetsFolder(folder_b);
+	RemoveAssetsPackage(package_a);
+	TEST_CHECK(!IsAssetFile("shared.txt"));
+
+	RmTree(root);
+	Unlink(package_a);
+	Unlink(package_b);
+}
+
+#if !_WIN32
+static void test_assets_symlinked_folder() {
+	const std::string root = PathJoin(hg::test::GetTempDirectoryName(), "hg_assets_symlink_test");
+	const std::string folder = PathJoin(root, "assets"), shared = PathJoin(root, "shared");
+
+	const char *links[3] = {"textures", "alias.txt", "loop"};
+	for (int i = 0; i < 3; ++i)
+		Unlink(PathJoin(folder, links[i])); // left by an interrupted run
+	RmTree(root);
+
+	MkTree(PathJoin(shared, "deep"));
+	MkTree(folder);
+
+	TEST_CHECK(StringToFile(PathJoin(shared, "deep/linked.txt"), "linked"));
+	TEST_CHECK(StringToFile(PathJoin(shared, "file.txt"), "file"));
+	TEST_CHECK(symlink(shared.c_str(), PathJoin(folder, "textures").c_str()) == 0);
+	TEST_CHECK(symlink(PathJoin(shared, "file.txt").c_str(), PathJoin(folder, "alias.txt").c_str()) == 0);
+	TEST_CHECK(symlink(folder.c_str(), PathJoin(folder, "loop").c_str()) == 0); // link cycles are bounded
+
+	TEST_CHECK(AddAssetsFolder(folder));
+	TEST_CHECK(IsAssetFile("textures/deep/linked.txt"));
+	TEST_CHECK(AssetToString("textures/deep/linked.txt").c_str() == std::string("linked"));
+	TEST_CHECK(AssetToString("alias.txt").c_str() == std::string("file"));
+	TEST_CHECK(AssetToString("loop/textures/file.txt").c_str() == std::string("file"));
+	RemoveAssetsFolder(folder);
+
+	for (int i = 0; i < 3; ++i)
+		Unlink(PathJoin(folder, links[i]));
+	RmTree(root);
+}
+#endif
+
+void test_assets() {
+	test_package_entries();
+	test_asset_pack_entries();
+	test_assets_index();
+#if !_WIN32
+	test_assets_symlinked_folder();
+#endif
+
+	const std::string folder = PathJoin(hg::test::GetTempDirectoryName(), "hg_assets_test");
+	MkDir(folder);
+
+	const std::string package = hg::test::CreateTempFilepath(), transient_package = hg::test::CreateTempFilepath();
+
+	AssetStress stress;
+	stress.folder_content = hg::test::LoremIpsum;
+	stress.package_content = hg::test::LoremIpsum + hg::test::LoremIpsum;
+	stress.failures = 0;
+
+	TEST_CHECK(StringToFile(PathJoin(folder, "folder.txt"), stress.folder_content));
+	TEST_CHECK(CreatePackage(package, "package.txt", stress.package_content));
+	TEST_CHECK(CreatePackage(transient_package, "transient.txt", "transient"));
+
+	TEST_CHECK(AddAssetsFolder(folder));
+	TEST_CHECK(!AddAssetsFolder(folder));
+	TEST_CHECK(AddAssetsPackage(package));
+	TEST_CHECK(!AddAssetsPackage(package));
+
+	TEST_CHECK(IsAssetFile("folder.txt"));
+	TEST_CHECK(IsAssetFile("package.txt"));
+	TEST_CHECK(!IsAssetFile("missing.txt"));
+	TEST_CHECK(FindAssetPath("folder.txt") == PathJoin(folder, "folder.txt"));
+
+	TEST_CHECK(ReadAsset("folder.txt", stress.folder_content));
+	TEST_CHECK(ReadAsset("package.txt", stress.package_content));
+	TEST_CHECK(!IsValid(OpenAsset("missing.txt", true)));
+
+	{
+		Thread threads[8];
+		for (int i = 0; i < 8; ++i)
+			TEST_CHECK(threads[i].start(OpenReadCloseAssets, &stress));
+
+		for (int i = 0; i < 50; ++i) {
+			AddAssetsPackage(transient_package);
+			RemoveAssetsPackage(transient_package);
+		}
+
+		for (int i = 0; i < 8; ++i)
+			threads[i].join();
+
+		TEST_CHECK(AtomicLoad(stress.failures) == 0);
+	}
+
+	RemoveAssetsPackage(package);
+	RemoveAssetsFolder(folder);
+
+	TEST_CHECK(!IsAssetFile("folder.txt"));
+	TEST_CHECK(!IsAssetFile("package.txt"));
+
+	Unlink(PathJoin(folder, "folder.txt"));
+	RmDir(folder);
+	Unlink(package);
+	Unlink(transient_package);
+}
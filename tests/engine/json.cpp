@@ -0,0 +1,74 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "engine/json.h"
+
+#include "foundation/file.h"
+#include "foundation/path_tools.h"
+
+#include "../utils.h"
+
+#include <fmt/format.h>
+
+using namespace hg;
+
+static std::string make_json(int count) {
+	std::string js = "{\"name\": \"values\", \"values\": [";
+	for (int i = 0; i < count; ++i)
+		js += fmt::format("{}{{\"idx\": {}, \"label\": \"label_{}\"}}", i ? ", " : "", i, i);
+	js += "]}";
+	return js;
+}
+
+static bool check_doc(const rapidjson::Value &doc, int count) {
+	if (!doc.IsObject() || std::string(doc["name"].GetString()) != "values")
+		return false;
+
+	const rapidjson::Value &values = doc["values"];
+	if (!values.IsArray() || values.Size() != rapidjson::SizeType(count))
+		return false;
+
+	for (int i = 0; i < count; ++i)
+		if (values[i]["idx"].GetInt() != i || std::string(values[i]["label"].GetString()) != fmt::format("label_{}", i))
+			return false;
+	return true;
+}
+
+void test_json() {
+	const std::string path = PathJoin(hg::test::GetTempDirectoryName(), "test_json.json");
+	const std::string bad_path = PathJoin(hg::test::GetTempDirectoryName(), "test_json_bad.json");
+
+	const int count = 4096; // spans several stream buffers
+	TEST_CHECK(StringToFile(path, make_json(count)));
+	TEST_CHECK(StringToFile(bad_path, "{\"name\": [1, 2"));
+
+	{
+		rapidjson::Document doc;
+		TEST_CHECK(LoadJsonFromFile(path, doc) == true);
+		TEST_CHECK(check_doc(doc, count));
+
+		rapidjson::Document bad_doc;
+		TEST_CHECK(LoadJsonFromFile(bad_path, bad_doc) == false);
+		TEST_CHECK(LoadJsonFromFile(PathJoin(hg::test::GetTempDirectoryName(), "missing.json"), bad_doc) == false);
+	}
+
+	{
+		JsonLoadContext ctx;
+		TEST_CHECK(LoadJsonFromFile(path, ctx) == true);
+		TEST_CHECK(check_doc(ctx.doc, count));
+
+		// reuse the context storage
+		TEST_CHECK(StringToFile(path, make_json(16)));
+		TEST_CHECK(LoadJsonFromFile(path, ctx) == true);
+		TEST_CHECK(check_doc(ctx.doc, 16));
+
+		TEST_CHECK(LoadJsonFromFile(bad_path, ctx) == false);
+		TEST_CHECK(LoadJsonFromFile(path, ctx) == true);
+		TEST_CHECK(check_doc(ctx.doc, 16));
+	}
+
+	Unlink(path);
+	Unlink(bad_path);
+}
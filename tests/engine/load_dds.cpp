@@ -0,0 +1,182 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "engine/load_dds.h"
+
+#include "foundation/file.h"
+#include "foundation/file_rw_interface.h"
+#include "foundation/log.h"
+
+#include "../utils.h"
+
+#include <string.h>
+
+using namespace hg;
+
+static bool LoadFixture(const char *name, TextureData &data) {
+	const std::string path = std::string(HG_TEST_DATA_PATH "/dds/") + name;
+	ScopedReadHandle h(g_file_read_provider, path);
+	return LoadDDS(g_file_reader, h, path, data);
+}
+
+// load a fixture with a 32 bit field of its header overwritten
+static bool LoadPatchedFixture(const char *name, size_t offset, uint32_t value) {
+	std::string content = FileToString(std::string(HG_TEST_DATA_PATH "/dds/") + name);
+	if (content.size() < offset + 4)
+		return false;
+	memcpy(&content[offset], &value, 4);
+
+	const std::string path = hg::test::CreateTempFilepath();
+	StringToFile(path, content);
+
+	TextureData data;
+	bool ok;
+	{
+		ScopedReadHandle h(g_file_read_provider, path);
+		ok = LoadDDS(g_file_reader, h, path, data, true);
+	}
+	Unlink(path);
+	return ok;
+}
+
+static void CountLog(const std::string &, int, const std::string &, void *user) { ++*reinterpret_cast<int *>(user); }
+
+static int CountFixtureLogs(const char *name, bool silent) {
+	int count = 0;
+	set_log_level(LL_All);
+	set_log_hook(CountLog, &count);
+
+	const std::string path = std::string(HG_TEST_DATA_PATH "/dds/") + name;
+	ScopedReadHandle h(g_file_read_provider, path);
+	TextureData data;
+	LoadDDS(g_file_reader, h, path, data, silent);
+
+	set_log_hook(nullptr, nullptr);
+	return count;
+}
+
+static bool IsFilledWith(const TextureData &data, size_t offset, size_t size, uint8_t v) {
+	for (size_t i = offset; i < offset + size; ++i)
+		if (data.data[i] != v)
+			return false;
+	return true;
+}
+
+static bool MakesValidTexture(const TextureData &data) {
+	Texture tex = MakeTexture(data);
+	const bool valid = sg_query_image_state(tex.image) == SG_RESOURCESTATE_VALID;
+	Destroy(tex);
+	return valid;
+}
+
+void test_load_dds() {
+	if (!sg_isvalid()) {
+		sg_desc desc;
+		memset(&desc, 0, sizeof(sg_desc));
+		sg_setup(&desc);
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("bc1_mips.dds", data));
+		TEST_CHECK(data.width == 8 && data.height == 8);
+		TEST_CHECK(data.type == SG_IMAGETYPE_2D);
+		TEST_CHECK(data.format == SG_PIXELFORMAT_BC1_RGBA);
+		TEST_CHECK(data.mips.size() == 4);
+		TEST_CHECK(data.mips[0] == 32 && data.mips[1] == 8 && data.mips[2] == 8 && data.mips[3] == 8); // 4x4 blocks of 8 bytes, at least one block
+		TEST_CHECK(data.data.size() == 56);
+		TEST_CHECK(IsFilledWith(data, 32, 8, 2));
+		TEST_CHECK(MakesValidTexture(data));
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("bc1_truncated.dds", data)); // available mips are kept
+		TEST_CHECK(data.mips.size() == 2);
+		TEST_CHECK(data.data.size() == 40);
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("bc3_cube.dds", data));
+		TEST_CHECK(data.type == SG_IMAGETYPE_CUBE);
+		TEST_CHECK(data.format == SG_PIXELFORMAT_BC3_RGBA);
+		TEST_CHECK(data.mips.size() == 3);
+		TEST_CHECK(data.mips[0] == 16 && data.mips[2] == 16);
+		TEST_CHECK(data.data.size() == 6 * 3 * 16);
+		TEST_CHECK(IsFilledWith(data, (2 * 3 + 1) * 16, 16, 2 * 16 + 1)); // face 2, mip 1
+		TEST_CHECK(MakesValidTexture(data));
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("bc7_array.dds", data));
+		TEST_CHECK(data.type == SG_IMAGETYPE_ARRAY);
+		TEST_CHECK(data.slice_count == 3);
+		TEST_CHECK(data.format == SG_PIXELFORMAT_BC7_RGBA);
+		TEST_CHECK(data.mips.size() == 2);
+		TEST_CHECK(data.mips[0] == 3 * 32 && data.mips[1] == 3 * 16);
+
+		// regrouped by mip level
+		TEST_CHECK(IsFilledWith(data, 0, 32, 0));
+		TEST_CHECK(IsFilledWith(data, 32, 32, 16));
+		TEST_CHECK(IsFilledWith(data, 64, 32, 32));
+		TEST_CHECK(IsFilledWith(data, 96, 16, 1));
+		TEST_CHECK(IsFilledWith(data, 112, 16, 17));
+		TEST_CHECK(IsFilledWith(data, 128, 16, 33));
+		TEST_CHECK(MakesValidTexture(data));
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("bgra8.dds", data));
+		TEST_CHECK(data.format == SG_PIXELFORMAT_RGBA8);
+		TEST_CHECK(data.mips.size() == 1 && data.mips[0] == 16);
+		TEST_CHECK(data.data[0] == 30 && data.data[1] == 20 && data.data[2] == 10 && data.data[3] == 40); // BGRA to RGBA
+		TEST_CHECK(data.data[12] == 33 && data.data[15] == 43);
+		TEST_CHECK(MakesValidTexture(data));
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("rgba16f_mips.dds", data));
+		TEST_CHECK(data.format == SG_PIXELFORMAT_RGBA16F);
+		TEST_CHECK(data.mips.size() == 3);
+		TEST_CHECK(data.mips[0] == 128 && data.mips[1] == 32 && data.mips[2] == 8);
+		TEST_CHECK(MakesValidTexture(data));
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("etc2_rgba8.dds", data));
+		TEST_CHECK(data.format == SG_PIXELFORMAT_ETC2_RGBA8);
+		TEST_CHECK(data.mips.size() == 1 && data.mips[0] == 64);
+	}
+
+	{
+		TextureData data;
+		TEST_CHECK(LoadFixture("missing.dds", data) == false);
+
+		const std::string path = hg::test::CreateTempFilepath();
+		TEST_CHECK(StringToFile(path, "not a DDS file"));
+
+		ScopedReadHandle h(g_file_read_provider, path, true);
+		TEST_CHECK(LoadDDS(g_file_reader, h, path, data) == false);
+	}
+
+	// rejected headers, offsets are in the file (magic, DDSURFACEDESC2, DDS_HEADER_DXT10)
+	TEST_CHECK(LoadPatchedFixture("bc1_mips.dds", 28, 4)); // unpatched mip count
+	TEST_CHECK(!LoadPatchedFixture("bc1_mips.dds", 28, 5)); // more mips than the full chain
+	TEST_CHECK(!LoadPatchedFixture("bc1_mips.dds", 28, 0xffffffff));
+	TEST_CHECK(!LoadPatchedFixture("bc1_mips.dds", 16, 0x80000000)); // width
+	TEST_CHECK(!LoadPatchedFixture("bc1_mips.dds", 12, 65536)); // height
+	TEST_CHECK(LoadPatchedFixture("bc7_array.dds", 128, 98)); // DXGI_FORMAT_BC7_UNORM
+	TEST_CHECK(!LoadPatchedFixture("bc7_array.dds", 128, 99)); // DXGI_FORMAT_BC7_UNORM_SRGB is not loaded as linear
+
+	// silent loads do not log, decode jobs honor the load silent flag
+	TEST_CHECK(CountFixtureLogs("bc1_truncated.dds", false) > 0);
+	TEST_CHECK(CountFixtureLogs("bc1_truncated.dds", true) == 0);
+	TEST_CHECK(CountFixtureLogs("bc1_mips.dds", true) == 0);
+}
@@ -0,0 +1,392 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "engine/file_format.h"
+#include "engine/render_pipeline.h"
+
+#include "foundation/file.h"
+#include "foundation/job.h"
+#include "foundation/thread.h"
+
+#include "../utils.h"
+
+#include <string.h>
+
+using namespace hg;
+
+static std::string WriteTestModel(uint16_t tri_count) {
+	const std::string path = hg::test::CreateTempFilepath();
+
+	ScopedFile file(OpenWrite(path));
+
+	Write(file, HarfangMagic);
+	Write(file, ModelMarker);
+	Write<uint8_t>(file, 2); // version
+
+	uint8_t legacy_layout[80]; // legacy vertex layout
+	memset(legacy_layout, 0, sizeof(legacy_layout));
+	Write(file, legacy_layout, sizeof(legacy_layout));
+
+	Write<uint8_t>(file, 2); // 16 bit indices
+	Write<uint32_t>(file, tri_count * 3 * 2);
+	for (uint16_t i = 0; i < tri_count * 3; ++i)
+		Write<uint16_t>(file, i % 3);
+
+	const float vtx[9] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+	Write<uint32_t>(file, sizeof(vtx));
+	Write(file, vtx, sizeof(vtx));
+
+	Write<uint32_t>(file, 0); // bones table
+	Write(file, MinMax(Vec3(0.f, 0.f, 0.f), Vec3(1.f, 1.f, 0.f)));
+	Write<uint16_t>(file, 0); // material
+
+	Write<uint8_t>(file, 0); // EOLists
+	Write<uint32_t>(file, 0); // bind pose
+	return path;
+}
+
+static std::string WriteTestDDS(uint32_t size) {
+	const std::string path = hg::test::CreateTempFilepath();
+
+	ScopedFile file(OpenWrite(path));
+
+	Write<uint32_t>(file, uint32_t('D') | (uint32_t('D') << 8) | (uint32_t('S') << 16) | (uint32_t(' ') << 24)); // "DDS " FourCC
+
+	uint32_t header[31];
+	memset(header, 0, sizeof(header));
+	header[0] = 124; // dwSize
+	header[1] = 0x1007; // DDSD_CAPS|DDSD_HEIGHT|DDSD_WIDTH|DDSD_PIXELFORMAT
+	header[2] = size; // dwHeight
+	header[3] = size; // dwWidth
+	header[18] = 32; // ddpfPixelFormat.dwSize
+	header[19] = 0x41; // DDPF_RGB|DDPF_ALPHAPIXELS
+	header[21] = 32; // dwRGBBitCount
+	header[22] = 0x00ff0000;
+	header[23] = 0x0000ff00;
+	header[24] = 0x000000ff;
+	header[25] = 0xff000000;
+	Write(file, header, sizeof(header));
+
+	for (uint32_t i = 0; i < size * size; ++i)
+		Write<uint32_t>(file, 0xff102030);
+	return path;
+}
+
+static void test_load_queue_inline() {
+	std::vector<std::string> paths;
+	for (int i = 0; i < 4; ++i)
+		paths.push_back(WriteTestModel(uint16_t(i + 1)));
+
+	PipelineResources res;
+
+	std::vector<ModelRef> refs;
+	for (size_t i = 0; i < paths.size(); ++i)
+		refs.push_back(QueueLoadModelFromFile(paths[i], res));
+	const ModelRef missing = QueueLoadModelFromFile(hg::test::CreateTempFilepath(), res);
+
+	TEST_CHECK(GetQueuedResourceCount(res) == 5);
+	TEST_CHECK(QueueLoadModelFromFile(paths[0], res) == refs[0]);
+	TEST_CHECK(GetQueuedResourceCount(res) == 5);
+
+	for (size_t i = 0; i < refs.size(); ++i)
+		TEST_CHECK(GetModelLoadState(res, refs[i]) == RLS_Queued);
+
+	// without workers, loads are decoded on the calling thread two at a time and a single one is created per call under a 1 byte budget
+	TEST_CHECK(ProcessModelLoadQueue(res, time_from_sec(60), true, 1) == 1);
+	TEST_CHECK(GetModelLoadState(res, refs[0]) == RLS_Loaded);
+	TEST_CHECK(GetModelLoadState(res, refs[1]) == RLS_Decoded);
+	TEST_CHECK(GetModelLoadState(res, refs[2]) == RLS_Queued);
+	TEST_CHECK(res.models.Get(refs[0]).tri_count == 1);
+	TEST_CHECK(res.models.Get(refs[1]).lists.empty());
+
+	TEST_CHECK(ProcessModelLoadQueue(res, time_from_sec(60), true, 1) == 1);
+	TEST_CHECK(GetModelLoadState(res, refs[1]) == RLS_Loaded);
+	TEST_CHECK(GetModelLoadState(res, refs[2]) == RLS_Decoded);
+	TEST_CHECK(GetModelLoadState(res, refs[3]) == RLS_Queued);
+
+	// a large byte budget creates every decoded load
+	TEST_CHECK(ProcessModelLoadQueue(res, time_from_sec(60), true) == 2);
+	TEST_CHECK(GetModelLoadState(res, missing) == RLS_Queued);
+
+	TEST_CHECK(ProcessModelLoadQueue(res, time_from_sec(60), true) == 1);
+	TEST_CHECK(GetModelLoadState(res, missing) == RLS_Failed);
+	TEST_CHECK(GetQueuedResourceCount(res) == 0);
+
+	for (size_t i = 0; i < refs.size(); ++i) {
+		const Model &mdl = res.models.Get(refs[i]);
+		TEST_CHECK(GetModelLoadState(res, refs[i]) == RLS_Loaded);
+		TEST_CHECK(mdl.tri_count == i + 1);
+		TEST_CHECK(mdl.lists.size() == 1);
+		TEST_CHECK(mdl.lists[0].element_count == (i + 1) * 3);
+		TEST_CHECK(mdl.bounds.size() == 1 && mdl.bounds[0].mx == Vec3(1.f, 1.f, 0.f));
+	}
+
+	// resources not loaded through a queue
+	TEST_CHECK(GetModelLoadState(res, res.models.Add("added", Model())) == RLS_Loaded);
+	TEST_CHECK(GetModelLoadState(res, InvalidModelRef) == RLS_Invalid);
+
+	res.models.Destroy(refs[0]);
+	TEST_CHECK(GetModelLoadState(res, refs[0]) == RLS_Invalid);
+}
+
+// process a queue one load at a time without workers, return the loaded models in completion order
+static std::vector<size_t> ProcessModelLoadsInOrder(PipelineResources &res, const std::vector<ModelRef> &refs) {
+	std::vector<size_t> order;
+	std::vector<bool> loaded(refs.size(), false);
+
+	while (GetQueuedResourceCount(res))
+		if (ProcessModelLoadQueue(res, time_from_sec(60), true, 1) == 1)
+			for (size_t i = 0; i < refs.size(); ++i)
+				if (!loaded[i] && GetModelLoadState(res, refs[i]) == RLS_Loaded) {
+					loaded[i] = true;
+					order.push_back(i);
+				}
+
+	return order;
+}
+
+static void test_load_queue_priority() {
+	{
+		PipelineResources res;
+
+		const float priorities[6] = {0.f, 5.f, 1.f, 5.f, -1.f, 3.f};
+
+		std::vector<ModelRef> refs;
+		for (int i = 0; i < 6; ++i)
+			refs.push_back(QueueLoadModelFromFile(WriteTestModel(1), res, priorities[i]));
+
+		const std::vector<size_t> order = ProcessModelLoadsInOrder(res, refs);
+
+		const size_t expected[6] = {1, 3, 5, 2, 0, 4}; // equal priorities in queue order
+		TEST_CHECK(order == std::vector<size_t>(expected, expected + 6));
+	}
+
+	{
+		PipelineResources res;
+
+		std::vector<ModelRef> refs;
+		for (int i = 0; i < 3; ++i)
+			refs.push_back(QueueLoadModelFromFile(WriteTestModel(1), res));
+
+		TEST_CHECK(SetModelLoadPriority(res, refs[2], 10.f));
+		TEST_CHECK(SetModelLoadPriority(res, refs[0], -5.f));
+		TEST_CHECK(SetModelLoadPriority(res, InvalidModelRef, 1.f) == false);
+
+		const std::vector<size_t> order = ProcessModelLoadsInOrder(res, refs);
+
+		const size_t expected[3] = {2, 1, 0};
+		TEST_CHECK(order == std::vector<size_t>(expected, expected + 3));
+		TEST_CHECK(SetModelLoadPriority(res, refs[0], 1.f) == false); // no pending load
+	}
+
+	{
+		PipelineResources res;
+
+		std::vector<ModelRef> refs;
+		std::vector<float> priorities;
+
+		uint32_t seed = 1234;
+		for (int i = 0; i < 200; ++i) {
+			seed = seed * 1664525 + 1013904223;
+			priorities.push_back(float(seed >> 24));
+			refs.push_back(QueueLoadModelFromFile(WriteTestModel(1), res, priorities.back()));
+		}
+
+		for (int i = 0; i < 50; ++i) {
+			seed = seed * 1664525 + 1013904223;
+			const size_t idx = (seed >> 8) % refs.size();
+			priorities[idx] = float(seed >> 24);
+			TEST_CHECK(SetModelLoadPriority(res, refs[idx], priorities[idx]));
+		}
+
+		const std::vector<size_t> order = ProcessModelLoadsInOrder(res, refs);
+		TEST_CHECK(order.size() == refs.size());
+
+		bool sorted = true;
+		for (size_t i = 1; i < order.size(); ++i)
+			if (priorities[order[i]] > priorities[order[i - 1]] || (priorities[order[i]] == priorities[order[i - 1]] && order[i] < order[i - 1]))
+				sorted = false;
+		TEST_CHECK(sorted);
+	}
+}
+
+static void test_load_queue_eviction() {
+	PipelineResources res;
+
+	std::vector<TextureRef> refs;
+	for (int i = 0; i < 4; ++i)
+		refs.push_back(LoadTextureFromFile(WriteTestDDS(8), res, true));
+
+	TEST_CHECK(res.textures.GetSize(refs[0]) == 8 * 8 * 4);
+	TEST_CHECK(res.textures.GetTotalSize() == 4 * 8 * 8 * 4);
+
+	const sg_image image = res.textures.Get(refs[1]).image;
+	TEST_CHECK(sg_query_image_state(image) == SG_RESOURCESTATE_VALID);
+
+	// queued loads are pinned until loaded
+	const TextureRef queued = QueueLoadTextureFromFile(WriteTestDDS(8), res);
+	TEST_CHECK(res.textures.IsPinned(queued));
+
+	res.textures.Touch(refs[0]);
+	res.textures.SetBudget(2 * 8 * 8 * 4);
+	TEST_CHECK(res.textures.Evict() == 2);
+	TEST_CHECK(res.textures.IsValidRef(refs[0]) == true);
+	TEST_CHECK(res.textures.IsValidRef(refs[1]) == false);
+	TEST_CHECK(res.textures.IsValidRef(refs[2]) == false);
+	TEST_CHECK(res.textures.IsValidRef(refs[3]) == true);
+	TEST_CHECK(res.textures.IsValidRef(queued) == true);
+	TEST_CHECK(sg_query_image_state(image) == SG_RESOURCESTATE_INVALID); // GPU resource released
+
+	while (GetQueuedResourceCount(res))
+		ProcessTextureLoadQueue(res, time_from_sec(60), true);
+
+	TEST_CHECK(res.textures.IsPinned(queued) == false);
+	TEST_CHECK(res.textures.GetTotalSize() == 3 * 8 * 8 * 4);
+	TEST_CHECK(res.textures.Evict() == 1); // least recently used
+	TEST_CHECK(res.textures.IsValidRef(refs[3]) == false);
+	TEST_CHECK(res.textures.IsValidRef(queued) == true);
+}
+
+static void test_load_queue_destroy_all() {
+	PipelineResources res;
+
+	const TextureRef loaded = LoadTextureFromFile(WriteTestDDS(8), res, true);
+	const sg_image image = res.textures.Get(loaded).image;
+	const TextureRef queued = QueueLoadTextureFromFile(WriteTestDDS(8), res);
+	TEST_CHECK(res.textures.IsPinned(queued));
+
+	res.DestroyAll();
+
+	TEST_CHECK(sg_query_image_state(image) == SG_RESOURCESTATE_INVALID); // GPU resource released
+	TEST_CHECK(res.textures.IsValidRef(loaded) == false);
+	TEST_CHECK(res.textures.IsValidRef(queued) == false); // cancelled load placeholder dropped
+	TEST_CHECK(res.textures.GetTotalSize() == 0);
+	TEST_CHECK(GetQueuedResourceCount(res) == 0);
+}
+
+static void test_load_queue_dedup() {
+	PipelineResources res;
+	res.deduplicate_content = true;
+
+	const TextureRef a = LoadTextureFromFile(WriteTestDDS(8), res, true);
+	const TextureRef b = LoadTextureFromFile(WriteTestDDS(8), res, true); // same content, different name
+	const TextureRef c = LoadTextureFromFile(WriteTestDDS(4), res, true);
+
+	const sg_image image = res.textures.Get(a).image;
+	TEST_CHECK(a != b);
+	TEST_CHECK(res.textures.Get(b).image.id == image.id);
+	TEST_CHECK(res.textures.Get(c).image.id != image.id);
+	TEST_CHECK(res.textures.GetSize(b) == 8 * 8 * 4);
+	TEST_CHECK(res.textures.GetTotalSize() == 8 * 8 * 4 + 4 * 4 * 4);
+	TEST_CHECK(res.textures.GetSharedSize() == 8 * 8 * 4);
+
+	res.textures.Destroy(a);
+	TEST_CHECK(sg_query_image_state(image) == SG_RESOURCESTATE_VALID); // still used by b
+	TEST_CHECK(res.textures.GetSharedSize() == 0);
+	TEST_CHECK(res.textures.GetTotalSize() == 8 * 8 * 4 + 4 * 4 * 4);
+
+	res.textures.Destroy(b);
+	TEST_CHECK(sg_query_image_state(image) == SG_RESOURCESTATE_INVALID);
+	TEST_CHECK(res.textures.GetTotalSize() == 4 * 4 * 4);
+
+	// queued loads
+	const std::string model_path = WriteTestModel(2);
+
+	std::vector<ModelRef> models;
+	models.push_back(QueueLoadModelFromFile(model_path, res));
+	models.push_back(QueueLoadModelFromFile(WriteTestModel(2), res));
+	models.push_back(QueueLoadModelFromFile(WriteTestModel(3), res));
+
+	while (GetQueuedResourceCount(res))
+		ProcessModelLoadQueue(res, time_from_sec(60), true);
+
+	const sg_buffer vtx = res.models.Get(models[0]).lists[0].vertex_buffer;
+	TEST_CHECK(res.models.Get(models[1]).lists[0].vertex_buffer.id == vtx.id);
+	TEST_CHECK(res.models.Get(models[2]).lists[0].vertex_buffer.id != vtx.id);
+	TEST_CHECK(res.models.GetSharedSize() == res.models.GetSize(models[0]));
+
+	// a synchronous load of the same content shares it as well
+	const ModelRef sync = LoadModelFromFile(WriteTestModel(2), res, true);
+	TEST_CHECK(res.models.Get(sync).lists[0].vertex_buffer.id == vtx.id);
+	TEST_CHECK(res.models.GetSharedSize() == 2 * res.models.GetSize(models[0]));
+
+	// reloading a resource stops sharing
+	res.models.Update(models[1], LoadModelFromFile(model_path, true));
+	TEST_CHECK(res.models.Get(models[1]).lists[0].vertex_buffer.id != vtx.id);
+	TEST_CHECK(sg_query_buffer_state(vtx) == SG_RESOURCESTATE_VALID);
+
+	res.models.Destroy(models[0]);
+	res.models.Destroy(sync);
+	TEST_CHECK(sg_query_buffer_state(vtx) == SG_RESOURCESTATE_INVALID);
+	TEST_CHECK(res.models.GetSharedSize() == 0);
+
+	res.deduplicate_content = false;
+	const TextureRef d = LoadTextureFromFile(WriteTestDDS(4), res, true);
+	TEST_CHECK(res.textures.Get(d).image.id != res.textures.Get(c).image.id);
+}
+
+static void test_load_queue_workers() {
+	TEST_CHECK(StartJobSystem(2));
+
+	std::vector<std::string> model_paths, texture_paths;
+	for (int i = 0; i < 16; ++i) {
+		model_paths.push_back(WriteTestModel(uint16_t(i + 1)));
+		texture_paths.push_back(WriteTestDDS(uint32_t(4 + i)));
+	}
+
+	{
+		PipelineResources res;
+
+		std::vector<ModelRef> models;
+		std::vector<TextureRef> textures;
+		for (int i = 0; i < 16; ++i) {
+			models.push_back(QueueLoadModelFromFile(model_paths[i], res));
+			textures.push_back(QueueLoadTextureFromFile(texture_paths[i], res));
+		}
+
+		size_t processed = 0;
+		for (int n = 0; GetQueuedResourceCount(res) && n < 1000000; ++n) {
+			processed += ProcessLoadQueues(res, time_from_ms(4), true);
+			ThreadYield();
+		}
+
+		TEST_CHECK(processed == 32);
+		TEST_CHECK(GetQueuedResourceCount(res) == 0);
+
+		for (int i = 0; i < 16; ++i) {
+			TEST_CHECK(GetModelLoadState(res, models[i]) == RLS_Loaded);
+			TEST_CHECK(res.models.Get(models[i]).tri_count == uint32_t(i + 1));
+
+			TEST_CHECK(GetTextureLoadState(res, textures[i]) == RLS_Loaded);
+			TEST_CHECK(sg_query_image_state(res.textures.Get(textures[i]).image) == SG_RESOURCESTATE_VALID);
+		}
+	}
+
+	{
+		PipelineResources res; // destroyed with loads in flight
+
+		for (int i = 0; i < 16; ++i)
+			QueueLoadModelFromFile(model_paths[i], res);
+		ProcessModelLoadQueue(res, 0, true);
+	}
+
+	StopJobSystem();
+}
+
+void test_load_queue() {
+	if (!sg_isvalid()) {
+		sg_desc desc;
+		memset(&desc, 0, sizeof(sg_desc));
+		desc.buffer_pool_size = 1024; // model resources are never released
+		sg_setup(&desc);
+	}
+
+	test_load_queue_inline();
+	test_load_queue_priority();
+	test_load_queue_eviction();
+	test_load_queue_destroy_all();
+	test_load_queue_dedup();
+	test_load_queue_workers();
+}
@@ -9,6 +9,8 @@
 
 #include "engine/picture.h"
 
+#include "foundation/allocator.h"
+
 #include "foundation/math.h"
 #include "foundation/file.h"
 
@@ -277,4 +279,36 @@ void test_picture() {
 		}
 		TEST_CHECK(ok == true);
 	}
-}
\ No newline at end of file
+
+	{
+		const MemoryStats stats = GetMemoryStats(MT_Picture);
+		{
+			Picture pic(16, 16, PF_RGBA32);
+			TEST_CHECK(GetMemoryStats(MT_Picture).live_size == stats.live_size + 16 * 16 * 4);
+
+			Picture copy(pic);
+			TEST_CHECK(GetMemoryStats(MT_Picture).live_count == stats.live_count + 2);
+		}
+		TEST_CHECK(GetMemoryStats(MT_Picture).live_size == stats.live_size);
+	}
+
+#if __cplusplus >= 201103L
+	{
+		Picture pic0(16, 16, PF_RGBA32);
+		const uint8_t *data = pic0.GetData();
+
+		Picture pic1(std::move(pic0));
+		TEST_CHECK(pic1.GetData() == data);
+		TEST_CHECK(pic1.HasDataOwnership());
+		TEST_CHECK(pic0.GetData() == nullptr);
+		TEST_CHECK(pic0.IsValid() == false);
+
+		Picture pic2;
+		pic2 = std::move(pic1);
+		TEST_CHECK(pic2.GetData() == data);
+		TEST_CHECK(pic2.GetWidth() == 16);
+		TEST_CHECK(pic2.GetFormat() == PF_RGBA32);
+		TEST_CHECK(pic1.IsValid() == false);
+	}
+#endif
+}
@@ -3,8 +3,11 @@
 #define TEST_NO_MAIN
 #include "acutest.h"
 
+#include "engine/geometry.h"
 #include "engine/resource_cache.h"
 
+#include <fmt/format.h>
+
 using namespace hg;
 
 struct Dummy {
@@ -30,6 +33,12 @@ static void Destroy(Dummy& d) {
 
 typedef ResourceRef<Dummy> DummyRef;
 
+static int destroyed[8];
+
+static void DestroyCounted(int &v) { ++destroyed[v]; }
+
+static void Destroy(Geometry &geo) {}
+
 void test_resource_cache() {
 	{
 		ResourceRef<int> r0;
@@ -128,4 +137,227 @@ void test_resource_cache() {
 	cache.DestroyAll();
 	TEST_CHECK(cache.GetCount() == 0);
 	TEST_CHECK(cache.Get(ref2).IsValid() == false);
-}
\ No newline at end of file
+
+	{
+		ResourceCache<Dummy> lru(Destroy);
+		TEST_CHECK(lru.Evict() == 0);
+
+		DummyRef a = lru.Add("a", Dummy(1));
+		DummyRef b = lru.Add("b", Dummy(2));
+		DummyRef c = lru.Add("c", Dummy(3));
+		DummyRef d = lru.Add("d", Dummy(4));
+
+		lru.SetSize(a, 100);
+		lru.SetSize(b, 200);
+		lru.SetSize(c, 300);
+		lru.SetSize(d, 400);
+		TEST_CHECK(lru.GetSize(c) == 300);
+		TEST_CHECK(lru.GetTotalSize() == 1000);
+
+		lru.SetSize(d, 50);
+		TEST_CHECK(lru.GetTotalSize() == 650);
+
+		lru.SetBudget(650);
+		TEST_CHECK(lru.GetBudget() == 650);
+		TEST_CHECK(lru.Evict() == 0); // within budget
+
+		lru.Touch(a); // b is now the least recently used
+		lru.Pin(b);
+		lru.Pin(b);
+		TEST_CHECK(lru.IsPinned(b));
+
+		lru.SetBudget(400);
+		TEST_CHECK(lru.Evict() == 1); // c, b is pinned
+		TEST_CHECK(lru.IsValidRef(c) == false);
+		TEST_CHECK(lru.Has("c") == DummyRef());
+		TEST_CHECK(lru.IsValidRef(b) && lru.IsValidRef(a) && lru.IsValidRef(d));
+		TEST_CHECK(lru.GetTotalSize() == 350);
+
+		lru.Unpin(b);
+		TEST_CHECK(lru.IsPinned(b)); // pinned twice
+		lru.Unpin(b);
+		TEST_CHECK(lru.IsPinned(b) == false);
+
+		lru.SetBudget(100);
+		TEST_CHECK(lru.Evict() == 2); // b then d
+		TEST_CHECK(lru.IsValidRef(a) == true);
+		TEST_CHECK(lru.IsValidRef(b) == false);
+		TEST_CHECK(lru.IsValidRef(d) == false);
+		TEST_CHECK(lru.GetTotalSize() == 100);
+
+		lru.SetBudget(0);
+		DummyRef e = lru.Add("e", Dummy(5)); // no size, nothing to free
+		TEST_CHECK(lru.Evict() == 1);
+		TEST_CHECK(lru.IsValidRef(e) == true);
+		TEST_CHECK(lru.GetTotalSize() == 0);
+
+		lru.SetSize(e, 10);
+		lru.Destroy(e);
+		TEST_CHECK(lru.GetTotalSize() == 0);
+	}
+
+	{
+		ResourceCache<Dummy> rc(Destroy);
+
+		DummyRef a = rc.Add("a", Dummy(1));
+		DummyRef b = rc.Add("b", Dummy(2));
+
+		rc.AddRef(a);
+		rc.AddRef(a);
+		rc.AddRef(b);
+		TEST_CHECK(rc.GetRefCount(a) == 2);
+
+		rc.SetSize(a, 10);
+		rc.SetBudget(0);
+		TEST_CHECK(rc.Evict() == 0); // referenced
+
+		rc.Release(a);
+		rc.Release(b);
+		TEST_CHECK(rc.GetRefCount(a) == 1);
+		TEST_CHECK(rc.GetRefCount(b) == 0);
+		TEST_CHECK(rc.IsValidRef(b)); // deferred
+
+		rc.Release(a);
+		rc.AddRef(a); // referenced again before the release
+		rc.Pin(b);
+		TEST_CHECK(rc.DestroyReleased() == 0);
+		TEST_CHECK(rc.IsValidRef(a) && rc.IsValidRef(b));
+
+		rc.Unpin(b);
+		TEST_CHECK(rc.DestroyReleased() == 1); // pinned resources stay released
+		TEST_CHECK(rc.IsValidRef(b) == false);
+
+		rc.Release(a);
+		TEST_CHECK(rc.DestroyReleased() == 1);
+		TEST_CHECK(rc.IsValidRef(a) == false);
+
+		rc.Release(a); // invalid
+		TEST_CHECK(rc.GetRefCount(a) == 0);
+	}
+
+	{
+		ResourceCache<Dummy> names(Destroy);
+
+		std::vector<DummyRef> refs(1000);
+		for (int i = 0; i < 1000; ++i)
+			refs[i] = names.Add(fmt::format("res_{}", i), Dummy(i));
+
+		bool all_found = true;
+		for (int i = 0; i < 1000; ++i)
+			all_found &= names.Has(fmt::format("res_{}", i)) == refs[i] && names.Add(fmt::format("res_{}", i), Dummy(-1)) == refs[i];
+		TEST_CHECK(all_found);
+		TEST_CHECK(names.GetCount() == 1000);
+
+		for (int i = 0; i < 1000; i += 3)
+			names.Destroy(refs[i]);
+
+		bool removed_ok = true;
+		for (int i = 0; i < 1000; ++i)
+			removed_ok &= i % 3 ? names.Has(fmt::format("res_{}", i)) == refs[i] : names.Has(fmt::format("res_{}", i)) == DummyRef();
+		TEST_CHECK(removed_ok);
+
+		for (int i = 0; i < 1000; i += 3)
+			refs[i] = names.Add(fmt::format("res_{}", i), Dummy(i));
+
+		bool readded_ok = true;
+		for (int i = 0; i < 1000; ++i)
+			readded_ok &= names.Has(fmt::format("res_{}", i)) == refs[i] && names.Get(fmt::format("res_{}", i)).v == i;
+		TEST_CHECK(readded_ok);
+
+		names.SetName(refs[1], "renamed");
+		TEST_CHECK(names.Has("res_1") == DummyRef());
+		TEST_CHECK(names.Has("renamed") == refs[1]);
+
+		names.SetName(refs[2], "renamed"); // already used, not indexed
+		TEST_CHECK(names.Has("renamed") == refs[1]);
+		TEST_CHECK(names.Has("res_2") == DummyRef());
+
+		names.Destroy(refs[2]);
+		TEST_CHECK(names.Has("renamed") == refs[1]);
+
+		names.DestroyAll();
+		TEST_CHECK(names.Has("res_4") == DummyRef());
+		TEST_CHECK(names.IsValidRef(names.Add("res_4", Dummy(4))));
+	}
+
+	{
+		std::fill_n(destroyed, 8, 0);
+
+		ResourceCache<int> shared(DestroyCounted);
+
+		const std::string text = "content";
+		const std::vector<uint8_t> content(text.begin(), text.end()), other(text.rbegin(), text.rend());
+
+		std::vector<uint8_t> registered = content;
+		ResourceRef<int> a = shared.Add("a", 1);
+		shared.SetSize(a, 100);
+		shared.SetContentHash(a, 0x1234, registered);
+		TEST_CHECK(shared.HasContentHash(a));
+		TEST_CHECK(shared.GetSize(a) == 100);
+
+		ResourceRef<int> b = shared.Add("b", 2);
+		shared.SetSize(b, 100);
+		TEST_CHECK(shared.ShareContent(b, 0x5678, content) == false); // unknown content
+		TEST_CHECK(shared.ShareContent(b, 0x1234, other) == false); // hash collision, different content
+		TEST_CHECK(shared.Get(b) == 2 && destroyed[2] == 0);
+		TEST_CHECK(shared.ShareContent(b, 0x1234, content) == true);
+		TEST_CHECK(destroyed[2] == 1); // own payload released
+		TEST_CHECK(shared.Get(b) == 1);
+		TEST_CHECK(shared.GetSize(b) == 100);
+		TEST_CHECK(shared.GetTotalSize() == 100);
+		TEST_CHECK(shared.GetSharedSize() == 100);
+
+		ResourceRef<int> c = shared.Add("c", 0);
+		TEST_CHECK(shared.ShareContent(c, 0x1234, content));
+		TEST_CHECK(shared.GetSharedSize() == 200);
+
+		shared.SetSize(c, 50); // the shared payload size
+		TEST_CHECK(shared.GetSize(a) == 50);
+		TEST_CHECK(shared.GetTotalSize() == 50);
+		TEST_CHECK(shared.GetSharedSize() == 100);
+
+		shared.Destroy(a);
+		TEST_CHECK(destroyed[1] == 0);
+		TEST_CHECK(shared.Get(c) == 1);
+
+		shared.SetBudget(0);
+		shared.Touch(c);
+		TEST_CHECK(shared.Evict() == 2); // payload released by the last user
+		TEST_CHECK(destroyed[1] == 1);
+		TEST_CHECK(shared.GetTotalSize() == 0);
+		TEST_CHECK(shared.GetSharedSize() == 0);
+
+		registered = content;
+		ResourceRef<int> d = shared.Add("d", 3);
+		shared.SetContentHash(d, 0x1234, registered);
+		ResourceRef<int> e = shared.Add("e", 4);
+		TEST_CHECK(shared.ShareContent(e, 0x1234, content));
+		shared.Update(e, 5); // no longer shared
+		TEST_CHECK(shared.HasContentHash(e) == false);
+		TEST_CHECK(destroyed[3] == 0 && destroyed[4] == 1);
+
+		shared.DestroyAll();
+		TEST_CHECK(destroyed[3] == 1 && destroyed[5] == 1);
+	}
+
+#if __cplusplus >= 201103L
+	{
+		ResourceCache<Geometry> geos(Destroy);
+
+		Geometry geo;
+		geo.vtx.resize(1024);
+		const Vec3 *vtx = geo.vtx.data();
+
+		ResourceRef<Geometry> ref = geos.Add("geo", std::move(geo)); // loaded resources are moved into the cache
+		TEST_CHECK(geos.Get(ref).vtx.data() == vtx);
+		TEST_CHECK(geo.vtx.empty());
+
+		Geometry update;
+		update.vtx.resize(16);
+		vtx = update.vtx.data();
+
+		geos.Update(ref, std::move(update));
+		TEST_CHECK(geos.Get(ref).vtx.data() == vtx);
+	}
+#endif
+}
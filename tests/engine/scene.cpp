@@ -5,10 +5,23 @@
 
 #include "engine/scene.h"
 
+#include "foundation/allocator.h"
+#include "foundation/data_rw_interface.h"
+#include "foundation/dir.h"
+#include "foundation/file.h"
+#include "foundation/file_rw_interface.h"
+#include "foundation/frame_arena.h"
 #include "foundation/log.h"
+#include "foundation/path_tools.h"
 
 #include "engine/file_format.h"
 
+#include "../utils.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <map>
+
 using namespace hg;
 
 static void on_log(const std::string &, int mask, const std::string &, void *user) {
@@ -175,7 +188,730 @@ static void test_scene_binary_serialization() {
 	}
 }
 
+static void test_scene_json_serialization() {
+	const std::string path = PathJoin(hg::test::GetTempDirectoryName(), "scene_json.scn");
+
+	PipelineResources resources;
+	PipelineInfo pipeline;
+
+	{
+		Scene scene;
+		Node root = scene.CreateNode("root");
+		root.SetTransform(scene.CreateTransform(Vec3(1, 2, 3)));
+		Node child = scene.CreateNode("child");
+		child.SetTransform(scene.CreateTransform(Vec3(0, 1, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+		child.SetScript(0, scene.CreateScript("child.lua"));
+		TEST_CHECK(SaveSceneJsonToFile(path, scene, resources));
+	}
+
+	{
+		Scene scene;
+		LoadSceneContext ctx;
+		TEST_CHECK(LoadSceneJsonFromFile(path, scene, resources, pipeline, ctx));
+		TEST_CHECK(ctx.view.nodes.size() == 2);
+
+		const Node child = scene.GetNode("child");
+		TEST_CHECK(child.IsValid());
+		TEST_CHECK(child.GetTransform().GetParent() == scene.GetNode("root").ref);
+		TEST_CHECK(child.GetName() == "child");
+		TEST_CHECK(scene.GetNode("no node is named so").IsValid() == false);
+		TEST_CHECK(scene.GetNodeEx("root/child").ref == child.ref);
+		TEST_CHECK(scene.GetNodeScriptCount(child.ref) == 1);
+		TEST_CHECK(scene.GetNodeScript(child.ref, 0).GetPath() == "child.lua");
+	}
+
+	Unlink(path);
+}
+
+//
+static void save_instance_prototype_scenes(const std::string &prop_path, const std::string &outer_path, const std::string &prop_child_name) {
+	PipelineResources resources;
+
+	{
+		Scene scene;
+
+		Node root = scene.CreateNode("root");
+		root.SetTransform(scene.CreateTransform(Vec3(1, 2, 3)));
+
+		Node child = scene.CreateNode(prop_child_name);
+		child.SetTransform(scene.CreateTransform(Vec3(0, 1, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+		child.SetCollision(0, scene.CreateSphereCollision(0.5f, 1.f));
+		child.SetScript(0, scene.CreateScript("prop.lua"));
+
+		Anim anim;
+		anim.t_end = time_from_sec(1);
+
+		SceneAnim scene_anim;
+		scene_anim.name = "spin";
+		scene_anim.t_end = time_from_sec(1);
+
+		NodeAnim node_anim;
+		node_anim.node = child.ref;
+		node_anim.anim = scene.AddAnim(anim);
+		scene_anim.node_anims.push_back(node_anim);
+		scene.AddSceneAnim(scene_anim);
+
+		TEST_CHECK(SaveSceneBinaryToFile(prop_path, scene, resources, LSSF_AllNodeFeatures));
+	}
+
+	{
+		Scene scene;
+
+		Node node = scene.CreateNode("outer");
+		node.SetTransform(scene.CreateTransform(Vec3(0, 0, 5)));
+
+		Node host = scene.CreateNode("outer_prop");
+		host.SetTransform(scene.CreateTransform(Vec3(2, 0, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), node.ref));
+		Instance instance = scene.CreateInstance(prop_path);
+		scene.SetOnInstantiateAnim(instance.ref, "spin");
+		host.SetInstance(instance);
+
+		TEST_CHECK(SaveSceneBinaryToFile(outer_path, scene, resources, LSSF_AllNodeFeatures));
+	}
+}
+
+static std::vector<std::string> describe_scene(const Scene &scene) {
+	std::vector<std::string> desc;
+
+	const std::vector<Node> nodes = scene.GetAllNodes();
+	for (std::vector<Node>::const_iterator i = nodes.begin(); i != nodes.end(); ++i) {
+		const Vec3 pos = GetT(scene.GetNodeWorldMatrix(i->ref));
+		const NodeRef host = scene.IsInstantiatedBy(i->ref);
+
+		std::string scripts;
+		for (size_t j = 0; j < scene.GetNodeScriptCount(i->ref); ++j)
+			scripts += scene.GetNodeScript(i->ref, j).GetPath() + ";";
+
+		const NodeRef parent = i->GetTransform().GetParent();
+
+		desc.push_back(fmt::format("{}|{}|{}|{:.3f},{:.3f},{:.3f}|{}|{}|{}", i->GetName(), scene.IsValidNodeRef(parent) ? scene.GetNodeName(parent) : "",
+			scene.IsValidNodeRef(host) ? scene.GetNodeName(host) : "", pos.x, pos.y, pos.z, scene.GetNodeFlags(i->ref), scene.GetNodeCollisionCount(i->ref),
+			scripts));
+	}
+
+	desc.push_back(fmt::format("anims:{} scene_anims:{} playing:{}", scene.GetAnims().size(), scene.GetSceneAnims().size(), scene.GetPlayingAnimRefs().size()));
+
+	std::sort(desc.begin(), desc.end());
+	return desc;
+}
+
+static std::vector<std::string> instantiate_and_describe(const std::string &path, int count, bool use_cache) {
+	EnableInstancePrototypeCache(use_cache);
+
+	Scene scene;
+	PipelineResources resources;
+	PipelineInfo pipeline;
+
+	for (int i = 0; i < count; ++i) {
+		Node host = scene.CreateNode(fmt::format("host_{}", i));
+		host.SetTransform(scene.CreateTransform(Vec3(float(i), 0, 0)));
+		host.SetInstance(scene.CreateInstance(path));
+		TEST_CHECK(scene.NodeSetupInstanceFromFile(host.ref, resources, pipeline));
+		scene.NodeStartOnInstantiateAnim(host.ref);
+	}
+
+	scene.Update(0);
+	return describe_scene(scene);
+}
+
+static void save_json_cache_scene(const std::string &path, const std::string &child_name) {
+	PipelineResources resources;
+
+	Scene scene;
+	Node root = scene.CreateNode("root");
+	root.SetTransform(scene.CreateTransform(Vec3(1, 2, 3)));
+	Node child = scene.CreateNode(child_name);
+	child.SetTransform(scene.CreateTransform(Vec3(0, 1, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+	child.SetCollision(0, scene.CreateSphereCollision(0.5f, 1.f));
+	child.SetScript(0, scene.CreateScript("child.lua"));
+	TEST_CHECK(SaveSceneJsonToFile(path, scene, resources));
+}
+
+static std::vector<std::string> load_json_cache_scene(const std::string &path) {
+	Scene scene;
+	PipelineResources resources;
+	PipelineInfo pipeline;
+	LoadSceneContext ctx;
+	TEST_CHECK(LoadSceneJsonFromFile(path, scene, resources, pipeline, ctx));
+	TEST_CHECK(ctx.view.nodes.size() == 2);
+	return describe_scene(scene);
+}
+
+static void test_scene_json_binary_cache() {
+	const std::string path = PathJoin(hg::test::GetTempDirectoryName(), "scene_json_cache.scn");
+	const std::string cache_dir = PathJoin(hg::test::GetTempDirectoryName(), "scene_json_cache");
+
+	RmTree(cache_dir);
+	TEST_CHECK(MkTree(cache_dir));
+
+	save_json_cache_scene(path, "child");
+
+	const std::vector<std::string> uncached = load_json_cache_scene(path);
+
+	SetSceneJsonBinaryCacheDirectory(cache_dir);
+	TEST_CHECK(GetSceneJsonBinaryCacheDirectory() == cache_dir);
+
+	TEST_CHECK(load_json_cache_scene(path) == uncached); // miss, write cache
+
+	std::vector<DirEntry> entries = ListDir(cache_dir, DE_File);
+	TEST_CHECK(entries.size() == 1);
+
+	TEST_CHECK(load_json_cache_scene(path) == uncached); // hit
+	TEST_CHECK(ListDir(cache_dir, DE_File).size() == 1);
+
+	// an invalid cache entry is discarded and written again
+	if (!entries.empty()) {
+		const std::string cache_path = PathJoin(cache_dir, entries[0].name);
+		TEST_CHECK(StringToFile(cache_path, "not a binary scene"));
+		TEST_CHECK(load_json_cache_scene(path) == uncached);
+		TEST_CHECK(IsBinarySceneFile(cache_path));
+	}
+
+	// loading to a non-empty scene keeps its content out of the cache
+	RmTree(cache_dir);
+	TEST_CHECK(MkTree(cache_dir));
+	{
+		Scene scene;
+		PipelineResources resources;
+		PipelineInfo pipeline;
+		LoadSceneContext ctx;
+		scene.CreateNode("existing");
+		TEST_CHECK(LoadSceneJsonFromFile(path, scene, resources, pipeline, ctx));
+		TEST_CHECK(scene.GetAllNodeCount() == 3);
+		TEST_CHECK(ListDir(cache_dir, DE_File).size() == 1);
+		TEST_CHECK(load_json_cache_scene(path) == uncached);
+	}
+
+	// editing the scene misses the cache
+	save_json_cache_scene(path, "edited_child");
+	const std::vector<std::string> edited = load_json_cache_scene(path);
+	TEST_CHECK(edited != uncached);
+	TEST_CHECK(ListDir(cache_dir, DE_File).size() == 2);
+
+	SetSceneJsonBinaryCacheDirectory(std::string());
+	TEST_CHECK(load_json_cache_scene(path) == edited);
+
+	RmTree(cache_dir);
+	Unlink(path);
+}
+
+// nested JSON instance loads reuse the load contexts of the outermost load
+static void test_scene_json_nested_instances() {
+	const std::string prop_path = PathJoin(hg::test::GetTempDirectoryName(), "json_nested_prop.scn");
+	const std::string outer_path = PathJoin(hg::test::GetTempDirectoryName(), "json_nested_outer.scn");
+	const std::string hosts_path = PathJoin(hg::test::GetTempDirectoryName(), "json_nested_hosts.scn");
+
+	PipelineResources resources;
+	PipelineInfo pipeline;
+
+	save_json_cache_scene(prop_path, "child");
+
+	{
+		Scene scene;
+		Node outer = scene.CreateNode("outer");
+		outer.SetTransform(scene.CreateTransform());
+		outer.SetInstance(scene.CreateInstance(prop_path));
+		TEST_CHECK(SaveSceneJsonToFile(outer_path, scene, resources));
+	}
+
+	{
+		Scene scene;
+		for (int i = 0; i < 3; ++i) {
+			Node host = scene.CreateNode(fmt::format("host_{}", i));
+			host.SetTransform(scene.CreateTransform(Vec3(float(i), 0, 0)));
+			host.SetInstance(scene.CreateInstance(outer_path));
+		}
+		TEST_CHECK(SaveSceneJsonToFile(hosts_path, scene, resources));
+	}
+
+	for (int use_cache = 0; use_cache < 2; ++use_cache) {
+		EnableInstancePrototypeCache(use_cache != 0);
+
+		Scene scene;
+		LoadSceneContext ctx;
+		TEST_CHECK(LoadSceneJsonFromFile(hosts_path, scene, resources, pipeline, ctx));
+		TEST_CHECK(ctx.view.nodes.size() == 3);
+		TEST_CHECK(scene.GetAllNodeCount() == 3 * 4); // hosts + outer, root, child
+
+		for (int i = 0; i < 3; ++i)
+			TEST_CHECK(scene.GetNode(fmt::format("host_{}", i)).IsValid());
+	}
+
+	EnableInstancePrototypeCache(true);
+
+	Unlink(prop_path);
+	Unlink(outer_path);
+	Unlink(hosts_path);
+}
+
+static std::map<std::string, int> counted_opens;
+
+static Handle counted_open(const std::string &path, bool silent) {
+	++counted_opens[path];
+	return g_file_read_provider.open(path, silent);
+}
+
+static void test_instance_prototype_cache() {
+	const std::string prop_path = PathJoin(hg::test::GetTempDirectoryName(), "prototype_prop.scn");
+	const std::string outer_path = PathJoin(hg::test::GetTempDirectoryName(), "prototype_outer.scn");
+
+	save_instance_prototype_scenes(prop_path, outer_path, "child");
+
+	ClearInstancePrototypeCache();
+
+	{
+		const std::vector<std::string> direct = instantiate_and_describe(outer_path, 8, false);
+		const std::vector<std::string> cached = instantiate_and_describe(outer_path, 8, true);
+
+		TEST_CHECK(GetInstancePrototypeCacheSize() == 2); // outer and nested prop
+		TEST_CHECK(direct.size() == 8 * 4 + 8 + 1); // hosts + outer, outer_prop, root, child + summary
+		TEST_CHECK(direct == cached);
+
+		// prototypes are keyed by resources identity, not address, new resources never hit those of destroyed ones
+		TEST_CHECK(instantiate_and_describe(outer_path, 1, true).size() == 1 * 4 + 1 + 1);
+		TEST_CHECK(GetInstancePrototypeCacheSize() == 4);
+	}
+
+	// a cache hit across loads gives the same result
+	TEST_CHECK(instantiate_and_describe(outer_path, 3, true) == instantiate_and_describe(outer_path, 3, false));
+
+	// editing the source invalidates its prototype
+	save_instance_prototype_scenes(prop_path, outer_path, "edited_child");
+
+	{
+		const std::vector<std::string> cached = instantiate_and_describe(outer_path, 2, true);
+		TEST_CHECK(cached == instantiate_and_describe(outer_path, 2, false));
+
+		bool has_edited_child = false;
+		for (std::vector<std::string>::const_iterator i = cached.begin(); i != cached.end(); ++i)
+			if (i->find("edited_child|") == 0)
+				has_edited_child = true;
+		TEST_CHECK(has_edited_child);
+	}
+
+	EnableInstancePrototypeCache(true);
+	TEST_CHECK(GetInstancePrototypeCacheSize() == 0);
+
+	// instances of the same source only read it once per load
+	{
+		PipelineResources resources;
+		PipelineInfo pipeline;
+
+		Scene scene;
+		for (int i = 0; i < 8; ++i) {
+			Node host = scene.CreateNode(fmt::format("host_{}", i));
+			host.SetTransform(scene.CreateTransform(Vec3(float(i), 0, 0)));
+			host.SetInstance(scene.CreateInstance(outer_path));
+		}
+
+		Data data;
+		TEST_CHECK(SaveSceneBinaryToData(data, scene, resources, LSSF_AllNodeFeatures));
+
+		ReadProvider counted_read_provider = g_file_read_provider;
+		counted_read_provider.open = counted_open;
+
+		for (int load = 0; load < 2; ++load) {
+			counted_opens.clear();
+
+			Scene loaded;
+			LoadSceneContext ctx;
+			data.Rewind();
+			TEST_CHECK(LoadSceneBinaryFromData(data, "hosts", loaded, g_file_reader, counted_read_provider, resources, pipeline, ctx, LSSF_AllNodeFeatures));
+			TEST_CHECK(loaded.GetAllNodes().size() == 8 * 5); // hosts + outer, outer_prop, root, child
+			TEST_CHECK(counted_opens[outer_path] == 1);
+			TEST_CHECK(counted_opens[prop_path] == 1);
+		}
+	}
+
+	Unlink(prop_path);
+	Unlink(outer_path);
+}
+
+static std::vector<NodeRef> create_duplicate_test_scene(Scene &scene, const std::string &prop_path, PipelineResources &resources, const PipelineInfo &pipeline) {
+	Node root = scene.CreateNode("root");
+	root.SetTransform(scene.CreateTransform(Vec3(1, 0, 0)));
+
+	Node child = scene.CreateNode("child");
+	child.SetTransform(scene.CreateTransform(Vec3(0, 2, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+	child.SetCollision(0, scene.CreateSphereCollision(0.5f, 1.f));
+	child.SetCollision(1, scene.CreateCubeCollision(1.f, 1.f, 1.f, 1.f));
+	child.SetScript(0, scene.CreateScript("child.lua"));
+
+	Node orphan = scene.CreateNode("orphan"); // parent is not part of the selection
+	orphan.SetTransform(scene.CreateTransform(Vec3(0, 0, 3), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+
+	Node disabled = scene.CreateNode("disabled");
+	disabled.SetTransform(scene.CreateTransform(Vec3(4, 0, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), child.ref));
+	disabled.Disable();
+
+	Node host = scene.CreateNode("host");
+	host.SetTransform(scene.CreateTransform(Vec3(0, 5, 0), Vec3(0, 0, 0), Vec3(1, 1, 1), root.ref));
+	Instance instance = scene.CreateInstance(prop_path);
+	scene.SetOnInstantiateAnim(instance.ref, "spin");
+	host.SetInstance(instance);
+	TEST_CHECK(scene.NodeSetupInstanceFromFile(host.ref, resources, pipeline));
+	scene.NodeStartOnInstantiateAnim(host.ref);
+
+	scene.Update(0);
+
+	std::vector<NodeRef> refs;
+	refs.push_back(child.ref);
+	refs.push_back(orphan.ref);
+	refs.push_back(disabled.ref);
+	refs.push_back(host.ref);
+	refs.push_back(scene.GetNodeChildRefs(host.ref)[0]); // instantiated nodes are skipped
+	refs.push_back(root.ref);
+	return refs;
+}
+
+static void test_duplicate_nodes() {
+	const std::string prop_path = PathJoin(hg::test::GetTempDirectoryName(), "duplicate_prop.scn");
+	const std::string outer_path = PathJoin(hg::test::GetTempDirectoryName(), "duplicate_outer.scn");
+
+	save_instance_prototype_scenes(prop_path, outer_path, "prop_child");
+
+	PipelineResources resources;
+	PipelineInfo pipeline;
+
+	// reference: round-trip through the binary format
+	Scene ref_scene;
+	std::vector<NodeRef> ref_dups;
+	{
+		const std::vector<NodeRef> refs = create_duplicate_test_scene(ref_scene, prop_path, resources, pipeline);
+
+		Data data;
+		TEST_CHECK(ref_scene.SaveNodes_binary(g_data_writer, DataWriteHandle(data), refs, resources));
+		data.Rewind();
+
+		LoadSceneContext ctx;
+		TEST_CHECK(ref_scene.LoadNodes_binary(g_data_reader, DataReadHandle(data), "DuplicateNodes", g_file_reader, g_file_read_provider, resources, pipeline, ctx));
+		ref_dups = ctx.view.nodes;
+		ref_scene.Update(0);
+	}
+
+	Scene scene;
+	const std::vector<NodeRef> refs = create_duplicate_test_scene(scene, prop_path, resources, pipeline);
+	const std::vector<NodeRef> dups = DuplicateNodes(scene, refs, g_file_reader, g_file_read_provider, resources, pipeline);
+	scene.Update(0);
+
+	TEST_CHECK(dups.size() == 5);
+	TEST_CHECK(dups.size() == ref_dups.size());
+
+	for (size_t i = 0; i < dups.size() && i < ref_dups.size(); ++i)
+		TEST_CHECK(scene.GetNodeName(dups[i]) == ref_scene.GetNodeName(ref_dups[i]));
+
+	TEST_CHECK(describe_scene(scene) == describe_scene(ref_scene));
+
+	// duplicates do not share components with their source
+	TEST_CHECK(scene.GetNode(dups[0]).GetTransform().ref != scene.GetNode(refs[0]).GetTransform().ref);
+	TEST_CHECK(scene.GetNodeCollision(dups[0], 1).ref != scene.GetNodeCollision(refs[0], 1).ref);
+	TEST_CHECK(scene.GetNodeScript(dups[0], 0).ref != scene.GetNodeScript(refs[0], 0).ref);
+
+	Unlink(prop_path);
+	Unlink(outer_path);
+}
+
+static void test_create_destroy_nodes() {
+	Scene scene;
+
+	const std::vector<NodeRef> refs = scene.CreateNodes(100, NCM_Transform | NCM_Object, "node");
+	TEST_CHECK(refs.size() == 100);
+	TEST_CHECK(scene.GetNodeCount() == 100);
+	TEST_CHECK(scene.GetNodesWithComponent(NCI_Transform).size() == 100);
+	TEST_CHECK(scene.GetNodesWithComponent(NCI_Object).size() == 100);
+	TEST_CHECK(scene.GetNodesWithComponent(NCI_Camera).empty());
+
+	const Node node = scene.GetNode(refs[50]);
+	TEST_CHECK(node.GetName() == "node");
+	TEST_CHECK(node.GetTransform().IsValid());
+	TEST_CHECK(node.GetTransform().GetWorld() == Mat4::Identity);
+
+	TEST_CHECK(scene.GarbageCollect() == 0); // all components are referenced
+
+	scene.DestroyNodes(std::vector<NodeRef>(refs.begin(), refs.begin() + 50));
+	TEST_CHECK(scene.GetNodeCount() == 50);
+	TEST_CHECK(scene.GarbageCollect() == 100);
+	TEST_CHECK(node.GetTransform().IsValid());
+
+	scene.DestroyNodes(refs);
+	TEST_CHECK(scene.GetNodeCount() == 0);
+	TEST_CHECK(scene.GarbageCollect() == 100);
+}
+
+static void test_garbage_collect() {
+	{
+		Scene scene;
+
+		Node a = scene.CreateNode("a");
+		Node b = scene.CreateNode("b");
+
+		Transform trs = scene.CreateTransform();
+		a.SetTransform(trs);
+		b.SetTransform(trs); // shared
+
+		Camera cam = scene.CreateCamera();
+		b.SetCamera(cam);
+
+		Collision col = scene.CreateSphereCollision(1.f, 1.f);
+		a.SetCollision(0, col);
+		b.SetCollision(0, col); // shared
+
+		Script script = scene.CreateScript("a.lua");
+		a.SetScript(0, script);
+
+		Script scene_script = scene.CreateScript("scene.lua");
+		scene.SetScript(0, scene_script);
+
+		Transform orphan = scene.CreateTransform();
+
+		TEST_CHECK(scene.IsGarbageCollectPending());
+		TEST_CHECK(scene.GarbageCollect() == 1);
+		TEST_CHECK(!scene.IsValidTransformRef(orphan.ref));
+		TEST_CHECK(!scene.IsGarbageCollectPending());
+
+		scene.DestroyNode(a.ref);
+		TEST_CHECK(scene.GarbageCollect() == 1); // script
+		TEST_CHECK(!scene.IsValidScriptRef(script.ref));
+		TEST_CHECK(scene.IsValidTransformRef(trs.ref));
+		TEST_CHECK(scene.IsValidCollisionRef(col.ref));
+
+		scene.DestroyNode(b.ref);
+		TEST_CHECK(scene.GarbageCollect() == 3); // transform, camera and collision
+		TEST_CHECK(!scene.IsValidTransformRef(trs.ref));
+		TEST_CHECK(!scene.IsValidCameraRef(cam.ref));
+		TEST_CHECK(!scene.IsValidCollisionRef(col.ref));
+		TEST_CHECK(scene.IsValidScriptRef(scene_script.ref));
+
+		// replaced component
+		Node c = scene.CreateNode("c");
+		Light l0 = scene.CreatePointLight(1.f), l1 = scene.CreatePointLight(2.f);
+		c.SetLight(l0);
+		c.SetLight(l1);
+		TEST_CHECK(scene.GarbageCollect() == 1);
+		TEST_CHECK(!scene.IsValidLightRef(l0.ref));
+		TEST_CHECK(scene.IsValidLightRef(l1.ref));
+
+		// component referenced again before collection
+		Node d = scene.CreateNode("d");
+		Transform t = scene.CreateTransform();
+		c.SetTransform(t);
+		c.SetTransform(Transform());
+		d.SetTransform(t);
+		TEST_CHECK(scene.GarbageCollect() == 0);
+		TEST_CHECK(scene.IsValidTransformRef(t.ref));
+
+		// explicitly destroyed collision still referenced by a node
+		Collision col2 = scene.CreateCubeCollision(1.f, 1.f, 1.f);
+		d.SetCollision(0, col2);
+		scene.DestroyCollision(col2.ref);
+		TEST_CHECK(scene.IsGarbageCollectPending());
+		scene.GarbageCollect();
+		TEST_CHECK(scene.GetNodeCollisionRef(d.ref, 0) == InvalidComponentRef);
+	}
+
+	// instance content is collected with its host
+	{
+		const std::string prop_path = PathJoin(hg::test::GetTempDirectoryName(), "gc_prop.scn");
+		const std::string outer_path = PathJoin(hg::test::GetTempDirectoryName(), "gc_outer.scn");
+
+		save_instance_prototype_scenes(prop_path, outer_path, "child");
+
+		Scene scene;
+		PipelineResources resources;
+		PipelineInfo pipeline;
+
+		Node host = scene.CreateNode("host");
+		host.SetTransform(scene.CreateTransform());
+		host.SetInstance(scene.CreateInstance(outer_path));
+		TEST_CHECK(scene.NodeSetupInstanceFromFile(host.ref, resources, pipeline));
+		scene.GarbageCollect();
+
+		TEST_CHECK(scene.GetAllNodeCount() == 5);
+
+		scene.DestroyNode(host.ref);
+		TEST_CHECK(scene.GarbageCollect() == 5 + 1 + 1 + 2); // transforms, collision, script, instance components
+		TEST_CHECK(scene.GetAllNodeCount() == 0);
+		TEST_CHECK(scene.GetAnims().empty());
+		TEST_CHECK(scene.GetSceneAnims().empty());
+
+		Unlink(prop_path);
+		Unlink(outer_path);
+	}
+
+	// time-budgeted collection
+	{
+		Scene scene;
+
+		std::vector<NodeRef> refs;
+		for (int i = 0; i < 4096; ++i) {
+			Node node = scene.CreateNode();
+			node.SetTransform(scene.CreateTransform());
+			refs.push_back(node.ref);
+		}
+
+		scene.GarbageCollect();
+
+		for (std::vector<NodeRef>::const_iterator i = refs.begin(); i != refs.end(); ++i)
+			scene.DestroyNode(*i);
+
+		size_t removed = 0, call_count = 0;
+		for (; scene.IsGarbageCollectPending(); ++call_count)
+			removed += scene.GarbageCollect(0);
+
+		TEST_CHECK(removed == 4096);
+		TEST_CHECK(call_count > 1);
+	}
+}
+
+static void test_memory_tags() {
+	const MemoryStats stats = GetMemoryStats(MT_Scene);
+
+	{
+		Scene scene;
+		scene.CreateNodes(1000, NCM_Transform | NCM_Object);
+		TEST_CHECK(GetMemoryStats(MT_Scene).live_size > stats.live_size); // scene storage is accounted to its subsystem
+	}
+
+	TEST_CHECK(GetMemoryStats(MT_Scene).live_size == stats.live_size);
+	TEST_CHECK(GetMemoryStats(MT_Scene).live_count == stats.live_count);
+}
+
+static void test_update_transient_allocations() {
+	Scene scene;
+
+	SceneAnim scene_anim;
+	scene_anim.t_end = time_from_sec(1);
+
+	for (int i = 0; i < 16; ++i)
+		scene.PlayAnim(scene.AddSceneAnim(scene_anim));
+	TEST_CHECK(scene.GetPlayingAnimNames().size() == 16);
+
+	ResetFrameArena();
+	void *mark = FrameAlloc(1);
+	ResetFrameArena();
+
+	scene.Update(time_from_sec(2)); // all animations end, transient clean list is allocated from the frame arena
+	TEST_CHECK(scene.GetPlayingAnimNames().empty());
+
+	const FrameArenaStats stats = GetFrameArenaStats();
+	TEST_CHECK(stats.alloc_count > 0);
+	TEST_CHECK(stats.peak_size >= 16 * sizeof(ScenePlayAnimRef));
+	TEST_CHECK(FrameAlloc(1) == mark); // released on return
+
+	ResetFrameArena();
+}
+
+static Material MakeTexturedMaterial(TextureRef tex) {
+	Material mat;
+	mat.textures["uDiffuseMap"].texture = tex;
+	return mat;
+}
+
+static void test_resource_refs() {
+	PipelineResources res;
+
+	const ModelRef shared_mdl = res.models.Add("shared.geo", Model());
+	const ModelRef level_mdl = res.models.Add("level.geo", Model());
+	const TextureRef shared_tex = res.textures.Add("shared.dds", Texture());
+	const TextureRef level_tex = res.textures.Add("level.dds", Texture());
+	const TextureRef brdf = res.textures.Add("brdf.dds", Texture());
+	const TextureRef unused_tex = res.textures.Add("unused.dds", Texture());
+
+	Scene hud;
+	hud.CreateObject(shared_mdl, std::vector<Material>(1, MakeTexturedMaterial(shared_tex)));
+	hud.UpdateResourceRefs(res);
+
+	Scene level;
+	level.CreateObject(shared_mdl, std::vector<Material>(1, MakeTexturedMaterial(level_tex)));
+	level.CreateObject(level_mdl, std::vector<Material>(2, MakeTexturedMaterial(shared_tex)));
+	level.SetProbe(TextureRef(), TextureRef(), brdf);
+	level.UpdateResourceRefs(res);
+	level.UpdateResourceRefs(res); // idempotent
+
+	TEST_CHECK(res.models.GetRefCount(shared_mdl) == 2);
+	TEST_CHECK(res.models.GetRefCount(level_mdl) == 1);
+	TEST_CHECK(res.textures.GetRefCount(shared_tex) == 2);
+	TEST_CHECK(res.textures.GetRefCount(level_tex) == 1);
+	TEST_CHECK(res.textures.GetRefCount(brdf) == 1);
+	TEST_CHECK(res.textures.GetRefCount(unused_tex) == 0);
+
+	// unloading the level frees exactly the resources it alone used
+	level.Clear(); // releases the references it held
+	TEST_CHECK(res.models.GetRefCount(level_mdl) == 0);
+	level.UpdateResourceRefs(res);
+
+	TEST_CHECK(res.models.GetRefCount(shared_mdl) == 1);
+	TEST_CHECK(res.models.IsValidRef(level_mdl)); // release is deferred
+
+	TEST_CHECK(DestroyReleasedResources(res) == 3);
+	TEST_CHECK(res.models.IsValidRef(shared_mdl));
+	TEST_CHECK(res.models.IsValidRef(level_mdl) == false);
+	TEST_CHECK(res.textures.IsValidRef(shared_tex));
+	TEST_CHECK(res.textures.IsValidRef(level_tex) == false);
+	TEST_CHECK(res.textures.IsValidRef(brdf) == false);
+	TEST_CHECK(res.textures.IsValidRef(unused_tex)); // never referenced
+
+	// a resource referenced again before the deferred release is kept
+	hud.ReleaseResourceRefs(res);
+	TEST_CHECK(res.models.GetRefCount(shared_mdl) == 0);
+	hud.UpdateResourceRefs(res);
+	TEST_CHECK(DestroyReleasedResources(res) == 0);
+	TEST_CHECK(res.models.GetRefCount(shared_mdl) == 1);
+	TEST_CHECK(res.textures.GetRefCount(shared_tex) == 1);
+
+	// removing an object releases its resources on the next update
+	Scene scene;
+	Node node = scene.CreateNode();
+	node.SetObject(scene.CreateObject(level_mdl, std::vector<Material>()));
+	const ModelRef mdl = res.models.Add("object.geo", Model());
+	node.GetObject().SetModelRef(mdl);
+	scene.UpdateResourceRefs(res);
+	TEST_CHECK(res.models.GetRefCount(mdl) == 1);
+
+	scene.DestroyNode(node);
+	scene.GarbageCollect();
+	scene.UpdateResourceRefs(res);
+	TEST_CHECK(DestroyReleasedResources(res) == 1);
+	TEST_CHECK(res.models.IsValidRef(mdl) == false);
+
+	// resources used by a scene are evicted after the ones it stopped using
+	const TextureRef old_tex = res.textures.Add("old.dds", Texture());
+	const TextureRef new_tex = res.textures.Add("new.dds", Texture());
+	res.textures.SetSize(old_tex, 16);
+	res.textures.SetSize(new_tex, 16);
+
+	Scene lru;
+	lru.CreateObject(ModelRef(), std::vector<Material>(1, MakeTexturedMaterial(old_tex)));
+	lru.UpdateResourceRefs(res);
+	lru.Clear();
+	lru.UpdateResourceRefs(res);
+
+	res.textures.SetBudget(res.textures.GetTotalSize() - 16);
+	TEST_CHECK(res.textures.Evict() == 1);
+	TEST_CHECK(res.textures.IsValidRef(old_tex));
+	TEST_CHECK(res.textures.IsValidRef(new_tex) == false);
+
+	// references are released when the scene is destroyed
+	{
+		Scene scoped;
+		scoped.CreateObject(ModelRef(), std::vector<Material>(1, MakeTexturedMaterial(old_tex)));
+		scoped.UpdateResourceRefs(res);
+		TEST_CHECK(res.textures.GetRefCount(old_tex) == 1);
+	}
+	TEST_CHECK(res.textures.GetRefCount(old_tex) == 0);
+}
+
 void test_scene() {
 	test_scene_binary_serialization();
+	test_scene_json_serialization();
+	test_scene_json_binary_cache();
+	test_scene_json_nested_instances();
+	test_instance_prototype_cache();
+	test_duplicate_nodes();
+	test_create_destroy_nodes();
+	test_garbage_collect();
+	test_memory_tags();
+	test_update_transient_allocations();
+	test_resource_refs();
 	// [todo]
 }
\ No newline at end of file
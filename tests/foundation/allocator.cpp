@@ -0,0 +1,97 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/allocator.h"
+#include "foundation/vector_list.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace hg;
+
+struct CountingAllocator {
+	int alloc_count, free_count;
+	MemoryTag last_tag;
+};
+
+static void *counting_alloc(size_t size, MemoryTag tag, void *user) {
+	CountingAllocator *a = reinterpret_cast<CountingAllocator *>(user);
+	++a->alloc_count;
+	a->last_tag = tag;
+	return malloc(size);
+}
+
+static void counting_free(void *p, size_t size, MemoryTag tag, void *user) {
+	++reinterpret_cast<CountingAllocator *>(user)->free_count;
+	free(p);
+}
+
+void test_allocator() {
+	TEST_CHECK(std::string(GetMemoryTagName(MT_Scene)) == "Scene");
+	TEST_CHECK(std::string(GetMemoryTagName(MT_Count)) == "Invalid");
+
+	{
+		const MemoryStats stats = GetMemoryStats(MT_Default);
+
+		void *p = Allocate(100);
+		TEST_CHECK(p != 0);
+		TEST_CHECK(GetMemoryStats(MT_Default).live_size == stats.live_size + 100);
+		TEST_CHECK(GetMemoryStats(MT_Default).live_count == stats.live_count + 1);
+		TEST_CHECK(GetMemoryStats(MT_Default).alloc_count == stats.alloc_count + 1);
+		TEST_CHECK(GetMemoryStats(MT_Default).peak_size >= stats.live_size + 100);
+
+		Deallocate(p, 100);
+		TEST_CHECK(GetMemoryStats(MT_Default).live_size == stats.live_size);
+		TEST_CHECK(GetMemoryStats(MT_Default).live_count == stats.live_count);
+		TEST_CHECK(GetMemoryStats(MT_Default).peak_size >= stats.live_size + 100); // peak is kept
+
+		Deallocate(0, 0); // no-op
+	}
+
+	{
+		const MemoryStats stats = GetMemoryStats(MT_Anim);
+		{
+			std::vector<float, tagged_allocator<float, MT_Anim> > v(256, 0.f);
+			TEST_CHECK(GetMemoryStats(MT_Anim).live_size == stats.live_size + 256 * sizeof(float));
+		}
+		TEST_CHECK(GetMemoryStats(MT_Anim).live_size == stats.live_size);
+	}
+
+	{
+		const MemoryStats stats = GetMemoryStats(MT_Resources);
+		{
+			vector_list<int> list;
+			TEST_CHECK(list.get_memory_tag() == MT_Containers);
+			list.set_memory_tag(MT_Resources);
+			list.add(1);
+			TEST_CHECK(GetMemoryStats(MT_Resources).live_size == stats.live_size + vector_list<int>::chunk_size * sizeof(int));
+
+			vector_list<int> copy(list); // the copy is accounted to the same tag
+			TEST_CHECK(GetMemoryStats(MT_Resources).live_count == stats.live_count + 2);
+
+			list.clear();
+			TEST_CHECK(GetMemoryStats(MT_Resources).live_count == stats.live_count + 1);
+		}
+		TEST_CHECK(GetMemoryStats(MT_Resources).live_size == stats.live_size);
+	}
+
+	{
+		const Allocator previous = GetAllocator(); // the counting allocator is compatible with the default one
+
+		CountingAllocator counting = {0, 0, MT_Default};
+		Allocator allocator = {counting_alloc, counting_free, &counting};
+		SetAllocator(allocator);
+
+		void *p = Allocate(16, MT_Picture);
+		TEST_CHECK(counting.alloc_count == 1);
+		TEST_CHECK(counting.last_tag == MT_Picture);
+		Deallocate(p, 16, MT_Picture);
+		TEST_CHECK(counting.free_count == 1);
+
+		SetAllocator(previous);
+		TEST_CHECK(GetAllocator().alloc == previous.alloc);
+	}
+}
@@ -0,0 +1,69 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/atom.h"
+
+#include <fmt/format.h>
+#include <map>
+
+using namespace hg;
+
+void test_atom() {
+	{
+		atom a;
+		TEST_CHECK(a.empty());
+		TEST_CHECK(a == atom(""));
+		TEST_CHECK(a == std::string());
+		TEST_CHECK(a.c_str()[0] == 0);
+	}
+
+	{
+		const size_t count = GetAtomCount();
+
+		const atom a("test.atom.a"), b(std::string("test.atom.") + "a"), c("test.atom.c");
+		TEST_CHECK(GetAtomCount() == count + 2);
+
+		TEST_CHECK(a == b);
+		TEST_CHECK(&a.str() == &b.str()); // shared storage
+		TEST_CHECK(a != c);
+		TEST_CHECK(a.hash() == b.hash());
+		TEST_CHECK(a.size() == 11);
+
+		TEST_CHECK(a == "test.atom.a");
+		TEST_CHECK("test.atom.c" == c);
+		TEST_CHECK(a != std::string("test.atom.c"));
+		TEST_CHECK(GetAtomCount() == count + 2); // comparing to a string does not intern it
+
+		const std::string &s = a;
+		TEST_CHECK(s == "test.atom.a");
+
+		TEST_CHECK((a < c) != (c < a));
+		TEST_CHECK((a < b) == false);
+	}
+
+	{
+		atom a;
+		TEST_CHECK(FindAtom("test.atom.never_interned", a) == false);
+		TEST_CHECK(a.empty());
+		TEST_CHECK(FindAtom("test.atom.a", a) == true);
+		TEST_CHECK(a == "test.atom.a");
+		TEST_CHECK(FindAtom("", a) == true);
+		TEST_CHECK(a.empty());
+	}
+
+	{
+		std::map<atom, int> map;
+		for (int i = 0; i < 10000; ++i) // grow the table
+			map[fmt::format("test.atom.{}", i)] = i;
+
+		TEST_CHECK(map.size() == 10000);
+		TEST_CHECK(map[atom("test.atom.1234")] == 1234);
+		TEST_CHECK(map.find(std::string("test.atom.9999"))->second == 9999);
+
+		atom a;
+		TEST_CHECK(FindAtom("test.atom.5000", a) == true);
+		TEST_CHECK(map[a] == 5000);
+	}
+}
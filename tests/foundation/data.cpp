@@ -5,6 +5,7 @@
 
 #include "foundation/cext.h"
 
+#include "foundation/allocator.h"
 #include "foundation/data.h"
 
 #include "foundation/file.h"
@@ -186,6 +187,8 @@ void test_data() {
 		std::copy(hg::test::LoremIpsum.begin(), hg::test::LoremIpsum.end(), data);
 
 		TEST_CHECK(g_alloc_sentinel == 1);
+
+		const MemoryStats data_stats = GetMemoryStats(MT_Data);
 		{
 			Data d0(data, size);
 			TEST_CHECK(d0.Empty() == false);
@@ -202,7 +205,9 @@ void test_data() {
 			TEST_CHECK(d0.GetCapacity() == 0);
 
 			d0.TakeOwnership();
-			TEST_CHECK(g_alloc_sentinel == 2);
+			TEST_CHECK(g_alloc_sentinel == 1);
+			TEST_CHECK(GetMemoryStats(MT_Data).live_count == data_stats.live_count + 1); // Data memory goes through the tagged allocator
+			TEST_CHECK(GetMemoryStats(MT_Data).live_size == data_stats.live_size + 8192);
 			TEST_CHECK(d0.Empty() == false);
 			TEST_CHECK(d0.GetSize() == size);
 			TEST_CHECK(d0.GetCapacity() == 8192);
@@ -214,6 +219,8 @@ void test_data() {
 			}
 		}
 		TEST_CHECK(g_alloc_sentinel == 1);
+		TEST_CHECK(GetMemoryStats(MT_Data).live_count == data_stats.live_count);
+		TEST_CHECK(GetMemoryStats(MT_Data).live_size == data_stats.live_size);
 
 		delete[] data;
 	}
@@ -255,4 +262,33 @@ void test_data() {
 		TEST_CHECK(Unlink(filename) == true);
 #endif
 	}
-}
\ No newline at end of file
+
+#if __cplusplus >= 201103L
+	{
+		Data d0;
+		TEST_CHECK(Write(d0, hg::test::LoremIpsum));
+		const uint8_t *data = d0.GetData();
+		const size_t size = d0.GetSize(), capacity = d0.GetCapacity();
+
+		const size_t alloc_count = GetMemoryStats(MT_Data).alloc_count;
+
+		Data d1(std::move(d0));
+		TEST_CHECK(d1.GetData() == data);
+		TEST_CHECK(d1.GetSize() == size);
+		TEST_CHECK(d1.GetCapacity() == capacity);
+		TEST_CHECK(d0.GetData() == nullptr);
+		TEST_CHECK(d0.Empty());
+
+		Data d2;
+		d2 = std::move(d1);
+		TEST_CHECK(d2.GetData() == data);
+		TEST_CHECK(d2.GetCapacity() == capacity);
+		TEST_CHECK(d1.GetData() == nullptr);
+
+		d2.Write("!", 1); // fits in the moved capacity
+		TEST_CHECK(d2.GetData() == data);
+
+		TEST_CHECK(GetMemoryStats(MT_Data).alloc_count == alloc_count); // nothing was copied
+	}
+#endif
+}
@@ -1,6 +1,7 @@
 // HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define TEST_NO_MAIN
 #include "acutest.h"
@@ -11,6 +12,7 @@
 
 #include "foundation/path_tools.h"
 #include "foundation/data.h"
+#include "foundation/thread.h"
 
 #include "../utils.h"
 
@@ -28,6 +30,24 @@ static const char g_dummy_data[37] = "abcdefghijklmnopqrstuvwxyz0123456789";
 	}
 }
 
+struct FileStress {
+	std::string path;
+	volatile int32_t failures;
+};
+
+static void OpenReadCloseFile(void *user) {
+	FileStress &stress = *reinterpret_cast<FileStress *>(user);
+
+	for (int i = 0; i < 500; ++i) {
+		File f = Open(stress.path);
+		char data[37];
+		if (!IsValid(f) || GetSize(f) != 37 || Read(f, data, 37) != 37 || memcmp(data, g_dummy_data, 37) != 0)
+			AtomicAdd(stress.failures, 1);
+		if (!Close(f) || IsValid(f))
+			AtomicAdd(stress.failures, 1);
+	}
+}
+
 void test_file() {
 	{
 		File f = Open("invalid.txt");
@@ -185,6 +205,12 @@ void test_file() {
 		TEST_CHECK(CopyFile(filename_0, filename_1) == true);
 		TEST_CHECK(FileToString(filename_1) == input);
 
+		TEST_CHECK(StringToFile(filename_0, "renamed") == true);
+		TEST_CHECK(RenameFile(filename_0, filename_1) == true); // replaces the destination
+		TEST_CHECK(IsFile(filename_0) == false);
+		TEST_CHECK(FileToString(filename_1) == "renamed");
+		TEST_CHECK(RenameFile(filename_0, filename_1) == false);
+
 		Unlink(filename_0);
 		Unlink(filename_1);
 	}
@@ -203,4 +229,21 @@ void test_file() {
 	TEST_CHECK(IsFile("dummy.bin"));
 
 	Unlink("dummy.bin");
+
+	{
+		// handles opened, used and closed concurrently
+		FileStress stress;
+		size_t size;
+		CreateDummyFile(stress.path, size);
+		stress.failures = 0;
+
+		Thread threads[8];
+		for (int i = 0; i < 8; ++i)
+			TEST_CHECK(threads[i].start(OpenReadCloseFile, &stress));
+		for (int i = 0; i < 8; ++i)
+			threads[i].join();
+
+		TEST_CHECK(AtomicLoad(stress.failures) == 0);
+		Unlink(stress.path);
+	}
 }
@@ -0,0 +1,102 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/cext.h"
+#include "foundation/frame_arena.h"
+
+#include <string.h>
+
+using namespace hg;
+
+void test_frame_arena() {
+	ResetFrameArena();
+
+	{
+		const FrameArenaStats stats = GetFrameArenaStats();
+		TEST_CHECK(stats.alloc_count == 0);
+		TEST_CHECK(stats.alloc_size == 0);
+		TEST_CHECK(stats.peak_size == 0);
+	}
+
+	{
+		uint8_t *a = reinterpret_cast<uint8_t *>(FrameAlloc(3, 1));
+		uint8_t *b = reinterpret_cast<uint8_t *>(FrameAlloc(64, 64));
+		TEST_CHECK(a != nullptr);
+		TEST_CHECK(b != nullptr);
+		TEST_CHECK((reinterpret_cast<uintptr_t>(b) & 63) == 0);
+		memset(b, 0xff, 64);
+
+		const FrameArenaStats stats = GetFrameArenaStats();
+		TEST_CHECK(stats.alloc_count == 2);
+		TEST_CHECK(stats.alloc_size == 67);
+		TEST_CHECK(stats.peak_size >= 67);
+		TEST_CHECK(stats.reserved_size >= stats.peak_size);
+
+		ResetFrameArena();
+		TEST_CHECK(GetFrameArenaStats().alloc_count == 0);
+		TEST_CHECK(FrameAlloc(3, 1) == a); // memory is reused after a reset
+	}
+
+	{
+		ResetFrameArena();
+
+		void *big = FrameAlloc(4 * 1024 * 1024); // larger than a block
+		TEST_CHECK(big != nullptr);
+		memset(big, 0, 4 * 1024 * 1024);
+		TEST_CHECK(GetFrameArenaStats().reserved_size >= 4 * 1024 * 1024);
+	}
+
+	{
+		ResetFrameArena();
+		void *a = FrameAlloc(16);
+
+		void *b;
+		{
+			FrameArenaScope scope;
+			b = FrameAlloc(1024);
+			TEST_CHECK(b != a);
+		}
+		TEST_CHECK(FrameAlloc(1024) == b); // allocations made in the scope were released
+
+		TEST_CHECK(GetFrameArenaStats().alloc_count == 3); // statistics are not rewound
+	}
+
+	{
+		ResetFrameArena();
+
+		{
+			FrameArenaScope scope;
+
+			frame_vector<int>::type v;
+			for (int i = 0; i < 10000; ++i)
+				v.push_back(i);
+			TEST_CHECK(v[9999] == 9999);
+
+			std::vector<bool, frame_allocator<bool> > flags(1000, false);
+			flags[999] = true;
+			TEST_CHECK(flags[999] && !flags[998]);
+		}
+
+		const FrameArenaStats stats = GetFrameArenaStats();
+		TEST_CHECK(stats.alloc_count > 0);
+		TEST_CHECK(stats.peak_size >= 10000 * sizeof(int));
+	}
+
+	{
+		TEST_CHECK(FrameAlloc(std::numeric_limits<size_t>::max()) == nullptr);
+
+		bool thrown = false;
+		try {
+			frame_allocator<int> allocator;
+			allocator.allocate(allocator.max_size() + 1);
+		} catch (const std::bad_alloc &) {
+			thrown = true;
+		}
+		TEST_CHECK(thrown);
+	}
+
+	FreeFrameArena();
+	TEST_CHECK(GetFrameArenaStats().reserved_size == 0);
+}
@@ -0,0 +1,69 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/gen_ref_map.h"
+
+using namespace hg;
+
+void test_gen_ref_map() {
+	generational_vector_list<int> list;
+	const gen_ref r0 = list.add_ref(0);
+	const gen_ref r1 = list.add_ref(1);
+	const gen_ref r2 = list.add_ref(2);
+
+	{
+		gen_ref_map<int> map;
+		TEST_CHECK(map.empty());
+		TEST_CHECK(map.find(r0) == map.end());
+		TEST_CHECK(map.find(invalid_gen_ref) == map.end());
+		TEST_CHECK(map.count(invalid_gen_ref) == 0);
+
+		map[r0] = 10;
+		map[r2] = 12;
+		TEST_CHECK(map.size() == 2);
+		TEST_CHECK(map.count(r0) == 1);
+		TEST_CHECK(map.count(r1) == 0);
+		TEST_CHECK(map.find(r2)->first == r2);
+		TEST_CHECK(map.find(r2)->second == 12);
+
+		map[r1] = 11;
+		TEST_CHECK(map.erase(r0) == 1); // last entry moved in place of the erased one
+		TEST_CHECK(map.erase(r0) == 0);
+		TEST_CHECK(map.size() == 2);
+		TEST_CHECK(map.find(r0) == map.end());
+		TEST_CHECK(map[r1] == 11);
+		TEST_CHECK(map[r2] == 12);
+
+		int sum = 0;
+		for (gen_ref_map<int>::const_iterator i = map.begin(); i != map.end(); ++i)
+			sum += i->second;
+		TEST_CHECK(sum == 23);
+
+		map.erase(map.find(r2));
+		TEST_CHECK(map.size() == 1);
+		TEST_CHECK(map.begin()->first == r1);
+
+		map.clear();
+		TEST_CHECK(map.empty());
+		TEST_CHECK(map.find(r1) == map.end());
+	}
+
+	{
+		gen_ref_map<int> map;
+		map[r1] = 1;
+
+		list.remove_ref(r1);
+		const gen_ref r3 = list.add_ref(3); // recycles the index of r1
+		TEST_CHECK(r3.idx == r1.idx);
+
+		TEST_CHECK(map.find(r3) == map.end()); // other generation
+		TEST_CHECK(map.count(r1) == 1);
+
+		map[r3] = 3; // replaces the entry of the previous generation
+		TEST_CHECK(map.size() == 1);
+		TEST_CHECK(map.find(r1) == map.end());
+		TEST_CHECK(map[r3] == 3);
+	}
+}
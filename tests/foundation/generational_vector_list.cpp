@@ -6,6 +6,8 @@
 
 #include "foundation/generational_vector_list.h"
 
+#include "../utils.h"
+
 using namespace hg;
 
 void test_generational_vector_list() {
@@ -105,4 +107,22 @@ void test_generational_vector_list() {
 		TEST_CHECK(container.is_valid(r1) == false);
 		TEST_CHECK(container.is_valid(r0) == false);
 	}
-}
\ No newline at end of file
+
+#if __cplusplus >= 201103L
+	{
+		test::CopyCounter::Reset();
+
+		generational_vector_list<test::CopyCounter> container;
+		const gen_ref r0 = container.add_ref(test::CopyCounter(1));
+		TEST_CHECK(container.is_valid(r0));
+		TEST_CHECK(container[r0.idx].v == 1);
+
+		generational_vector_list<test::CopyCounter, packed_vector_list<test::CopyCounter> > packed;
+		const gen_ref r1 = packed.add_ref(test::CopyCounter(2));
+		TEST_CHECK(packed.is_valid(r1));
+		TEST_CHECK(packed[r1.idx].v == 2);
+
+		TEST_CHECK(test::CopyCounter::copies == 0);
+	}
+#endif
+}
@@ -0,0 +1,283 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/job.h"
+#include "foundation/thread.h"
+
+#include <vector>
+
+using namespace hg;
+
+static void Increment(void *user) { AtomicAdd(*reinterpret_cast<volatile int32_t *>(user), 1); }
+
+//
+struct Spawner {
+	JobCounter *counter;
+	volatile int32_t *count;
+	int depth;
+};
+
+static void SpawnJobs(void *user) {
+	const Spawner &s = *reinterpret_cast<const Spawner *>(user);
+	AtomicAdd(*s.count, 1);
+
+	if (s.depth == 0)
+		return;
+
+	Spawner child = s;
+	--child.depth;
+	std::vector<Spawner> children(4, child);
+
+	JobCounter counter;
+	for (int i = 0; i < 4; ++i)
+		RunJob(SpawnJobs, &children[i], &counter);
+	WaitJobCounter(counter); // waiting from a worker runs jobs instead of blocking it
+}
+
+static int32_t SpawnedJobCount(int depth) { return depth == 0 ? 1 : 1 + 4 * SpawnedJobCount(depth - 1); }
+
+//
+struct Stage {
+	volatile int32_t *done; // completed stages
+	int32_t index;
+	volatile int32_t ok;
+};
+
+static void RunStage(void *user) {
+	Stage &stage = *reinterpret_cast<Stage *>(user);
+	stage.ok = AtomicLoad(*stage.done) == stage.index; // previous stage must have completed
+	AtomicAdd(*stage.done, 1);
+}
+
+//
+struct RangeVisit {
+	std::vector<int32_t> hits;
+	volatile int32_t calls;
+	size_t max_range;
+	Mutex lock;
+};
+
+static void VisitRange(size_t begin, size_t end, void *user) {
+	RangeVisit &visit = *reinterpret_cast<RangeVisit *>(user);
+
+	for (size_t i = begin; i < end; ++i)
+		AtomicAdd(visit.hits[i], 1);
+
+	AtomicAdd(visit.calls, 1);
+
+	ScopedLock lock(visit.lock);
+	if (end - begin > visit.max_range)
+		visit.max_range = end - begin;
+}
+
+static bool VisitAll(size_t size, size_t grain, int32_t &calls, size_t &max_range) {
+	RangeVisit visit;
+	visit.hits.resize(size + 2, 0);
+	visit.calls = 0;
+	visit.max_range = 0;
+
+	ParallelFor(1, size + 1, grain, VisitRange, &visit);
+
+	calls = visit.calls;
+	max_range = visit.max_range;
+
+	if (visit.hits[0] != 0 || visit.hits[size + 1] != 0)
+		return false;
+	for (size_t i = 1; i <= size; ++i)
+		if (visit.hits[i] != 1)
+			return false;
+	return true;
+}
+
+//
+struct Producer {
+	volatile int32_t count;
+	bool ok;
+};
+
+static const int producer_job_count = 2000;
+
+static void Produce(void *user) {
+	Producer &p = *reinterpret_cast<Producer *>(user);
+
+	volatile int32_t local = 0;
+	JobCounter counter;
+	for (int i = 0; i < producer_job_count; ++i) {
+		RunJob(Increment, const_cast<int32_t *>(&local), &counter);
+		if ((i & 15) == 0)
+			RunJob(Increment, const_cast<int32_t *>(&p.count), &counter);
+	}
+	WaitJobCounter(counter);
+
+	p.ok = AtomicLoad(local) == producer_job_count;
+}
+
+//
+static void test_inline() {
+	TEST_CHECK(GetJobWorkerCount() == 0);
+	TEST_CHECK(StartJobSystem(0));
+	TEST_CHECK(GetJobWorkerCount() == 0);
+
+	volatile int32_t count = 0;
+	{
+		JobCounter counter;
+		RunJob(Increment, const_cast<int32_t *>(&count), &counter);
+		TEST_CHECK(AtomicLoad(count) == 1); // ran on the calling thread
+		TEST_CHECK(counter.is_done());
+
+		RunJob(Increment, const_cast<int32_t *>(&count), nullptr, &counter);
+		TEST_CHECK(AtomicLoad(count) == 2);
+	}
+
+	int32_t calls;
+	size_t max_range;
+	TEST_CHECK(VisitAll(1000, 10, calls, max_range));
+	TEST_CHECK(calls == 1); // whole range in a single call
+	TEST_CHECK(max_range == 1000);
+
+	StopJobSystem();
+}
+
+static void test_workers(size_t worker_count) {
+	TEST_CHECK(StartJobSystem(worker_count));
+	TEST_CHECK(!StartJobSystem(worker_count)); // already started
+	TEST_CHECK(GetJobWorkerCount() == worker_count);
+	TEST_CHECK(!IsJobWorkerThread());
+
+	{
+		volatile int32_t count = 0;
+		JobCounter counter;
+		for (int i = 0; i < 10000; ++i)
+			RunJob(Increment, const_cast<int32_t *>(&count), &counter);
+		WaitJobCounter(counter);
+		TEST_CHECK(counter.is_done());
+		TEST_CHECK(AtomicLoad(count) == 10000);
+	}
+
+	{
+		volatile int32_t count = 0;
+		Spawner root = {nullptr, &count, 5};
+		JobCounter counter;
+		RunJob(SpawnJobs, &root, &counter);
+		WaitJobCounter(counter);
+		TEST_CHECK(AtomicLoad(count) == SpawnedJobCount(5));
+	}
+
+	{
+		// chain of stages, each depending on the previous one
+		const int stage_count = 64;
+		volatile int32_t done = 0;
+
+		std::vector<Stage> stages(stage_count);
+		std::vector<JobCounter *> counters(stage_count);
+
+		for (int i = 0; i < stage_count; ++i) {
+			stages[i].done = &done;
+			stages[i].index = i;
+			stages[i].ok = 0;
+			counters[i] = new JobCounter;
+			RunJob(RunStage, &stages[i], counters[i], i ? counters[i - 1] : nullptr);
+		}
+
+		WaitJobCounter(*counters[stage_count - 1]);
+		TEST_CHECK(AtomicLoad(done) == stage_count);
+
+		bool ok = true;
+		for (int i = 0; i < stage_count; ++i) {
+			ok = ok && stages[i].ok;
+			delete counters[i];
+		}
+		TEST_CHECK(ok);
+	}
+
+	{
+		// fan-in: several jobs gating a single dependent
+		volatile int32_t count = 0;
+		JobCounter first, second;
+		for (int i = 0; i < 100; ++i)
+			RunJob(Increment, const_cast<int32_t *>(&count), &first);
+
+		Stage stage;
+		volatile int32_t done = 100;
+		stage.done = &done;
+		stage.index = 100;
+		stage.ok = 0;
+
+		RunJob(RunStage, &stage, &second, &first);
+		WaitJobCounter(second);
+		TEST_CHECK(AtomicLoad(count) == 100);
+		TEST_CHECK(first.is_done());
+		TEST_CHECK(stage.ok);
+	}
+
+	{
+		int32_t calls;
+		size_t max_range;
+
+		TEST_CHECK(VisitAll(100000, 1, calls, max_range));
+		TEST_CHECK(calls == 100000);
+		TEST_CHECK(max_range == 1);
+
+		TEST_CHECK(VisitAll(100000, 7, calls, max_range));
+		TEST_CHECK(calls == (100000 + 6) / 7);
+		TEST_CHECK(max_range == 7);
+
+		TEST_CHECK(VisitAll(100000, 0, calls, max_range));
+		TEST_CHECK(calls > 1);
+
+		TEST_CHECK(VisitAll(3, 100, calls, max_range));
+		TEST_CHECK(calls == 1);
+
+		TEST_CHECK(VisitAll(0, 1, calls, max_range));
+		TEST_CHECK(calls == 0);
+	}
+
+	{
+		// several threads queuing and waiting concurrently
+		const int producer_count = 6;
+
+		Producer producers[producer_count];
+		Thread threads[producer_count];
+
+		for (int i = 0; i < producer_count; ++i) {
+			producers[i].count = 0;
+			producers[i].ok = false;
+			TEST_CHECK(threads[i].start(Produce, &producers[i]));
+		}
+
+		for (int i = 0; i < producer_count; ++i) {
+			threads[i].join();
+			TEST_CHECK(producers[i].ok);
+			TEST_CHECK(AtomicLoad(producers[i].count) == (producer_job_count + 15) / 16);
+		}
+	}
+
+	{
+		// jobs left in flight are run before the system stops
+		volatile int32_t count = 0;
+		for (int i = 0; i < 1000; ++i)
+			RunJob(Increment, const_cast<int32_t *>(&count));
+
+		StopJobSystem();
+		TEST_CHECK(AtomicLoad(count) == 1000);
+	}
+
+	TEST_CHECK(GetJobWorkerCount() == 0);
+}
+
+void test_job() {
+	TEST_CHECK(GetDefaultJobWorkerCount() >= 1);
+
+	test_inline();
+
+	test_workers(1);
+	test_workers(4);
+	test_workers(GetDefaultJobWorkerCount());
+
+	for (int i = 0; i < 20; ++i) { // start/stop cycles
+		TEST_CHECK(StartJobSystem(3));
+		StopJobSystem();
+	}
+}
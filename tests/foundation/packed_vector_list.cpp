@@ -0,0 +1,106 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <string>
+
+#include "foundation/cext.h"
+#include "foundation/generational_vector_list.h"
+#include "foundation/packed_vector_list.h"
+
+#include "../utils.h"
+
+using namespace hg;
+
+void test_packed_vector_list() {
+	{
+		packed_vector_list<std::string> list;
+		TEST_CHECK(list.size() == 0);
+		TEST_CHECK(list.first() == packed_vector_list<std::string>::invalid_idx);
+		TEST_CHECK(list.begin() == list.end());
+
+		TEST_CHECK(list.add("a") == 0);
+		TEST_CHECK(list.add("b") == 1);
+		TEST_CHECK(list.add("c") == 2);
+		TEST_CHECK(list.add("d") == 3);
+		TEST_CHECK(list.size() == 4);
+		TEST_CHECK(list.capacity() >= 4);
+
+		TEST_CHECK(list.first() == 0);
+		TEST_CHECK(list.next(0) == 1);
+		TEST_CHECK(list.next(3) == packed_vector_list<std::string>::invalid_idx);
+
+		TEST_CHECK(list.remove(1) == 3); // last entry moved in place of the removed one
+		TEST_CHECK(list.size() == 3);
+		TEST_CHECK(list.is_used(1) == false);
+		TEST_CHECK(list[3] == "d");
+		TEST_CHECK(list.next(0) == 3);
+		TEST_CHECK(list.next(3) == 2);
+
+		list.erase(2);
+		TEST_CHECK(list.remove(3) == packed_vector_list<std::string>::invalid_idx);
+		TEST_CHECK(list.size() == 1);
+		TEST_CHECK(list[0] == "a");
+
+		TEST_CHECK(list.add("e") == 3); // indexes are recycled
+		TEST_CHECK(list.value(3) == "e");
+
+		std::string concat;
+		const packed_vector_list<std::string> &const_list = list;
+		for (packed_vector_list<std::string>::const_iterator i = const_list.begin(); i != const_list.end(); ++i)
+			concat += *i;
+		TEST_CHECK(concat == "ae");
+
+		packed_vector_list<std::string>::iterator i = list.begin();
+		++i;
+		TEST_CHECK(i.idx() == 3);
+		TEST_CHECK(i->size() == 1);
+
+		// remove while iterating
+		for (uint32_t j = 0; j < 100; ++j)
+			list.add("x");
+		for (uint32_t j = list.first(); j != packed_vector_list<std::string>::invalid_idx;)
+			j = list[j] == "x" ? list.remove(j) : list.next(j);
+		TEST_CHECK(list.size() == 2);
+
+		list.compact();
+		list.clear();
+		TEST_CHECK(list.size() == 0);
+		TEST_CHECK(list.is_used(0) == false);
+	}
+	{
+		generational_vector_list<int, packed_vector_list<int> > list;
+		const gen_ref r0 = list.add_ref(0);
+		const gen_ref r1 = list.add_ref(1);
+		list.remove_ref(r0);
+		const gen_ref r2 = list.add_ref(2);
+
+		TEST_CHECK(r2.idx == r0.idx);
+		TEST_CHECK(list.is_valid(r0) == false);
+		TEST_CHECK(list.is_valid(r1));
+		TEST_CHECK(list.is_valid(r2));
+		TEST_CHECK(list[r2.idx] == 2);
+
+		int sum = 0;
+		for (gen_ref ref = list.first_ref(); ref != invalid_gen_ref; ref = list.next_ref(ref))
+			sum += list[ref.idx];
+		TEST_CHECK(sum == 3);
+	}
+
+#if __cplusplus >= 201103L
+	{
+		test::CopyCounter::Reset();
+
+		packed_vector_list<test::CopyCounter> list;
+		list.reserve(16);
+		for (int i = 0; i < 16; ++i)
+			list.add(test::CopyCounter(i));
+		list.erase(0); // last entry is moved in place of the erased one
+		TEST_CHECK(list[15].v == 15);
+
+		TEST_CHECK(test::CopyCounter::copies == 0);
+		TEST_CHECK(test::CopyCounter::moves == 17);
+	}
+#endif
+}
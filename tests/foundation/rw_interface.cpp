@@ -315,7 +315,7 @@ static size_t DummyWriterTell(Handle h) {
 }
 static bool DummyWriterIsValid(Handle h) { 
 	if (bool_gate(g_next_op_will_fail)) {
-		return nullptr;
+		return false;
 	}
 	Data *buffer = *(reinterpret_cast<Data **>(&h.v[0]));
 	return (buffer != nullptr);
@@ -0,0 +1,99 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "foundation/thread.h"
+
+using namespace hg;
+
+static const int thread_test_count = 8, thread_test_iterations = 20000;
+
+struct SharedCounters {
+	Mutex lock;
+	int locked; // protected by lock
+	volatile int32_t atomic;
+};
+
+static void IncrementCounters(void *user) {
+	SharedCounters &counters = *reinterpret_cast<SharedCounters *>(user);
+
+	for (int i = 0; i < thread_test_iterations; ++i) {
+		{
+			ScopedLock lock(counters.lock);
+			++counters.locked;
+		}
+		AtomicAdd(counters.atomic, 1);
+	}
+}
+
+struct Handshake {
+	Mutex lock;
+	ConditionVariable cond;
+	bool ready, acknowledged;
+};
+
+static void AcknowledgeHandshake(void *user) {
+	Handshake &h = *reinterpret_cast<Handshake *>(user);
+
+	ScopedLock lock(h.lock);
+	while (!h.ready)
+		h.cond.wait(h.lock);
+	h.acknowledged = true;
+	h.cond.notify_all();
+}
+
+void test_thread() {
+	TEST_CHECK(GetHardwareThreadCount() >= 1);
+
+	{
+		volatile int32_t v = 5;
+		TEST_CHECK(AtomicAdd(v, 3) == 8);
+		TEST_CHECK(AtomicAdd(v, -8) == 0);
+		TEST_CHECK(AtomicCompareExchange(v, 0, 4));
+		TEST_CHECK(!AtomicCompareExchange(v, 0, 7));
+		TEST_CHECK(AtomicLoad(v) == 4);
+	}
+
+	{
+		Mutex m;
+		TEST_CHECK(m.try_lock());
+		m.unlock();
+	}
+
+	{
+		SharedCounters counters;
+		counters.locked = 0;
+		counters.atomic = 0;
+
+		Thread threads[thread_test_count];
+		for (int i = 0; i < thread_test_count; ++i)
+			TEST_CHECK(threads[i].start(IncrementCounters, &counters));
+		for (int i = 0; i < thread_test_count; ++i) {
+			TEST_CHECK(threads[i].is_running());
+			threads[i].join();
+			TEST_CHECK(!threads[i].is_running());
+		}
+
+		TEST_CHECK(counters.locked == thread_test_count * thread_test_iterations);
+		TEST_CHECK(AtomicLoad(counters.atomic) == thread_test_count * thread_test_iterations);
+	}
+
+	{
+		Handshake h;
+		h.ready = h.acknowledged = false;
+
+		Thread thread;
+		TEST_CHECK(thread.start(AcknowledgeHandshake, &h));
+
+		{
+			ScopedLock lock(h.lock);
+			h.ready = true;
+			h.cond.notify_all();
+			while (!h.acknowledged)
+				h.cond.wait(h.lock);
+		}
+
+		TEST_CHECK(h.acknowledged);
+	} // thread joined on destruction
+}
@@ -3,12 +3,15 @@
 #define TEST_NO_MAIN
 #include "acutest.h"
 
+#include <string>
 #include <vector>
 
 #include "foundation/cext.h"
 #include "foundation/vector_list.h"
 #include "foundation/vector3.h"
 
+#include "../utils.h"
+
 using namespace hg;
 
 void test_vector_list() {
@@ -180,4 +183,87 @@ void test_vector_list() {
 
 		list.compact(); // [todo] there's no way to test this.
 	}
-}
\ No newline at end of file
+	{
+		// long free runs
+		vector_list<int> list;
+		list.reserve(1000);
+		for (int i = 0; i < 1000; ++i)
+			TEST_CHECK(list.add(i) == uint32_t(i));
+
+		for (uint32_t i = 0; i < 990; ++i)
+			list.erase(i);
+		TEST_CHECK(list.size() == 10);
+		TEST_CHECK(list.first() == 990);
+
+		for (uint32_t i = 999; i > 991; --i)
+			list.erase(i);
+		TEST_CHECK(list.next(990) == 991);
+		TEST_CHECK(list.next(991) == vector_list<int>::invalid_idx);
+
+		list.reserve(2000);
+		TEST_CHECK(list.next(991) == vector_list<int>::invalid_idx);
+
+		int sum = 0;
+		for (vector_list<int>::iterator it = list.begin(); it != list.end(); ++it)
+			sum += *it;
+		TEST_CHECK(sum == 990 + 991);
+	}
+	{
+		// entries never move
+		vector_list<std::string> list;
+		const uint32_t i = list.add("first");
+		const std::string *p = &list[i];
+
+		for (int j = 0; j < 10000; ++j)
+			list.add(list[i]); // adding an entry of the container itself is safe
+
+		TEST_CHECK(&list[i] == p);
+		TEST_CHECK(list[list.size() - 1] == "first");
+
+		for (uint32_t j = 1; j < 10000; ++j)
+			list.erase(j);
+		list.compact(); // release unused chunks
+
+		TEST_CHECK(&list[i] == p);
+		TEST_CHECK(list.size() == 2);
+		TEST_CHECK(list.next(i) == 10000);
+
+		TEST_CHECK(list.add("second") == 9999);
+		TEST_CHECK(list[9999] == "second");
+
+		// copy
+		vector_list<std::string> copy(list);
+		TEST_CHECK(copy.size() == 3);
+		TEST_CHECK(copy[i] == "first");
+		TEST_CHECK(&copy[i] != p);
+		TEST_CHECK(copy[9999] == "second");
+		TEST_CHECK(copy.add("third") == list.add("third"));
+	}
+
+#if __cplusplus >= 201103L
+	{
+		test::CopyCounter::Reset();
+
+		vector_list<test::CopyCounter> list;
+		for (int i = 0; i < 1000; ++i)
+			list.add(test::CopyCounter(i));
+		TEST_CHECK(test::CopyCounter::copies == 0);
+		TEST_CHECK(test::CopyCounter::moves == 1000);
+
+		const test::CopyCounter *p = &list[500];
+
+		vector_list<test::CopyCounter> moved(std::move(list)); // chunks are handed over
+		TEST_CHECK(list.size() == 0);
+		TEST_CHECK(moved.size() == 1000);
+		TEST_CHECK(&moved[500] == p);
+
+		list = std::move(moved);
+		TEST_CHECK(moved.size() == 0);
+		TEST_CHECK(&list[500] == p);
+		TEST_CHECK(list[500].v == 500);
+
+		TEST_CHECK(test::CopyCounter::copies == 0);
+		TEST_CHECK(test::CopyCounter::moves == 1000);
+	}
+#endif
+}
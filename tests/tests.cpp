@@ -8,6 +8,11 @@ extern void test_math();
 extern void test_rand();
 extern void test_units();
 extern void test_string();
+extern void test_atom();
+extern void test_allocator();
+extern void test_frame_arena();
+extern void test_thread();
+extern void test_job();
 extern void test_path_tools();
 extern void test_log();
 extern void test_vec2();
@@ -26,6 +31,8 @@ extern void test_quaternion();
 extern void test_frustum();
 extern void test_vector_list();
 extern void test_generational_vector_list();
+extern void test_gen_ref_map();
+extern void test_packed_vector_list();
 extern void test_intrusive_shared_ptr_st();
 extern void test_file();
 extern void test_dir();
@@ -41,6 +48,11 @@ extern void test_anim();
 extern void test_node();
 extern void test_picture();
 extern void test_resource_cache();
+extern void test_load_dds();
+extern void test_assets();
+extern void test_asset_pack();
+extern void test_load_queue();
+extern void test_json();
 extern void test_scene();
 
 //
@@ -51,6 +63,8 @@ TEST_LIST = {
 	{"foundation.rand", test_rand},
 	{"foundation.units", test_units},
 	{"foundation.string", test_string},
+	{"foundation.atom", test_atom},
+	{"foundation.allocator", test_allocator},
 	{"foundation.path_tools", test_path_tools},
 	{"foundation.log", test_log},
 	{"foundation.vec2", test_vec2},
@@ -69,10 +83,15 @@ TEST_LIST = {
 	{"foundation.frustum", test_frustum},
 	{"foundation.vector_list", test_vector_list},
 	{"foundation.generational_vector_list", test_generational_vector_list},
+	{"foundation.gen_ref_map", test_gen_ref_map},
+	{"foundation.packed_vector_list", test_packed_vector_list},
 	{"foundation.intrusive_shared_ptr_st", test_intrusive_shared_ptr_st},
 	{"foundation.file", test_file},
 	{"foundation.dir", test_dir},
 	{"foundation.data", test_data},
+	{"foundation.frame_arena", test_frame_arena},
+	{"foundation.thread", test_thread},
+	{"foundation.job", test_job},
 	{"foundation.rw_interface", test_rw_interface}, 
 	{"foundation.data_rw_interface", test_data_rw_interface},
 	{"foundation.file_rw_interface", test_file_rw_interface},
@@ -83,6 +102,11 @@ TEST_LIST = {
 	{"engine.node", test_node},
 	{"engine.picture", test_picture},
 	{"engine.resource_cache", test_resource_cache},
+	{"engine.load_dds", test_load_dds},
+	{"engine.assets", test_assets},
+	{"engine.asset_pack", test_asset_pack},
+	{"engine.load_queue", test_load_queue},
+	{"engine.json", test_json},
 	{"engine.scene", test_scene},
 	 
 	{NULL, NULL},
@@ -11,6 +11,9 @@
 namespace hg {
 namespace test {
 
+int CopyCounter::copies = 0;
+int CopyCounter::moves = 0;
+
 const std::string LoremIpsum("Lorem ipsum dolor sit amet, consectetur adipiscing elit. Vestibulum non\n"
 							 "gravida sapien, quis luctus magna. Nullam ut nunc in lacus pretium luctus at\n"
 							 "nec nibh. Praesent fermentum vehicula pretium. Cras in magna non diam sagittis\n"
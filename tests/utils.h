@@ -13,5 +13,30 @@ std::string GetTempDirectoryName();
 
 std::string CreateTempFilepath();
 
+/// Value counting how many times it is copied or moved.
+struct CopyCounter {
+	CopyCounter() : v(0) {}
+	explicit CopyCounter(int v_) : v(v_) {}
+	CopyCounter(const CopyCounter &c) : v(c.v) { ++copies; }
+	CopyCounter &operator=(const CopyCounter &c) {
+		v = c.v;
+		++copies;
+		return *this;
+	}
+#if __cplusplus >= 201103L
+	CopyCounter(CopyCounter &&c) : v(c.v) { ++moves; }
+	CopyCounter &operator=(CopyCounter &&c) {
+		v = c.v;
+		++moves;
+		return *this;
+	}
+#endif
+
+	int v;
+
+	static int copies, moves;
+	static void Reset() { copies = moves = 0; }
+};
+
 } // namespace test
 } // namespace hg
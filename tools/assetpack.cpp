@@ -0,0 +1,90 @@
+// HARFANG(R) Copyright (C) 2022 NWNC. Released under GPL/LGPL/Commercial Licence, see licence.txt for details.
+
+#include <fmt/format.h>
+
+#include "foundation/dir.h"
+#include "foundation/path_tools.h"
+
+#include "engine/asset_pack.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace hg;
+
+static int Usage() {
+	std::cerr << "usage: assetpack [-z] [-a <alignment>] <output pack> <input folder>\n"
+				 "       assetpack -l <pack>\n"
+				 "\n"
+				 "  -z  deflate entries when it saves space\n"
+				 "  -a  entry alignment in bytes, power of 2 (default: 16)\n"
+				 "  -l  list the entries of a pack\n";
+	return 1;
+}
+
+static int List(const std::string &path) {
+	AssetPack pack;
+	if (!OpenAssetPack(path, pack)) {
+		std::cerr << fmt::format("Failed to open asset pack '{}'\n", path);
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < pack.entry_count; ++i) {
+		const AssetPackEntry &e = pack.entries[i];
+		std::cout << fmt::format("{:>12} {:>12} {:>6} {:>12} {}\n", e.uncompressed_size, e.size, e.compression == APC_Deflate ? "deflate" : "stored",
+			e.offset, GetAssetPackEntryName(pack, e));
+	}
+
+	CloseAssetPack(pack);
+	return 0;
+}
+
+int main(int narg, const char **args) {
+	AssetPackCompression compression = APC_None;
+	uint32_t alignment = 16;
+
+	int i = 1;
+	for (; i < narg && args[i][0] == '-'; ++i) {
+		if (!strcmp(args[i], "-z")) {
+			compression = APC_Deflate;
+		} else if (!strcmp(args[i], "-a") && i + 1 < narg) {
+			alignment = uint32_t(strtoul(args[++i], nullptr, 10));
+			if (!alignment || (alignment & (alignment - 1)))
+				return Usage();
+		} else if (!strcmp(args[i], "-l") && i + 1 < narg) {
+			return List(args[i + 1]);
+		} else {
+			return Usage();
+		}
+	}
+
+	if (narg - i != 2)
+		return Usage();
+
+	const std::string output = args[i], folder = args[i + 1];
+
+	if (!IsDir(folder)) {
+		std::cerr << fmt::format("Input folder '{}' does not exist\n", folder);
+		return 1;
+	}
+
+	const std::vector<DirEntry> files = ListDirRecursive(folder, DE_File);
+
+	std::vector<AssetPackInput> inputs(files.size());
+	for (size_t j = 0; j < files.size(); ++j) {
+		inputs[j].name = files[j].name;
+		inputs[j].path = PathJoin(folder, files[j].name);
+		inputs[j].compression = compression;
+		inputs[j].alignment = alignment;
+	}
+
+	if (!WriteAssetPack(output, inputs)) {
+		std::cerr << fmt::format("Failed to write asset pack '{}'\n", output);
+		return 1;
+	}
+
+	std::cout << fmt::format("Packed {} files to '{}'\n", inputs.size(), output);
+	return 0;
+}